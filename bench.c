@@ -2,15 +2,77 @@
 #include "ffts/include/ffts.h"
 
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#define HAVE_HUGEPAGE_ALLOCATOR
+#endif
+
 BEGIN_BENCH_DOC
 BENCH_DOC("name", "ffts")
 BENCH_DOC("version", "v0.9")
 BENCH_DOC("year", "2016")
 END_BENCH_DOC 
 
+/* storage formats of the input and output of the half precision plans
+   of -ohalf-in and -ohalf-out, FFTS_FLOAT for float */
+static int half_in, half_out;
+
+/* FFTS_INT16 or FFTS_INT8 input of the integer plans of -oint-in,
+   FFTS_FLOAT for float, and whether -oint-in-pass times a separate
+   scalar conversion followed by a float plan instead */
+static int int_in, int_in_pass;
+
+/* plan of a half precision or integer problem and its arrays of 16 or
+   8 bit values, converted from and to the float arrays of the problem as
+   verification copies them, so that -a measures the error of the storage
+   format; buf holds the floats converted by -oint-in-pass */
+typedef struct format_problem {
+    ffts_plan_t *plan;
+    void *in, *out;
+    size_t in_size, out_size;
+    float *buf;
+} format_problem;
+
+/* whether p->userinfo is a format_problem */
+static int
+format_converted(void)
+{
+    return half_in || half_out || int_in;
+}
+
+/* integers of -oint-in are the float values of the problem times this */
+static float
+int_in_factor(void)
+{
+    return int_in == FFTS_INT8 ? 32.0f : 16384.0f;
+}
+
+/* taps per channel of the channelizers planned for complex 1D problems
+   by -ochannelizer, 0 for none, and their mode */
+static size_t channelizer_taps;
+static int channelizer_flags;
+
+/* bins of the sliding DFTs planned for complex 1D problems by -osdft,
+   0 for none, and samples per hop given by -osdft-hop, which also make
+   plain FFTs report samples/s as if recomputed every hop */
+static size_t sdft_bins;
+static size_t sdft_hop;
+
+/* whether setup() plans p as a channelizer or a sliding DFT, whose
+   results are not DFTs */
+static int
+stream_problem(const bench_problem *p)
+{
+    return p->kind == PROBLEM_COMPLEX && p->sz->rnk == 1 &&
+        !p->file_backed && !format_converted() &&
+        (channelizer_taps || sdft_bins);
+}
+
 int
 can_do(bench_problem *p)
 {
@@ -18,7 +80,8 @@ can_do(bench_problem *p)
     int i;
 
     if (p->kind != PROBLEM_COMPLEX &&
-        p->kind != PROBLEM_REAL) {
+        p->kind != PROBLEM_REAL &&
+        p->kind != PROBLEM_R2R) {
             return 0;
     }
 
@@ -26,6 +89,56 @@ can_do(bench_problem *p)
         return 0;
     }
 
+    /* DCT-II/III and DST-II/III of the same kind along every dimension,
+       and 1D DHT */
+    if (p->kind == PROBLEM_R2R) {
+        for (i = 0; i < sz->rnk; ++i) {
+            if (p->k[i] != p->k[0] || sz->dims[i].n < 4) {
+                return 0;
+            }
+        }
+
+        if (p->k[0] == R2R_DHT) {
+            if (sz->rnk != 1) {
+                return 0;
+            }
+        } else if (p->k[0] != R2R_REDFT10 && p->k[0] != R2R_REDFT01 &&
+                   p->k[0] != R2R_RODFT10 && p->k[0] != R2R_RODFT01) {
+            return 0;
+        }
+    }
+
+    /* multidimensional real plans have no padded in-place layout */
+    if (p->kind == PROBLEM_REAL && sz->rnk > 1 && p->in_place) {
+        return 0;
+    }
+
+    /* file-backed arrays are transformed by out-of-core plans */
+    if (p->file_backed && (p->kind != PROBLEM_COMPLEX || sz->rnk != 1 ||
+        p->in_place || sz->dims[0].n < 64)) {
+        return 0;
+    }
+
+    /* channelizers and sliding DFTs take one stream out of place, and
+       have no direction */
+    if (stream_problem(p) && (p->vecsz->rnk > 0 || p->in_place ||
+        p->sign > 0)) {
+        return 0;
+    }
+
+    /* half precision and integer plans are 1D, of one transform, out of
+       place, and real integer plans forward */
+    if (format_converted() && (p->kind == PROBLEM_R2R ||
+        sz->rnk != 1 || p->vecsz->rnk > 0 || p->in_place ||
+        p->file_backed)) {
+        return 0;
+    }
+
+    if (int_in && ((half_in || half_out) ||
+        (p->kind == PROBLEM_REAL && p->sign > 0))) {
+        return 0;
+    }
+
     for (i = 0; i < sz->rnk; ++i) {
         if (!power_of_two(sz->dims[i].n)) {
             return 0;
@@ -41,6 +154,24 @@ cleanup(void)
     /* nothing to do */
 }
 
+/* the conversion pass of -oint-in-pass, as a caller would write it */
+static void
+int_convert(const void *in, float *out, size_t n)
+{
+    const float scale = 1.0f / int_in_factor();
+    size_t i;
+
+    if (int_in == FFTS_INT8) {
+        for (i = 0; i < n; ++i) {
+            out[i] = scale * ((const int8_t*) in)[i];
+        }
+    } else {
+        for (i = 0; i < n; ++i) {
+            out[i] = scale * ((const int16_t*) in)[i];
+        }
+    }
+}
+
 void
 doit(int iter, bench_problem *p)
 {
@@ -49,6 +180,22 @@ doit(int iter, bench_problem *p)
     void *out = p->out;
     int i;
 
+    if (format_converted()) {
+        format_problem *h = p->userinfo;
+
+        q = h->plan;
+        in = h->in ? h->in : in;
+        out = h->out ? h->out : out;
+
+        if (h->buf) {
+            for (i = 0; i < iter; ++i) {
+                int_convert(h->in, h->buf, h->in_size);
+                ffts_execute(q, h->buf, out);
+            }
+            return;
+        }
+    }
+
     for (i = 0; i < iter; ++i) {
         ffts_execute(q, in, out);
     }
@@ -57,11 +204,273 @@ doit(int iter, bench_problem *p)
 void
 done(bench_problem *p)
 {
-    if (p->userinfo) {
+    if (p->userinfo && format_converted()) {
+        format_problem *h = p->userinfo;
+
+        ffts_free(h->plan);
+        bench_free(h->in);
+        bench_free(h->out);
+        bench_free(h->buf);
+        bench_free(h);
+    } else if (p->userinfo) {
         ffts_free(p->userinfo);
     }
 }
 
+static void
+format_copy_from(bench_problem *p)
+{
+    format_problem *h = p->userinfo;
+
+    if (int_in && h->in) {
+        const float *in = (const float*) p->in;
+        const float factor = int_in_factor();
+        const float limit = int_in == FFTS_INT8 ? 127.0f : 32767.0f;
+        size_t i;
+
+        /* rounded to nearest and saturated */
+        for (i = 0; i < h->in_size; ++i) {
+            float v = floorf(factor * in[i] + 0.5f);
+
+            v = v > limit ? limit : (v < -limit - 1.0f ? -limit - 1.0f : v);
+            if (int_in == FFTS_INT8) {
+                ((int8_t*) h->in)[i] = (int8_t) v;
+            } else {
+                ((int16_t*) h->in)[i] = (int16_t) v;
+            }
+        }
+    } else if ((half_in || half_out) && h->in) {
+        ffts_float_to_half((const float*) p->in, h->in, h->in_size, half_in);
+    }
+}
+
+static void
+format_copy_to(bench_problem *p)
+{
+    format_problem *h = p->userinfo;
+
+    if ((half_in || half_out) && h->out) {
+        ffts_half_to_float(h->out, (float*) p->out, h->out_size, half_out);
+    }
+}
+
+/* libbench2 hooks around the transforms of verification */
+void
+after_problem_ccopy_from(bench_problem *p, bench_real *ri, bench_real *ii)
+{
+    (void) ri;
+    (void) ii;
+
+    /* -y and -a would only report the errors against a DFT */
+    if (stream_problem(p)) {
+        fprintf(stderr, "%s: channelizers and sliding DFTs do not compute "
+                "DFTs, so they cannot be verified.  Use -s.\n",
+                p->pstring ? p->pstring : "<unknown problem>");
+        bench_exit(EXIT_FAILURE);
+    }
+
+    format_copy_from(p);
+}
+
+void
+after_problem_ccopy_to(bench_problem *p, bench_real *ro, bench_real *io)
+{
+    (void) ro;
+    (void) io;
+    format_copy_to(p);
+}
+
+void
+after_problem_hccopy_from(bench_problem *p, bench_real *ri, bench_real *ii)
+{
+    (void) ri;
+    (void) ii;
+    format_copy_from(p);
+}
+
+void
+after_problem_hccopy_to(bench_problem *p, bench_real *ro, bench_real *io)
+{
+    (void) ro;
+    (void) io;
+    format_copy_to(p);
+}
+
+void
+after_problem_rcopy_from(bench_problem *p, bench_real *ri)
+{
+    (void) ri;
+    format_copy_from(p);
+}
+
+void
+after_problem_rcopy_to(bench_problem *p, bench_real *ro)
+{
+    (void) ro;
+    format_copy_to(p);
+}
+
+/* smallest transforms planned by -ootf-twiddles, 0 for none */
+static size_t otf_twiddles_min;
+
+/* work buffers of out-of-core plans, 0 for the FFTS default */
+static size_t ooc_memory;
+
+/* channelizer of N channels, with a Hann-windowed sinc of cutoff 1/(2N)
+   as prototype filter */
+static ffts_plan_t*
+init_channelizer(bench_problem *p, size_t N)
+{
+    const double pi = 3.14159265358979323846;
+    size_t M = channelizer_taps * N, m;
+    ffts_plan_t *plan;
+    float *h;
+    double t;
+
+    h = (float*) bench_malloc(M * sizeof(*h));
+    for (m = 0; m < M; ++m) {
+        t = ((double) m - 0.5 * (M - 1)) / N;
+        h[m] = (float) ((t == 0.0 ? 1.0 : sin(pi * t) / (pi * t)) *
+            (0.5 - 0.5 * cos(2.0 * pi * (m + 0.5) / M)));
+    }
+
+    plan = ffts_init_channelizer(N, h, M, channelizer_flags);
+    bench_free(h);
+
+    p->stream_samples = (double)
+        ((channelizer_flags & FFTS_CHANNELIZER_OVERSAMPLED) ? N / 2 : N);
+    return plan;
+}
+
+/* sliding DFT of a window of N samples, for bins spread evenly */
+static ffts_plan_t*
+init_sdft(bench_problem *p, size_t N)
+{
+    size_t count = sdft_bins < N ? sdft_bins : N;
+    size_t hop = sdft_hop ? (sdft_hop < N ? sdft_hop : N) : 1;
+    ffts_plan_t *plan;
+    size_t *bins, i;
+
+    bins = (size_t*) bench_malloc(count * sizeof(*bins));
+    for (i = 0; i < count; ++i) {
+        bins[i] = i * N / count;
+    }
+
+    plan = ffts_init_sdft(N, hop, bins, count, 0);
+    bench_free(bins);
+
+    p->stream_samples = (double) hop;
+    return plan;
+}
+
+/* 1D plan of half precision input and/or output, with its arrays */
+static format_problem*
+init_half(bench_problem *p, size_t N)
+{
+    format_problem *h;
+    int real = (p->kind == PROBLEM_REAL);
+
+    h = (format_problem*) bench_malloc(sizeof(*h));
+    h->plan = real ? ffts_init_1d_real_half(N, p->sign, half_in, half_out) :
+        ffts_init_1d_half(N, p->sign, half_in, half_out);
+    if (!h->plan) {
+        bench_free(h);
+        return NULL;
+    }
+
+    /* real transforms take or give N / 2 + 1 complex values */
+    if (!real) {
+        h->in_size = h->out_size = 2 * N;
+    } else if (p->sign < 0) {
+        h->in_size = N;
+        h->out_size = N + 2;
+    } else {
+        h->in_size = N + 2;
+        h->out_size = N;
+    }
+
+    h->in = h->out = NULL;
+    h->buf = NULL;
+    if (half_in) {
+        h->in = bench_malloc(h->in_size * 2);
+        memset(h->in, 0, h->in_size * 2);
+    }
+
+    if (half_out) {
+        h->out = bench_malloc(h->out_size * 2);
+        memset(h->out, 0, h->out_size * 2);
+    }
+
+    return h;
+}
+
+/* 1D plan of integer input, with its array, or with the float plan and
+   array of -oint-in-pass */
+static format_problem*
+init_int(bench_problem *p, size_t N)
+{
+    format_problem *h;
+    int real = (p->kind == PROBLEM_REAL);
+    float scale = 1.0f / int_in_factor();
+    size_t bytes;
+
+    h = (format_problem*) bench_malloc(sizeof(*h));
+    if (int_in_pass) {
+        h->plan = real ? ffts_init_1d_real(N, p->sign) :
+            ffts_init_1d(N, p->sign);
+    } else {
+        h->plan = real ? ffts_init_1d_real_int(N, int_in, scale) :
+            ffts_init_1d_int(N, p->sign, int_in, scale);
+    }
+
+    if (!h->plan) {
+        bench_free(h);
+        return NULL;
+    }
+
+    h->in_size = real ? N : 2 * N;
+    h->out_size = 0;
+    h->out = NULL;
+
+    bytes = h->in_size * (int_in == FFTS_INT8 ? 1 : 2);
+    h->in = bench_malloc(bytes);
+    memset(h->in, 0, bytes);
+
+    h->buf = NULL;
+    if (int_in_pass) {
+        h->buf = (float*) bench_malloc(h->in_size * sizeof(float));
+        memset(h->buf, 0, h->in_size * sizeof(float));
+    }
+
+    return h;
+}
+
+static int
+int_format(const char *name)
+{
+    if (!strcmp(name, "int16")) {
+        return FFTS_INT16;
+    } else if (!strcmp(name, "int8")) {
+        return FFTS_INT8;
+    }
+
+    fprintf(stderr, "unknown integer format: %s.  Ignoring.\n", name);
+    return FFTS_FLOAT;
+}
+
+static int
+half_format(const char *name)
+{
+    if (!strcmp(name, "fp16")) {
+        return FFTS_FP16;
+    } else if (!strcmp(name, "bf16")) {
+        return FFTS_BF16;
+    }
+
+    fprintf(stderr, "unknown half precision format: %s.  Ignoring.\n", name);
+    return FFTS_FLOAT;
+}
+
 static size_t*
 extract_dims(bench_tensor *sz)
 {
@@ -99,24 +508,221 @@ main_init(int *argc, char ***argv)
     (void*) (argv);
 }
 
+#ifdef HAVE_HUGEPAGE_ALLOCATOR
+#define HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+/* mappings made by hugepage_alloc, to find their length when freed */
+typedef struct hugepage_map {
+    void *addr;
+    size_t length;
+    struct hugepage_map *next;
+} hugepage_map;
+
+static hugepage_map *hugepage_maps;
+static size_t hugetlb_bytes;
+static size_t thp_bytes;
+
+/* 2 MiB aligned anonymous mapping, advised to use transparent huge pages */
+static void*
+thp_map(size_t length)
+{
+    char *addr, *aligned;
+    size_t head;
+
+    addr = (char*) mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == (char*) MAP_FAILED) {
+        return NULL;
+    }
+
+    aligned = (char*) (((size_t) addr + HUGE_PAGE_SIZE - 1) &
+                       ~(HUGE_PAGE_SIZE - 1));
+    head = aligned - addr;
+    if (head) {
+        munmap(addr, head);
+    }
+    munmap(aligned + length, HUGE_PAGE_SIZE - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+/* ffts allocator placing tables and work buffers of 2 MiB or more in
+   huge pages: reserved ones (hugetlbfs) if available, else transparent */
+static void*
+hugepage_alloc(size_t size, size_t alignment, int region, void *user)
+{
+    hugepage_map *m;
+    size_t length;
+    void *addr = NULL;
+
+    (void) alignment;
+    (void) user;
+
+    if ((region != FFTS_MEM_TABLES && region != FFTS_MEM_SCRATCH) ||
+        size < HUGE_PAGE_SIZE) {
+        return bench_malloc(size);
+    }
+
+    length = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+    addr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == MAP_FAILED) {
+        addr = NULL;
+    } else {
+        hugetlb_bytes += length;
+    }
+#endif
+
+    if (!addr) {
+        addr = thp_map(length);
+        if (!addr) {
+            return NULL;
+        }
+        thp_bytes += length;
+    }
+
+    m = (hugepage_map*) bench_malloc(sizeof(*m));
+    m->addr = addr;
+    m->length = length;
+    m->next = hugepage_maps;
+    hugepage_maps = m;
+    return addr;
+}
+
+static void
+hugepage_free(void *ptr, int region, void *user)
+{
+    hugepage_map **pm, *m;
+
+    (void) region;
+    (void) user;
+
+    for (pm = &hugepage_maps; (m = *pm) != NULL; pm = &m->next) {
+        if (m->addr == ptr) {
+            munmap(m->addr, m->length);
+            *pm = m->next;
+            bench_free(m);
+            return;
+        }
+    }
+
+    bench_free(ptr);
+}
+#endif /* HAVE_HUGEPAGE_ALLOCATOR */
+
+void
+useropt(const char *arg)
+{
+    if (!strcmp(arg, "hugepages")) {
+#ifdef HAVE_HUGEPAGE_ALLOCATOR
+        ffts_set_allocator(hugepage_alloc, hugepage_free, NULL);
+#else
+        fprintf(stderr, "huge pages are not supported here.  Ignoring.\n");
+#endif
+    } else if (!strcmp(arg, "ffts-hugepages")) {
+        ffts_set_huge_pages((size_t) 2 << 20);
+    } else if (!strcmp(arg, "compact-luts")) {
+        ffts_set_compact_luts(0);
+    } else if (!strcmp(arg, "nocompact-luts")) {
+        ffts_set_compact_luts((size_t) -1);
+    } else if (!strcmp(arg, "otf-twiddles")) {
+        otf_twiddles_min = (size_t) 1 << 16;
+    } else if (!strncmp(arg, "ooc-memory=", 11)) {
+        ooc_memory = (size_t) strtoul(arg + 11, NULL, 10);
+    } else if (!strncmp(arg, "channelizer=", 12)) {
+        channelizer_taps = (size_t) strtoul(arg + 12, NULL, 10);
+    } else if (!strcmp(arg, "channelizer-oversampled")) {
+        channelizer_flags = FFTS_CHANNELIZER_OVERSAMPLED;
+    } else if (!strncmp(arg, "sdft=", 5)) {
+        sdft_bins = (size_t) strtoul(arg + 5, NULL, 10);
+    } else if (!strncmp(arg, "sdft-hop=", 9)) {
+        sdft_hop = (size_t) strtoul(arg + 9, NULL, 10);
+    } else if (!strncmp(arg, "half-in=", 8)) {
+        half_in = half_format(arg + 8);
+    } else if (!strncmp(arg, "half-out=", 9)) {
+        half_out = half_format(arg + 9);
+    } else if (!strncmp(arg, "int-in=", 7)) {
+        int_in = int_format(arg + 7);
+    } else if (!strcmp(arg, "int-in-pass")) {
+        int_in_pass = 1;
+    } else {
+        fprintf(stderr, "unknown user option: %s.  Ignoring.\n", arg);
+    }
+}
+
+static void
+add_setup_stage(bench_problem *p, const char *name, double t)
+{
+    if (p->nsetup_stages < BENCH_MAX_SETUP_STAGES) {
+        p->setup_stage_name[p->nsetup_stages] = name;
+        p->setup_stage_time[p->nsetup_stages] = t;
+        p->nsetup_stages++;
+    }
+}
+
 void
 setup(bench_problem *p)
 {
     bench_tensor *sz = p->sz;
+    ffts_setup_stats_t stats;
+    ffts_memory_stats_t mem;
     ffts_plan_t *plan;
+    format_problem *h = NULL;
     size_t *dims;
     double tim;
+    int type, dst;
+
+    memset(&stats, 0, sizeof(stats));
+    ffts_set_setup_stats(&stats);
+    ffts_set_numa_node(bench_plan_node);
+
+    /* plans with on-the-fly twiddles run out of place only */
+    ffts_set_otf_twiddles(p->in_place ? 0 : otf_twiddles_min);
 
     timer_start(USER_TIMER);
 
     switch (p->kind)
     {
     case PROBLEM_COMPLEX:
-        if (sz->rnk == 1) {
+        if (p->file_backed) {
+            if (verbose > 2) {
+                printf("using ffts_init_1d_ooc\n");
+            }
+            plan = ffts_init_1d_ooc(sz->dims[0].n, p->sign, ooc_memory);
+        } else if (half_in || half_out) {
+            if (verbose > 2) {
+                printf("using ffts_init_1d_half\n");
+            }
+            h = init_half(p, sz->dims[0].n);
+            plan = h ? h->plan : NULL;
+        } else if (int_in) {
+            if (verbose > 2) {
+                printf("using %s\n", int_in_pass ? "ffts_init_1d" :
+                    "ffts_init_1d_int");
+            }
+            h = init_int(p, sz->dims[0].n);
+            plan = h ? h->plan : NULL;
+        } else if (sz->rnk == 1 && channelizer_taps) {
+            if (verbose > 2) {
+                printf("using ffts_init_channelizer\n");
+            }
+            plan = init_channelizer(p, sz->dims[0].n);
+        } else if (sz->rnk == 1 && sdft_bins) {
+            if (verbose > 2) {
+                printf("using ffts_init_sdft\n");
+            }
+            plan = init_sdft(p, sz->dims[0].n);
+        } else if (sz->rnk == 1) {
             if (verbose > 2) {
                 printf("using ffts_init_1d\n");
             }
             plan = ffts_init_1d(sz->dims[0].n, p->sign);
+            p->stream_samples = (double) sdft_hop;
         } else if (sz->rnk == 2) {
             if (verbose > 2) {
                 printf("using ffts_init_2d\n");
@@ -132,7 +738,20 @@ setup(bench_problem *p)
         }
         break;
     case PROBLEM_REAL:
-        if (sz->rnk == 1) {
+        if (half_in || half_out) {
+            if (verbose > 2) {
+                printf("using ffts_init_1d_real_half\n");
+            }
+            h = init_half(p, sz->dims[0].n);
+            plan = h ? h->plan : NULL;
+        } else if (int_in) {
+            if (verbose > 2) {
+                printf("using %s\n", int_in_pass ? "ffts_init_1d_real" :
+                    "ffts_init_1d_real_int");
+            }
+            h = init_int(p, sz->dims[0].n);
+            plan = h ? h->plan : NULL;
+        } else if (sz->rnk == 1) {
             if (verbose > 2) {
                 printf("using ffts_init_1d_real\n");
             }
@@ -151,6 +770,33 @@ setup(bench_problem *p)
             bench_free(dims);
         }
         break;
+    case PROBLEM_R2R:
+        if (p->k[0] == R2R_DHT) {
+            if (verbose > 2) {
+                printf("using ffts_init_1d_dht\n");
+            }
+            plan = ffts_init_1d_dht(sz->dims[0].n);
+            break;
+        }
+
+        type = (p->k[0] == R2R_REDFT10 || p->k[0] == R2R_RODFT10) ? 2 : 3;
+        dst = (p->k[0] == R2R_RODFT10 || p->k[0] == R2R_RODFT01);
+        if (sz->rnk == 1) {
+            if (verbose > 2) {
+                printf("using ffts_init_%s\n", dst ? "dst" : "dct");
+            }
+            plan = dst ? ffts_init_dst(sz->dims[0].n, type) :
+                ffts_init_dct(sz->dims[0].n, type);
+        } else {
+            if (verbose > 2) {
+                printf("using ffts_init_nd_%s\n", dst ? "dst" : "dct");
+            }
+            dims = extract_dims(sz);
+            plan = dst ? ffts_init_nd_dst(sz->rnk, dims, type) :
+                ffts_init_nd_dct(sz->rnk, dims, type);
+            bench_free(dims);
+        }
+        break;
     default:
         BENCH_ASSERT(0);
     }
@@ -160,6 +806,35 @@ setup(bench_problem *p)
         printf("planner time: %g s\n", tim);
     }
 
-    p->userinfo = plan;
-    BENCH_ASSERT(p->userinfo);
+    ffts_set_setup_stats(NULL);
+
+    p->nsetup_stages = 0;
+    add_setup_stage(p, "luts", stats.luts);
+    add_setup_stage(p, "offsets", stats.offsets);
+    add_setup_stage(p, "is", stats.is);
+    add_setup_stage(p, "codegen", stats.codegen);
+    add_setup_stage(p, "protect", stats.protect);
+    add_setup_stage(p, "real-tables", stats.real_tables);
+
+    p->userinfo = h ? (void*) h : (void*) plan;
+    BENCH_ASSERT(plan);
+
+    if (!ffts_plan_memory(plan, &mem)) {
+        p->plan_memory = (double) mem.total;
+        if (verbose > 1) {
+            printf("plan memory: %lu bytes (tables %lu, scratch %lu, "
+                   "code %lu, plan %lu), %lu in huge pages\n",
+                   (unsigned long) mem.total, (unsigned long) mem.tables,
+                   (unsigned long) mem.scratch, (unsigned long) mem.code,
+                   (unsigned long) mem.plan, (unsigned long) mem.huge_pages);
+        }
+    }
+
+#ifdef HAVE_HUGEPAGE_ALLOCATOR
+    if (verbose > 1 && (hugetlb_bytes || thp_bytes)) {
+        printf("huge pages mapped so far: %lu bytes reserved, "
+               "%lu bytes transparent\n", (unsigned long) hugetlb_bytes,
+               (unsigned long) thp_bytes);
+    }
+#endif
 }
\ No newline at end of file
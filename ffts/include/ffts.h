@@ -81,6 +81,18 @@ ffts_init_2d(size_t N1, size_t N2, int sign);
 FFTS_API ffts_plan_t*
 ffts_init_nd(int rank, size_t *Ns, int sign);
 
+/* 1D complex plan for arrays that may not fit in memory, such as files
+   mapped with mmap. The transform takes two passes over the arrays,
+   each moving blocks of whole columns of an about sqrt(N) x sqrt(N)
+   matrix through work buffers of at most mem_size bytes (0 for 64 MiB);
+   larger buffers read longer runs of contiguous bytes. Read-ahead of
+   the next block and write-back of the last one are requested from the
+   system, so that the I/O overlaps the transforms. Must be executed out
+   of place.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_1d_ooc(size_t N, int sign, size_t mem_size);
+
 /* For real transforms, sign == FFTS_FORWARD implies a real-to-complex
    forwards tranform, and sign == FFTS_BACKWARD implies a complex-to-real
    backwards transform.
@@ -97,12 +109,342 @@ ffts_init_2d_real(size_t N1, size_t N2, int sign);
 FFTS_API ffts_plan_t*
 ffts_init_nd_real(int rank, size_t *Ns, int sign);
 
+/* 1D complex and forward real transforms of signed integer input,
+   such as the interleaved IQ samples of an ADC, of 16 bits
+   (FFTS_INT16) or 8 bits (FFTS_INT8), multiplied by scale (1.0f / 32768
+   for example) as they are converted. The output is float, as that of
+   ffts_init_1d and ffts_init_1d_real. The input needs no alignment.
+*/
+#define FFTS_INT16 1
+#define FFTS_INT8  2
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_int(size_t N, int sign, int format, float scale);
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_real_int(size_t N, int format, float scale);
+
+/* 1D complex and real transforms whose input and output are each stored
+   as float (FFTS_FLOAT), IEEE half precision (FFTS_FP16) or bfloat16
+   (FFTS_BF16) values of 16 bits, in arrays of uint16_t laid out as the
+   float arrays of ffts_init_1d and ffts_init_1d_real. Half precision
+   arrays need no alignment. Values are rounded to nearest even as they
+   are stored; FP16 overflows to infinity beyond 65504, so scale the input
+   of large transforms, whose outputs grow up to N times their inputs.
+*/
+#define FFTS_FLOAT 0
+#define FFTS_FP16  3
+#define FFTS_BF16  4
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_half(size_t N, int sign, int in_format, int out_format);
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_real_half(size_t N, int sign, int in_format, int out_format);
+
+/* conversion of n values between float and FFTS_FP16 or FFTS_BF16,
+   as done by the plans above */
+FFTS_API void
+ffts_float_to_half(const float *in, void *out, size_t n, int format);
+
+FFTS_API void
+ffts_half_to_float(const void *in, float *out, size_t n, int format);
+
+/* Discrete Hartley transform of N real numbers, H[k] = Re X[k] - Im X[k]
+   where X is their forward FFT, as FFTW's R2R_DHT. It is its own
+   inverse up to a factor of N. N must be a power of two of at least 4.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_1d_dht(size_t N);
+
+/* Discrete cosine and sine transforms of real data, type 2 (DCT-II,
+   DST-II) or 3 (DCT-III, DST-III), computed by a real FFT of the same
+   size. They are not normalized, as FFTW's REDFT10, REDFT01, RODFT10
+   and RODFT01: the type 3 transform of the type 2 transform of N points
+   is the input multiplied by 2 * N. The multi-dimensional variants
+   apply the transform along every dimension. Sizes must be powers of
+   two of at least 4.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_dct(size_t N, int type);
+
+FFTS_API ffts_plan_t*
+ffts_init_dst(size_t N, int type);
+
+FFTS_API ffts_plan_t*
+ffts_init_nd_dct(int rank, size_t *Ns, int type);
+
+FFTS_API ffts_plan_t*
+ffts_init_nd_dst(int rank, size_t *Ns, int type);
+
+/* Streaming convolution of a signal with a kernel h of M samples, by
+   FFTs of a power of two N >= L + M - 1 points. Every ffts_execute
+   takes the next L samples of the signal and writes the next L samples
+   of the convolution, y[n] = sum h[m] x[n - m] with x[n] = 0 before the
+   first call, so input and output may be the same array. The spectrum
+   of h is computed once when planning. FFTS_CONV_OVERLAP_SAVE (the
+   default) transforms the last N samples of the signal and
+   FFTS_CONV_OVERLAP_ADD the L new ones, adding the rest of their
+   convolution to the next calls. FFTS_CONV_CORRELATE computes the
+   correlation y[n] = sum conj(h[m]) x[n - M + 1 + m] instead, that is
+   the output of the matched filter of h, delayed by M - 1 samples.
+   ffts_init_conv_real takes real signals and kernels, and
+   ffts_init_conv complex ones. The plans keep the last samples of the
+   signal, so they cannot be shared by several threads, even with
+   ffts_execute_with_scratch; ffts_conv_reset forgets them.
+*/
+#define FFTS_CONV_OVERLAP_SAVE 0
+#define FFTS_CONV_OVERLAP_ADD  1
+#define FFTS_CONV_CORRELATE    2
+
+FFTS_API ffts_plan_t*
+ffts_init_conv(size_t L, const float *h, size_t M, int flags);
+
+FFTS_API ffts_plan_t*
+ffts_init_conv_real(size_t L, const float *h, size_t M, int flags);
+
+FFTS_API void
+ffts_conv_reset(ffts_plan_t *p);
+
+/* Short-time Fourier transform of a stream of real samples: every hop
+   samples (1 <= hop <= N), the real FFT of the last N samples multiplied
+   by window (NULL for none), as N/2+1 complex numbers. Samples before
+   the first ones are zeros. ffts_stft takes the next n samples and
+   writes the frames they complete, at most (n + hop - 1) / hop, to
+   frames, stride floats apart; the stride must be at least N + 2 and a
+   multiple of 4. It returns the number of frames written. ffts_execute
+   takes hop samples and writes one frame. The plans keep the last
+   samples of the stream, so they cannot be shared by several threads;
+   ffts_stft_reset forgets them. N must be a power of two of at least 4.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_stft(size_t N, size_t hop, const float *window);
+
+FFTS_API size_t
+ffts_stft(ffts_plan_t *p, const float *input, size_t n, void *frames,
+          size_t stride);
+
+/* Inverse of the STFT of the same N, hop and window, by overlap-add of
+   the inverse real FFTs of the frames multiplied by the window again,
+   normalized by the sum of the squares of the window over overlapping
+   frames. ffts_istft takes count frames, stride floats apart (at least
+   N + 2 and a multiple of 4), and writes count * hop samples, the
+   signal delayed by N - hop samples; it returns their number.
+   ffts_execute takes one frame and writes hop samples. Samples that no
+   frame covers with a nonzero window are zeros. ffts_stft_reset
+   forgets the frames received so far.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_istft(size_t N, size_t hop, const float *window);
+
+FFTS_API size_t
+ffts_istft(ffts_plan_t *p, const void *frames, size_t count, size_t stride,
+           float *output);
+
+/* Power spectral density of a stream of real samples by Welch's method:
+   the average of |X[k]|^2 over the real FFTs X of the segments of N
+   samples multiplied by window (NULL for none), starting with the
+   first N samples and then every hop samples. The spectra are not
+   stored, only their running sums. ffts_psd takes the next n samples,
+   writes the N/2+1 values of the current average to psd unless it is
+   NULL, and returns the number of segments averaged. ffts_execute takes
+   hop samples and writes the average. Values are one-sided and divided
+   by the sum of the squares of the window, a density per 1/N of the
+   sample rate: with a constant window, their sum divided by N is the
+   mean square of the samples. Divide them by the sample rate for a
+   density per unit of frequency. ffts_stft_reset forgets the samples
+   and the segments.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_psd(size_t N, size_t hop, const float *window);
+
+FFTS_API size_t
+ffts_psd(ffts_plan_t *p, const float *input, size_t n, float *psd);
+
+FFTS_API void
+ffts_stft_reset(ffts_plan_t *p);
+
+/* Polyphase filter bank that splits a stream of complex samples into K
+   channels (a power of two of at least 4) with a prototype lowpass
+   filter h of M taps. For every block of D = K new samples, or K/2 with
+   FFTS_CHANNELIZER_OVERSAMPLED, channel c of the block is
+
+     sum h[m] x[s - m] exp(-2 pi i c (s - m) / K)
+
+   over m, where s is the last sample of the block: the stream mixed
+   down by c/K and filtered by h, sampled every D samples. Samples before
+   the first ones are zeros. ffts_channelize takes the next n samples
+   and writes the blocks they complete, at most (n + D - 1) / D of K
+   complex numbers each, and returns their number. ffts_execute takes D
+   samples and writes one block. The plans keep the last samples, so
+   they cannot be shared by several threads; ffts_channelizer_reset
+   forgets them.
+*/
+#define FFTS_CHANNELIZER_CRITICAL    0
+#define FFTS_CHANNELIZER_OVERSAMPLED 1
+
+FFTS_API ffts_plan_t*
+ffts_init_channelizer(size_t K, const float *h, size_t M, int flags);
+
+FFTS_API size_t
+ffts_channelize(ffts_plan_t *p, const void *input, size_t n, void *output);
+
+FFTS_API void
+ffts_channelizer_reset(ffts_plan_t *p);
+
+/* Sliding DFT of the last N complex samples (N a power of two of at
+   least 4), updated sample by sample for count chosen bins, or all N
+   bins in order if bins is NULL: with the oldest sample of the window
+   at time zero, bin k is
+
+     sum x[s - N + 1 + m] exp(-2 pi i k m / N)
+
+   over m, where s is the last sample. Each sample costs O(count), so
+   tracking a few bins over short hops is much cheaper than an FFT per
+   hop. Every anchor samples (N if 0) the bins are recomputed by an FFT
+   of the window, to bound the drift of the updates. ffts_sdft takes the
+   next n samples and, if spectrum is not NULL, writes the count bins
+   as complex numbers. ffts_execute does the same with hop samples.
+   Samples before the first ones are zeros. The plans keep the window,
+   so they cannot be shared by several threads; ffts_sdft_reset
+   forgets it.
+*/
+FFTS_API ffts_plan_t*
+ffts_init_sdft(size_t N, size_t hop, const size_t *bins, size_t count,
+               size_t anchor);
+
+FFTS_API void
+ffts_sdft(ffts_plan_t *p, const void *input, size_t n, void *spectrum);
+
+FFTS_API void
+ffts_sdft_reset(ffts_plan_t *p);
+
 FFTS_API void
 ffts_execute(ffts_plan_t *p, const void *input, void *output);
 
 FFTS_API void
 ffts_free(ffts_plan_t *p);
 
+/* ffts_execute writes intermediate results to work buffers owned by
+   the plan, so a plan must not be executed by several threads at once.
+   ffts_execute_with_scratch keeps them in the caller's scratch instead
+   and leaves the plan untouched, so threads that each pass their own
+   scratch may share one plan. The scratch must be at least
+   ffts_scratch_size(p) bytes (0 for plans without work buffers) and
+   aligned to 32 bytes; NULL behaves like ffts_execute.
+*/
+FFTS_API size_t
+ffts_scratch_size(const ffts_plan_t *p);
+
+FFTS_API void
+ffts_execute_with_scratch(ffts_plan_t *p, const void *input, void *output,
+                          void *scratch);
+
+/* Wall-clock seconds spent in each stage of plan creation. While a
+   structure is registered, every ffts_init_* call adds its stage times
+   to it; pass NULL to stop collecting. Registration is global and not
+   thread-safe, so create plans from a single thread while it is active.
+*/
+typedef struct _ffts_setup_stats_t {
+    double luts;        /* twiddle factor lookup tables */
+    double offsets;     /* leaf offsets */
+    double is;          /* leaf input strides */
+    double codegen;     /* code buffer allocation and code emission */
+    double protect;     /* execute permission and instruction cache flush */
+    double real_tables; /* real transform pre/post-processing tables */
+} ffts_setup_stats_t;
+
+FFTS_API void
+ffts_set_setup_stats(ffts_setup_stats_t *stats);
+
+/* Bytes of memory held by a plan, including all of its sub-plans.
+   Sub-plans shared between dimensions are counted once.
+*/
+typedef struct _ffts_memory_stats_t {
+    size_t tables;  /* twiddle factors, offset and index tables */
+    size_t scratch; /* work buffers of real and multi-dimensional plans */
+    size_t code;    /* generated machine code */
+    size_t plan;    /* plan structures and dimension arrays */
+    size_t total;
+    size_t huge_pages; /* bytes of the above mapped in huge pages */
+} ffts_memory_stats_t;
+
+/* returns 0 on success, -1 if p or stats is NULL */
+FFTS_API int
+ffts_plan_memory(const ffts_plan_t *p, ffts_memory_stats_t *stats);
+
+/* Regions of memory requested from a custom allocator */
+#define FFTS_MEM_PLAN    0 /* plan structures and dimension arrays */
+#define FFTS_MEM_TABLES  1 /* twiddle factors, offset and index tables */
+#define FFTS_MEM_SCRATCH 2 /* work buffers of real and multi-dimensional plans */
+#define FFTS_MEM_TEMP    3 /* temporaries freed before ffts_init_* returns */
+
+/* alignment is a power of two not larger than 32; the memory
+   returned does not need to be zeroed */
+typedef void* (*ffts_alloc_func_t)(size_t size, size_t alignment,
+                                   int region, void *user);
+typedef void (*ffts_free_func_t)(void *ptr, int region, void *user);
+
+/* Route the allocations of the plans created after this call to alloc
+   and free; pass NULL to restore the default allocator. A plan keeps
+   the allocator it was created with until ffts_free, so changing the
+   allocator between ffts_init_* calls gives each plan its own. The
+   generated machine code is not included, as it needs executable
+   pages. Not thread-safe with respect to concurrent ffts_init_* calls.
+*/
+FFTS_API void
+ffts_set_allocator(ffts_alloc_func_t alloc, ffts_free_func_t free, void *user);
+
+/* Map the twiddle tables, offset/index tables and work buffers of at
+   least min_size bytes in 2 MiB huge pages: pages reserved with
+   MAP_HUGETLB when available, else transparent huge pages requested
+   with madvise(MADV_HUGEPAGE), else ordinary memory. Regions are
+   rounded up to whole huge pages, so min_size should not be much less
+   than 2 MiB. 0 (the default) disables it. Applies to plans created
+   afterwards with the default allocator; Linux only.
+*/
+FFTS_API void
+ffts_set_huge_pages(size_t min_size);
+
+/* Place the tables, work buffers and machine code of the plans created
+   after this call on the given NUMA node, whatever thread creates or
+   executes them; -1 (the default) leaves them where the planning thread
+   first touches them. Regions smaller than a page are always placed by
+   first touch, so for a plan to be entirely local to a node, create it
+   from a thread running on that node as well. Executing a plan from
+   another node then reads its tables across the interconnect; give each
+   node its own plan instead. Applies to the default allocator; Linux
+   only, and ignored for nodes the system does not have.
+*/
+FFTS_API void
+ffts_set_numa_node(int node);
+
+/* Store the twiddle factors of the plans created after this call
+   compactly when their usual layout, with the real and imaginary parts
+   of every twiddle broadcast to vectors of their own, would take
+   min_size bytes or more: each twiddle is then stored once and
+   duplicated by a shuffle in the transform. That halves the table,
+   which pays off once it no longer fits in cache. By default min_size
+   is the size of the L2 cache; 0 makes every table compact and
+   (size_t) -1 none. Only the generated x86 code has a compact layout.
+*/
+FFTS_API void
+ffts_set_compact_luts(size_t min_size);
+
+/* Create the 1D complex plans of min_N points or more created after
+   this call as two passes of about sqrt(N) points, whose twiddle
+   factors in between are computed while executing, by a recurrence in
+   double precision restarted from an exact value every 64 twiddles.
+   Only the tables of the two small passes are stored, instead of
+   tables of N twiddles, at the cost of some speed; meant for sizes
+   whose tables would not fit in memory or cache. Executed in place,
+   such plans first copy the input to a temporary array, so execute
+   them out of place where memory is short. 0 (the default) disables
+   it.
+*/
+FFTS_API void
+ffts_set_otf_twiddles(size_t min_N);
+
 #ifdef __cplusplus
 }
 #endif
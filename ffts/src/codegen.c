@@ -148,8 +148,13 @@ transform_func_t ffts_generate_func_code(ffts_plan_t *p, size_t N, size_t leaf_N
     fp = (insns_t*) p->transform_base;
 
     /* generate base cases */
+#ifdef HAVE_SSE
+    x_4_addr = generate_size4_base_case(&fp, sign, p->compact_luts);
+    x_8_addr = generate_size8_base_case(&fp, sign, p->compact_luts);
+#else
     x_4_addr = generate_size4_base_case(&fp, sign);
     x_8_addr = generate_size8_base_case(&fp, sign);
+#endif
 
 #ifdef __arm__
     start = generate_prologue(&fp, p);
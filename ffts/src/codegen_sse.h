@@ -253,8 +253,21 @@ generate_transform_init(insns_t **fp)
 #endif
 }
 
+/* Load two twiddles of a compact lookup table, with their real parts
+   broadcast to re and their imaginary parts to im, sign changed as in
+   the broadcast tables (XMM3 holds MULI_SIGN of ffts_generate_luts) */
+static FFTS_INLINE void
+generate_load_twiddles(insns_t **fp, int re, int im, int base, int disp)
+{
+    x64_sse_movaps_reg_membase(*fp, re, base, disp);
+    x64_sse_movaps_reg_reg(*fp, im, re);
+    x64_sse_shufps_reg_reg_imm(*fp, re, re, 0xA0);
+    x64_sse_shufps_reg_reg_imm(*fp, im, im, 0xF5);
+    x64_sse_xorps_reg_reg(*fp, im, X64_XMM3);
+}
+
 static FFTS_INLINE insns_t*
-generate_size4_base_case(insns_t **fp, int sign)
+generate_size4_base_case(insns_t **fp, int sign, int compact)
 {
     insns_t *ins;
     insns_t *x4_addr;
@@ -274,10 +287,16 @@ generate_size4_base_case(insns_t **fp, int sign)
     x64_sse_movaps_reg_membase(ins, X64_XMM0, X64_R8, 64);
     x64_sse_movaps_reg_membase(ins, X64_XMM1, X64_R8, 96);
     x64_sse_movaps_reg_membase(ins, X64_XMM7, X64_R8,  0);
-    x64_sse_movaps_reg_membase(ins, X64_XMM4, X64_R9,  0);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM4, X64_XMM2, X64_R9, 0);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM4, X64_R9,  0);
+    }
     x64_sse_movaps_reg_reg(ins, X64_XMM9, X64_XMM7);
     x64_sse_movaps_reg_reg(ins, X64_XMM6, X64_XMM4);
-    x64_sse_movaps_reg_membase(ins, X64_XMM2, X64_R9, 16);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM2, X64_R9, 16);
+    }
     x64_sse_mulps_reg_reg(ins, X64_XMM6, X64_XMM0);
     x64_sse_mulps_reg_reg(ins, X64_XMM4, X64_XMM1);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM0, X64_XMM0, 0xB1);
@@ -307,10 +326,16 @@ generate_size4_base_case(insns_t **fp, int sign)
     x64_sse_movaps_membase_reg(ins, X64_R8, 64, X64_XMM9);
     x64_sse_movaps_membase_reg(ins, X64_R8, 96, X64_XMM10);
 
-    x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_R9, 32);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM14, X64_XMM13, X64_R9, 16);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_R9, 32);
+    }
     x64_sse_movaps_reg_membase(ins, X64_XMM11, X64_R8, 80);
     x64_sse_movaps_reg_reg(ins, X64_XMM0, X64_XMM14);
-    x64_sse_movaps_reg_membase(ins, X64_XMM13, X64_R9, 48);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM13, X64_R9, 48);
+    }
     x64_sse_mulps_reg_reg(ins, X64_XMM0, X64_XMM11);
     x64_sse_mulps_reg_reg(ins, X64_XMM14, X64_XMM12);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM11, X64_XMM11, 0xB1);
@@ -347,10 +372,16 @@ generate_size4_base_case(insns_t **fp, int sign)
     x64_sse_movaps_reg_membase(ins, X64_XMM0, X64_RDX, 64);
     x64_sse_movaps_reg_membase(ins, X64_XMM1, X64_RDX, 96);
     x64_sse_movaps_reg_membase(ins, X64_XMM7, X64_RDX,  0);
-    x64_sse_movaps_reg_membase(ins, X64_XMM4, X64_R8,   0);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM4, X64_XMM2, X64_R8, 0);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM4, X64_R8,   0);
+    }
     x64_sse_movaps_reg_reg(ins, X64_XMM9, X64_XMM7);
     x64_sse_movaps_reg_reg(ins, X64_XMM6, X64_XMM4);
-    x64_sse_movaps_reg_membase(ins, X64_XMM2, X64_R8, 16);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM2, X64_R8, 16);
+    }
     x64_sse_mulps_reg_reg(ins, X64_XMM6, X64_XMM0);
     x64_sse_mulps_reg_reg(ins, X64_XMM4, X64_XMM1);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM0, X64_XMM0, 0xB1);
@@ -380,10 +411,16 @@ generate_size4_base_case(insns_t **fp, int sign)
     x64_sse_movaps_membase_reg(ins, X64_RDX, 64, X64_XMM9);
     x64_sse_movaps_membase_reg(ins, X64_RDX, 96, X64_XMM10);
 
-    x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_R8, 32);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM14, X64_XMM13, X64_R8, 16);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_R8, 32);
+    }
     x64_sse_movaps_reg_membase(ins, X64_XMM11, X64_RDX, 80);
     x64_sse_movaps_reg_reg(ins, X64_XMM0, X64_XMM14);
-    x64_sse_movaps_reg_membase(ins, X64_XMM13, X64_R8, 48);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM13, X64_R8, 48);
+    }
     x64_sse_mulps_reg_reg(ins, X64_XMM0, X64_XMM11);
     x64_sse_mulps_reg_reg(ins, X64_XMM14, X64_XMM12);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM11, X64_XMM11, 0xB1);
@@ -1350,7 +1387,7 @@ generate_leaf_oo(insns_t **fp, uint32_t loop_count, uint32_t *offsets, int exten
 }
 
 static FFTS_INLINE insns_t*
-generate_size8_base_case(insns_t **fp, int sign)
+generate_size8_base_case(insns_t **fp, int sign, int compact)
 {
     insns_t *ins;
     insns_t *x8_addr;
@@ -1399,7 +1436,11 @@ generate_size8_base_case(insns_t **fp, int sign)
     assert(!(((uintptr_t) x8_soft_loop) & 0xF));
 
     /* load [input + 0 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RAX, 0);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM9, X64_XMM8, X64_RAX, 0);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RAX, 0);
+    }
 
     /* load [output + 2 * output_stride] */
     x64_sse_movaps_reg_memindex(ins, X64_XMM6, X64_RCX, 0, X64_RBX, 1);
@@ -1410,7 +1451,9 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_movaps_reg_memindex(ins, X64_XMM7, X64_RCX, 0, X64_RSI, 0);
 
     /* load [input + 1 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM8, X64_RAX, 16);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM8, X64_RAX, 16);
+    }
 
     x64_sse_mulps_reg_reg(ins, X64_XMM11, X64_XMM6);
     x64_sse_mulps_reg_reg(ins, X64_XMM9, X64_XMM7);
@@ -1423,7 +1466,11 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_addps_reg_reg(ins, X64_XMM9, X64_XMM8);
 
     /* load [input + 2 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM15, X64_RAX, 32);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM15, X64_XMM14, X64_RAX, 16);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM15, X64_RAX, 32);
+    }
 
     x64_sse_addps_reg_reg(ins, X64_XMM10, X64_XMM9);
     x64_sse_subps_reg_reg(ins, X64_XMM11, X64_XMM9);
@@ -1445,7 +1492,9 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_xorps_reg_reg(ins, X64_XMM11, X64_XMM3);
 
     /* load [input + 3 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_RAX, 48);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_RAX, 48);
+    }
 
     x64_sse_subps_reg_reg(ins, X64_XMM2, X64_XMM10);
     x64_sse_mulps_reg_reg(ins, X64_XMM6, X64_XMM12);
@@ -1453,7 +1502,11 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_mulps_reg_reg(ins, X64_XMM15, X64_XMM13);
 
     /* load [input + 4 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM10, X64_RAX, 64);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM10, X64_XMM9, X64_RAX, 32);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM10, X64_RAX, 64);
+    }
 
     x64_sse_movaps_reg_reg(ins, X64_XMM0, X64_XMM5);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM12, X64_XMM12, 0xB1);
@@ -1474,10 +1527,12 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_movaps_reg_reg(ins, X64_XMM12, X64_XMM6);
 
     /* load [input + 5 * input_stride] */
-    x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RAX, 80);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RAX, 80);
+    }
 
     /* move input by 6 * input_stride */
-    x64_alu_reg_imm_size(ins, X86_ADD, X64_RAX, 0x60, 8);
+    x64_alu_reg_imm_size(ins, X86_ADD, X64_RAX, compact ? 0x30 : 0x60, 8);
 
     x64_sse_mulps_reg_reg(ins, X64_XMM13, X64_XMM7);
     x64_sse_subps_reg_reg(ins, X64_XMM6, X64_XMM15);
@@ -1573,11 +1628,17 @@ generate_size8_base_case(insns_t **fp, int sign)
     x8_soft_loop = ins;
     assert(!(((uintptr_t) x8_soft_loop) & 0xF));
 
-    x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RSI, 0);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM9, X64_XMM8, X64_RSI, 0);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RSI, 0);
+    }
     x64_sse_movaps_reg_memindex(ins, X64_XMM6, X64_R10, 0, X64_RAX, 2);
     x64_sse_movaps_reg_reg(ins, X64_XMM11, X64_XMM9);
     x64_sse_movaps_reg_memindex(ins, X64_XMM7, X64_R11, 0, X64_RAX, 2);
-    x64_sse_movaps_reg_membase(ins, X64_XMM8, X64_RSI, 16);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM8, X64_RSI, 16);
+    }
     x64_sse_mulps_reg_reg(ins, X64_XMM11, X64_XMM6);
     x64_sse_mulps_reg_reg(ins, X64_XMM9, X64_XMM7);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM6, X64_XMM6, 0xB1);
@@ -1587,7 +1648,11 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_mulps_reg_reg(ins, X64_XMM8, X64_XMM7);
     x64_sse_movaps_reg_reg(ins, X64_XMM10, X64_XMM11);
     x64_sse_addps_reg_reg(ins, X64_XMM9, X64_XMM8);
-    x64_sse_movaps_reg_membase(ins, X64_XMM15, X64_RSI, 32);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM15, X64_XMM14, X64_RSI, 16);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM15, X64_RSI, 32);
+    }
     x64_sse_addps_reg_reg(ins, X64_XMM10, X64_XMM9);
     x64_sse_subps_reg_reg(ins, X64_XMM11, X64_XMM9);
     x64_sse_movaps_reg_memindex(ins, X64_XMM5, X64_RBX, 0, X64_RAX, 2);
@@ -1599,12 +1664,18 @@ generate_size8_base_case(insns_t **fp, int sign)
     /* change sign */
     x64_sse_xorps_reg_reg(ins, X64_XMM11, X64_XMM3);
 
-    x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_RSI, 48);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM14, X64_RSI, 48);
+    }
     x64_sse_subps_reg_reg(ins, X64_XMM2, X64_XMM10);
     x64_sse_mulps_reg_reg(ins, X64_XMM6, X64_XMM12);
     x64_sse_addps_reg_reg(ins, X64_XMM5, X64_XMM10);
     x64_sse_mulps_reg_reg(ins, X64_XMM15, X64_XMM13);
-    x64_sse_movaps_reg_membase(ins, X64_XMM10, X64_RSI, 64);
+    if (compact) {
+        generate_load_twiddles(&ins, X64_XMM10, X64_XMM9, X64_RSI, 32);
+    } else {
+        x64_sse_movaps_reg_membase(ins, X64_XMM10, X64_RSI, 64);
+    }
     x64_sse_movaps_reg_reg(ins, X64_XMM0, X64_XMM5);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM12, X64_XMM12, 0xB1);
     x64_sse_shufps_reg_reg_imm(ins, X64_XMM13, X64_XMM13, 0xB1);
@@ -1616,8 +1687,10 @@ generate_size8_base_case(insns_t **fp, int sign)
     x64_sse_movaps_reg_reg(ins, X64_XMM13, X64_XMM10);
     x64_sse_movaps_reg_memindex(ins, X64_XMM8, X64_R15, 0, X64_RAX, 2);
     x64_sse_movaps_reg_reg(ins, X64_XMM12, X64_XMM6);
-    x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RSI, 80);
-    x64_alu_reg_imm_size(ins, X86_ADD, X64_RSI, 0x60, 8);
+    if (!compact) {
+        x64_sse_movaps_reg_membase(ins, X64_XMM9, X64_RSI, 80);
+    }
+    x64_alu_reg_imm_size(ins, X86_ADD, X64_RSI, compact ? 0x30 : 0x60, 8);
     x64_sse_mulps_reg_reg(ins, X64_XMM13, X64_XMM7);
     x64_sse_subps_reg_reg(ins, X64_XMM6, X64_XMM15);
     x64_sse_addps_reg_reg(ins, X64_XMM12, X64_XMM15);
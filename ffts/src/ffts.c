@@ -34,7 +34,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ffts.h"
 
 #include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_otf.h"
 #include "ffts_static.h"
+#include "ffts_stats.h"
 #include "ffts_trig.h"
 #include "macros.h"
 #include "patterns.h"
@@ -53,8 +56,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if HAVE_SYS_MMAN_H
 #include <sys/mman.h>
 #endif
+
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_SSE) && !defined(DYNAMIC_DISABLED)
+/* the generated x86 base cases can read compact lookup tables */
+#define HAVE_COMPACT_LUTS
 #endif
 
+/* assumed L2 cache size when the system does not tell */
+#define FFTS_DEFAULT_L2_SIZE (256 * 1024)
+
+/* smallest lookup tables stored compact, valid once set */
+static size_t ffts_compact_luts_min = 0;
+static int ffts_compact_luts_set = 0;
+
+/* smallest 1D plans computing their twiddles while executing, 0 for none */
+static size_t ffts_otf_twiddles_min = 0;
+
 #if defined(HAVE_NEON)
 static const FFTS_ALIGN(64) float w_data[16] = {
      0.70710678118654757273731092936941f,
@@ -166,6 +186,56 @@ ffts_execute(ffts_plan_t *p, const void *in, void *out)
     p->transform(p, (const float*) in, (float*) out);
 }
 
+FFTS_API void
+ffts_execute_with_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+#if defined(HAVE_SSE) || defined(HAVE_NEON)
+    if (((uintptr_t) in % 16) != 0) {
+        LOG("ffts_execute_with_scratch: input buffer needs to be aligned to a 128bit boundary\n");
+    }
+
+    if (((uintptr_t) out % 16) != 0) {
+        LOG("ffts_execute_with_scratch: output buffer needs to be aligned to a 128bit boundary\n");
+    }
+#endif
+
+    if (((uintptr_t) scratch % 32) != 0) {
+        LOG("ffts_execute_with_scratch: scratch buffer needs to be aligned to a 256bit boundary\n");
+    }
+
+    if (scratch && p->transform_scratch) {
+        p->transform_scratch(p, (const float*) in, (float*) out, scratch);
+    } else {
+        p->transform(p, (const float*) in, (float*) out);
+    }
+}
+
+FFTS_API size_t
+ffts_scratch_size(const ffts_plan_t *p)
+{
+    size_t size, max_sub = 0;
+    int i;
+
+    if (!p || !p->transform_scratch) {
+        return 0;
+    }
+
+    /* sub-plans run one after the other and share the same space */
+    if (p->plans) {
+        for (i = 0; i < p->rank; i++) {
+            if (p->plans[i]) {
+                size = ffts_scratch_size(p->plans[i]);
+                if (size > max_sub) {
+                    max_sub = size;
+                }
+            }
+        }
+    }
+
+    return FFTS_SCRATCH_ALIGN(p->scratch_bytes) + max_sub;
+}
+
 FFTS_API void
 ffts_free(ffts_plan_t *p)
 {
@@ -174,6 +244,54 @@ ffts_free(ffts_plan_t *p)
     }
 }
 
+static void
+ffts_plan_memory_add(const ffts_plan_t *p, ffts_memory_stats_t *stats)
+{
+    int i, j;
+
+    stats->tables  += p->table_bytes;
+    stats->scratch += p->scratch_bytes;
+    stats->plan    += p->plan_bytes;
+    stats->huge_pages += p->allocator.huge_bytes;
+
+#if !defined(DYNAMIC_DISABLED)
+    if (p->transform_base) {
+        stats->code += p->transform_size;
+    }
+#endif
+
+    if (!p->plans) {
+        return;
+    }
+
+    for (i = 0; i < p->rank; i++) {
+        /* dimensions of equal size share the same plan */
+        for (j = 0; j < i; j++) {
+            if (p->plans[j] == p->plans[i]) {
+                break;
+            }
+        }
+
+        if (j == i && p->plans[i]) {
+            ffts_plan_memory_add(p->plans[i], stats);
+        }
+    }
+}
+
+FFTS_API int
+ffts_plan_memory(const ffts_plan_t *p, ffts_memory_stats_t *stats)
+{
+    if (!p || !stats) {
+        return -1;
+    }
+
+    stats->tables = stats->scratch = stats->code = stats->plan = 0;
+    stats->huge_pages = 0;
+    ffts_plan_memory_add(p, stats);
+    stats->total = stats->tables + stats->scratch + stats->code + stats->plan;
+    return 0;
+}
+
 void ffts_free_1d(ffts_plan_t *p)
 {
 #if !defined(DYNAMIC_DISABLED)
@@ -184,23 +302,90 @@ void ffts_free_1d(ffts_plan_t *p)
 #endif
 
     if (p->ws_is) {
-        free(p->ws_is);
+        ffts_mem_free(&p->allocator, p->ws_is, FFTS_MEM_TABLES);
     }
 
     if (p->ws) {
-        ffts_aligned_free(p->ws);
+        ffts_mem_free(&p->allocator, p->ws, FFTS_MEM_TABLES);
     }
 
     if (p->is) {
-        free(p->is);
+        ffts_mem_free(&p->allocator, p->is, FFTS_MEM_TABLES);
     }
 
     if (p->offsets) {
-        free(p->offsets);
+        ffts_mem_free(&p->allocator, p->offsets, FFTS_MEM_TABLES);
+    }
+
+    ffts_plan_release(p);
+}
+
+FFTS_API void
+ffts_set_compact_luts(size_t min_size)
+{
+    ffts_compact_luts_min = min_size;
+    ffts_compact_luts_set = 1;
+}
+
+FFTS_API void
+ffts_set_otf_twiddles(size_t min_N)
+{
+    ffts_otf_twiddles_min = min_N;
+}
+
+#ifdef HAVE_COMPACT_LUTS
+static size_t
+ffts_l2_cache_size(void)
+{
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+    if (size > 0) {
+        return (size_t) size;
+    }
+#endif
+
+    return FFTS_DEFAULT_L2_SIZE;
+}
+
+/* Compact lookup table of pass i: every twiddle is stored once, and
+   the base cases duplicate its real and imaginary parts themselves,
+   changing the sign of the latter with MULI_SIGN */
+static ffts_cpx_32f*
+ffts_generate_compact_lut(ffts_cpx_32f *w, const ffts_cpx_32f *tmp,
+                          size_t i, size_t n, int stride)
+{
+    size_t j, k;
+
+    if (!i) {
+        for (j = 0; j < n/4; j++) {
+            w[j][0] = tmp[j * stride][0];
+            w[j][1] = tmp[j * stride][1];
+        }
+
+        return w + n/4;
+    }
+
+    /* two twiddles of w0, then of w1 and of w2, as read by each
+       iteration of the size 8 base case */
+    for (j = 0; j < n/8; j += 2, w += 6) {
+        for (k = 0; k < 2; k++) {
+            const float *w0 = tmp[2 * (j + k) * stride];
+            const float *w1 = tmp[(j + k) * stride];
+            const float *w2 = tmp[(j + k + n/8) * stride];
+
+            w[k + 0][0] = w0[0];
+            w[k + 0][1] = w0[1];
+            w[k + 2][0] = w1[0];
+            w[k + 2][1] = w1[1];
+            w[k + 4][0] = w2[0];
+            w[k + 4][1] = w2[1];
+        }
     }
 
-    free(p);
+    return w;
 }
+#endif
 
 static int
 ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
@@ -226,6 +411,9 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
 
     if (n_luts) {
         size_t lut_size;
+#ifdef HAVE_COMPACT_LUTS
+        size_t compact_size;
+#endif
 
 #if defined(__arm__) && !defined(HAVE_NEON)
         lut_size = leaf_N * (((1 << n_luts) - 2) * 3 + 1) * sizeof(ffts_cpx_32f) / 2;
@@ -233,15 +421,32 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
         lut_size = leaf_N * (((1 << n_luts) - 2) * 3 + 1) * sizeof(ffts_cpx_32f);
 #endif
 
-        p->ws = ffts_aligned_malloc(lut_size);
+#ifdef HAVE_COMPACT_LUTS
+        if (!ffts_compact_luts_set) {
+            ffts_set_compact_luts(ffts_l2_cache_size());
+        }
+
+        /* the broadcast tables read by the transform are twice as big */
+        compact_size = leaf_N / 2 *
+            (((1 << (n_luts - 1)) - 1) * 3 + 1) * sizeof(ffts_cpx_32f);
+        if (2 * compact_size >= ffts_compact_luts_min) {
+            p->compact_luts = 1;
+            lut_size = compact_size;
+        }
+#endif
+
+        p->ws = ffts_mem_alloc(&p->allocator, lut_size, FFTS_MEM_TABLES);
         if (!p->ws) {
             goto cleanup;
         }
 
-        p->ws_is = (size_t*) malloc(n_luts * sizeof(*p->ws_is));
+        p->ws_is = (size_t*) ffts_mem_alloc(&p->allocator,
+            n_luts * sizeof(*p->ws_is), FFTS_MEM_TABLES);
         if (!p->ws_is) {
             goto cleanup;
         }
+
+        p->table_bytes += lut_size + n_luts * sizeof(*p->ws_is);
     }
 
     w = p->ws;
@@ -253,7 +458,8 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
 
     /* calculate factors */
     m = leaf_N << (n_luts - 2);
-    tmp = ffts_aligned_malloc(m * sizeof(ffts_cpx_32f));
+    tmp = ffts_mem_alloc(&p->allocator, m * sizeof(ffts_cpx_32f),
+        FFTS_MEM_TEMP);
 
     ffts_generate_cosine_sine_pow2_32f(tmp, m);
 
@@ -262,8 +468,14 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
     for (i = 0; i < n_luts; i++) {
         p->ws_is[i] = w - (ffts_cpx_32f*) p->ws;
 
+#ifdef HAVE_COMPACT_LUTS
+        if (p->compact_luts) {
+            w = ffts_generate_compact_lut(w, tmp, i, n, stride);
+        } else
+#endif
         if (!i) {
-            ffts_cpx_32f *w0 = ffts_aligned_malloc(n/4 * sizeof(ffts_cpx_32f));
+            ffts_cpx_32f *w0 = ffts_mem_alloc(&p->allocator,
+                n/4 * sizeof(ffts_cpx_32f), FFTS_MEM_TEMP);
             float *fw0 = (float*) w0;
             float *fw = (float*) w;
 
@@ -300,11 +512,14 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
             w += n/4 * 2;
 #endif
 
-            ffts_aligned_free(w0);
+            ffts_mem_free(&p->allocator, w0, FFTS_MEM_TEMP);
         } else {
-            ffts_cpx_32f *w0 = (ffts_cpx_32f*) ffts_aligned_malloc(n/8 * sizeof(ffts_cpx_32f));
-            ffts_cpx_32f *w1 = (ffts_cpx_32f*) ffts_aligned_malloc(n/8 * sizeof(ffts_cpx_32f));
-            ffts_cpx_32f *w2 = (ffts_cpx_32f*) ffts_aligned_malloc(n/8 * sizeof(ffts_cpx_32f));
+            ffts_cpx_32f *w0 = (ffts_cpx_32f*) ffts_mem_alloc(&p->allocator,
+                n/8 * sizeof(ffts_cpx_32f), FFTS_MEM_TEMP);
+            ffts_cpx_32f *w1 = (ffts_cpx_32f*) ffts_mem_alloc(&p->allocator,
+                n/8 * sizeof(ffts_cpx_32f), FFTS_MEM_TEMP);
+            ffts_cpx_32f *w2 = (ffts_cpx_32f*) ffts_mem_alloc(&p->allocator,
+                n/8 * sizeof(ffts_cpx_32f), FFTS_MEM_TEMP);
 
             float *fw0 = (float*) w0;
             float *fw1 = (float*) w1;
@@ -380,9 +595,9 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
             w += n/8 * 3 * 2;
 #endif
 
-            ffts_aligned_free(w0);
-            ffts_aligned_free(w1);
-            ffts_aligned_free(w2);
+            ffts_mem_free(&p->allocator, w0, FFTS_MEM_TEMP);
+            ffts_mem_free(&p->allocator, w1, FFTS_MEM_TEMP);
+            ffts_mem_free(&p->allocator, w2, FFTS_MEM_TEMP);
         }
 
         n *= 2;
@@ -401,7 +616,7 @@ ffts_generate_luts(ffts_plan_t *p, size_t N, size_t leaf_N, int sign)
     }
 #endif
 
-    ffts_aligned_free(tmp);
+    ffts_mem_free(&p->allocator, tmp, FFTS_MEM_TEMP);
 
     p->lastlut = w;
     p->n_luts = n_luts;
@@ -416,35 +631,52 @@ ffts_init_1d(size_t N, int sign)
 {
     const size_t leaf_N = 8;
     ffts_plan_t *p;
+    double t0;
 
     if (N < 2 || (N & (N - 1)) != 0) {
         LOG("FFT size must be a power of two\n");
         return NULL;
     }
 
-    p = calloc(1, sizeof(*p));
+    if (ffts_otf_twiddles_min && N >= ffts_otf_twiddles_min) {
+        p = ffts_init_1d_otf(N, sign);
+        if (p) {
+            return p;
+        }
+    }
+
+    p = ffts_plan_alloc(sizeof(*p));
     if (!p) {
         return NULL;
     }
 
     p->destroy = ffts_free_1d;
     p->N = N;
+    p->plan_bytes = sizeof(*p);
 
     if (N >= 32) {
         /* generate lookup tables */
+        FFTS_STATS_START(t0);
         if (ffts_generate_luts(p, N, leaf_N, sign)) {
             goto cleanup;
         }
+        FFTS_STATS_STOP(luts, t0);
 
-        p->offsets = ffts_init_offsets(N, leaf_N);
+        FFTS_STATS_START(t0);
+        p->offsets = ffts_init_offsets(&p->allocator, N, leaf_N);
         if (!p->offsets) {
             goto cleanup;
         }
+        p->table_bytes += N/leaf_N * sizeof(*p->offsets);
+        FFTS_STATS_STOP(offsets, t0);
 
-        p->is = ffts_init_is(N, leaf_N, 1);
+        FFTS_STATS_START(t0);
+        p->is = ffts_init_is(&p->allocator, N, leaf_N, 1);
         if (!p->is) {
             goto cleanup;
         }
+        p->table_bytes += N * sizeof(*p->is);
+        FFTS_STATS_STOP(is, t0);
 
         p->i0 = N/leaf_N/3 + 1;
         p->i1 = p->i2 = N/leaf_N/3;
@@ -480,18 +712,22 @@ ffts_init_1d(size_t N, int sign)
 #endif
 
         /* allocate code/function buffer */
+        FFTS_STATS_START(t0);
         p->transform_base = ffts_vmem_alloc(p->transform_size);
         if (!p->transform_base) {
             goto cleanup;
         }
+        ffts_mem_bind(&p->allocator, p->transform_base, p->transform_size);
 
         /* generate code */
         p->transform = ffts_generate_func_code(p, N, leaf_N, sign);
         if (!p->transform) {
             goto cleanup;
         }
+        FFTS_STATS_STOP(codegen, t0);
 
         /* enable execution with read access for the block */
+        FFTS_STATS_START(t0);
         if (ffts_allow_execute(p->transform_base, p->transform_size)) {
             goto cleanup;
         }
@@ -500,6 +736,7 @@ ffts_init_1d(size_t N, int sign)
         if (ffts_flush_instruction_cache(p->transform_base, p->transform_size)) {
             goto cleanup;
         }
+        FFTS_STATS_STOP(protect, t0);
 #endif
     } else {
         switch (N) {
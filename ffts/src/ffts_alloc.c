@@ -0,0 +1,316 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_alloc.h"
+
+#include <string.h>
+
+#if !defined(_WIN32) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#define HAVE_MMAP
+#if defined(MAP_HUGETLB) || defined(MADV_HUGEPAGE)
+#define HAVE_HUGE_PAGES
+#endif
+#endif
+
+#if defined(__linux__) && defined(HAVE_MMAP)
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef SYS_mbind
+#define HAVE_MBIND
+#endif
+#endif
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS 0x20
+#endif
+
+#define FFTS_HUGE_PAGE_SIZE ((size_t) 2 << 20)
+
+/* smallest region placed on a NUMA node by ffts_mem_bind, smaller
+   ones are left to the first touch of the planning thread */
+#define FFTS_NUMA_MIN_SIZE 4096
+
+/* MPOL_PREFERRED of <numaif.h>, so that we do not need libnuma */
+#define FFTS_MPOL_PREFERRED 1
+#define FFTS_MAX_NUMA_NODES 1024
+
+/* a region of a plan mapped by the default allocator */
+struct _ffts_map {
+    void *addr;
+    size_t size;   /* bytes requested */
+    size_t length; /* bytes mapped */
+    int huge;
+    struct _ffts_map *next;
+};
+
+ffts_allocator_t ffts_allocator = { NULL, NULL, NULL, NULL, 0, -1 };
+
+/* smallest table or work buffer mapped in huge pages, 0 if disabled */
+static size_t ffts_huge_pages_min = 0;
+
+FFTS_API void
+ffts_set_allocator(ffts_alloc_func_t alloc, ffts_free_func_t free, void *user)
+{
+    ffts_allocator.maps = NULL;
+    ffts_allocator.huge_bytes = 0;
+
+    if (alloc && free) {
+        ffts_allocator.alloc = alloc;
+        ffts_allocator.free  = free;
+        ffts_allocator.user  = user;
+    } else {
+        ffts_allocator.alloc = NULL;
+        ffts_allocator.free  = NULL;
+        ffts_allocator.user  = NULL;
+    }
+}
+
+FFTS_API void
+ffts_set_huge_pages(size_t min_size)
+{
+    ffts_huge_pages_min = min_size;
+}
+
+FFTS_API void
+ffts_set_numa_node(int node)
+{
+    ffts_allocator.node = (node >= 0 && node < FFTS_MAX_NUMA_NODES) ? node : -1;
+}
+
+void
+ffts_mem_bind(const ffts_allocator_t *a, void *addr, size_t length)
+{
+#ifdef HAVE_MBIND
+    unsigned long mask[FFTS_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+    const size_t bits = 8 * sizeof(mask[0]);
+
+    if (a->node < 0 || length < FFTS_NUMA_MIN_SIZE) {
+        return;
+    }
+
+    memset(mask, 0, sizeof(mask));
+    mask[a->node / bits] = 1UL << (a->node % bits);
+
+    /* Nothing has been touched yet, so every page is allocated on the
+       node when first written. Failures (no such node, a kernel without
+       NUMA) just leave the default first-touch placement. The kernel
+       drops the last bit of maxnode, hence the + 1. */
+    syscall(SYS_mbind, addr, (unsigned long) length, FFTS_MPOL_PREFERRED,
+        mask, (unsigned long) (8 * sizeof(mask) + 1), 0U);
+#else
+    (void) a;
+    (void) addr;
+    (void) length;
+#endif
+}
+
+#ifdef HAVE_MMAP
+/* Pages of their own for a region: huge pages if asked for and
+   available, and placed on the NUMA node of the allocator, if any */
+static void*
+ffts_map_alloc(ffts_allocator_t *a, size_t size, int huge)
+{
+    struct _ffts_map *m;
+    size_t length = size;
+    char *addr = NULL;
+
+    m = (struct _ffts_map*) malloc(sizeof(*m));
+    if (!m) {
+        return NULL;
+    }
+
+    if (huge) {
+        length = (size + FFTS_HUGE_PAGE_SIZE - 1) & ~(FFTS_HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+        /* pages reserved for hugetlbfs, if the system has any left */
+        addr = (char*) mmap(NULL, length, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr == (char*) MAP_FAILED) {
+            addr = NULL;
+        }
+#endif
+
+#ifdef MADV_HUGEPAGE
+        if (!addr) {
+            /* transparent huge pages, which need 2 MiB aligned mappings */
+            char *base = (char*) mmap(NULL, length + FFTS_HUGE_PAGE_SIZE,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (base != (char*) MAP_FAILED) {
+                size_t head;
+
+                addr = (char*) (((uintptr_t) base + FFTS_HUGE_PAGE_SIZE - 1) &
+                    ~((uintptr_t) FFTS_HUGE_PAGE_SIZE - 1));
+                head = addr - base;
+                if (head) {
+                    munmap(base, head);
+                }
+                munmap(addr + length, FFTS_HUGE_PAGE_SIZE - head);
+
+                if (madvise(addr, length, MADV_HUGEPAGE)) {
+                    munmap(addr, length);
+                    addr = NULL;
+                }
+            }
+        }
+#endif
+
+        if (!addr) {
+            huge = 0;
+            length = size;
+        }
+    }
+
+    if (!addr && a->node >= 0) {
+        addr = (char*) mmap(NULL, length, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == (char*) MAP_FAILED) {
+            addr = NULL;
+        }
+    }
+
+    if (!addr) {
+        free(m);
+        return NULL;
+    }
+
+    ffts_mem_bind(a, addr, length);
+
+    m->addr = addr;
+    m->size = size;
+    m->length = length;
+    m->huge = huge;
+    m->next = a->maps;
+    a->maps = m;
+    if (huge) {
+        a->huge_bytes += size;
+    }
+
+    return addr;
+}
+
+static int
+ffts_map_free(ffts_allocator_t *a, void *ptr)
+{
+    struct _ffts_map **pm, *m;
+
+    for (pm = &a->maps; (m = *pm) != NULL; pm = &m->next) {
+        if (m->addr == ptr) {
+            munmap(m->addr, m->length);
+            if (m->huge) {
+                a->huge_bytes -= m->size;
+            }
+
+            *pm = m->next;
+            free(m);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+void*
+ffts_mem_alloc(ffts_allocator_t *a, size_t size, int region)
+{
+    if (a->alloc) {
+        return a->alloc(size, 32, region, a->user);
+    }
+
+#ifdef HAVE_MMAP
+    if (region == FFTS_MEM_TABLES || region == FFTS_MEM_SCRATCH) {
+        int huge = 0;
+
+#ifdef HAVE_HUGE_PAGES
+        huge = ffts_huge_pages_min && size >= ffts_huge_pages_min;
+#endif
+
+        if (huge || (a->node >= 0 && size >= FFTS_NUMA_MIN_SIZE)) {
+            void *ptr = ffts_map_alloc(a, size, huge);
+
+            /* otherwise fall back to ordinary memory */
+            if (ptr) {
+                return ptr;
+            }
+        }
+    }
+#endif
+
+    return ffts_aligned_malloc(size);
+}
+
+void
+ffts_mem_free(ffts_allocator_t *a, void *ptr, int region)
+{
+    if (!ptr) {
+        return;
+    }
+
+    if (a->free) {
+        a->free(ptr, region, a->user);
+        return;
+    }
+
+#ifdef HAVE_MMAP
+    if (a->maps && ffts_map_free(a, ptr)) {
+        return;
+    }
+#endif
+
+    ffts_aligned_free(ptr);
+}
+
+ffts_plan_t*
+ffts_plan_alloc(size_t size)
+{
+    ffts_plan_t *p;
+
+    p = (ffts_plan_t*) ffts_mem_alloc(&ffts_allocator, size, FFTS_MEM_PLAN);
+    if (p) {
+        memset(p, 0, size);
+        p->allocator = ffts_allocator;
+    }
+
+    return p;
+}
+
+void
+ffts_plan_release(ffts_plan_t *p)
+{
+    /* the plan holds its allocator, take a copy before freeing it */
+    ffts_allocator_t a = p->allocator;
+
+    ffts_mem_free(&a, p, FFTS_MEM_PLAN);
+}
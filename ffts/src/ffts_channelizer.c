@@ -0,0 +1,311 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_channelizer.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "macros.h"
+
+#include <string.h>
+
+/* Polyphase channelizer of K channels: the prototype filter of M = P * K
+   taps (padded with zeros) is split into P branches of K taps, and for
+   every block of D = K (or K/2 when oversampled) new samples
+
+     v[i] = sum h[K - 1 - i + p * K] * x[s - K + 1 + i - p * K]
+
+   over the branches p, where s is the last sample, is transformed by a
+   forward FFT of K points. Channel c is then x mixed down by c / K and
+   filtered by h, at sample s. When oversampled, odd channels of every
+   other block change sign, which is a rotation of v by K / 2.
+
+   Taps are stored reversed and duplicated for the real and imaginary
+   parts of the input, so that the sums are products of aligned vectors
+   of both arrays, kept in registers over all the branches. The input
+   is kept in a buffer of 2 * M samples whose window of the last M
+   samples slides until it reaches the end and is moved back to the
+   start.
+*/
+
+/* private state of channelizer plans */
+typedef struct _ffts_channelizer_state_t {
+    /* prototype filter, reversed and duplicated, of taps taps */
+    float *filter;
+    size_t taps;
+
+    /* buffer of 2 * taps samples, of which the window of taps samples
+       starts at pos */
+    float *history;
+    size_t pos;
+
+    size_t block;  /* samples per block */
+    size_t fill;   /* samples of the next block received so far */
+    size_t frames; /* blocks output so far */
+    int mode;
+} ffts_channelizer_state_t;
+
+static void
+ffts_free_channelizer(ffts_plan_t *p)
+{
+    ffts_channelizer_state_t *s =
+        (ffts_channelizer_state_t*) p->state;
+
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    if (s->filter) {
+        ffts_mem_free(&p->allocator, s->filter, FFTS_MEM_TABLES);
+    }
+
+    if (s->history) {
+        ffts_mem_free(&p->allocator, s->history, FFTS_MEM_SCRATCH);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+static void
+ffts_channelizer_block(ffts_plan_t *p, float *out, void *scratch)
+{
+    ffts_channelizer_state_t *s =
+        (ffts_channelizer_state_t*) p->state;
+    const float *FFTS_RESTRICT g =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->filter);
+    const float *FFTS_RESTRICT x =
+        (const float*) FFTS_ASSUME_ALIGNED_16(s->history);
+    float *FFTS_RESTRICT v = (float*) FFTS_ASSUME_ALIGNED_32(
+        scratch ? scratch : p->buf);
+    const size_t K = p->N;
+    const size_t P = s->taps / K;
+    size_t i, j, k, rot;
+
+    rot = (s->mode && !(s->frames & 1)) ? K : 0;
+
+    /* the newest branch is the last K samples of the window; eight
+       floats of v are summed over all branches at a time */
+    x += 2 * (s->pos + (P - 1) * K);
+
+    for (i = 0; i < 2 * K; i += 8) {
+        const float *FFTS_RESTRICT gk = g + i;
+        const float *FFTS_RESTRICT xk = x + i;
+        V4SF s0 = V4SF_MUL(V4SF_LD(gk + 0), V4SF_LD(xk + 0));
+        V4SF s1 = V4SF_MUL(V4SF_LD(gk + 4), V4SF_LD(xk + 4));
+
+        for (k = 1; k < P; k++) {
+            gk += 2 * K;
+            xk -= 2 * K;
+            s0 = V4SF_ADD(s0, V4SF_MUL(V4SF_LD(gk + 0), V4SF_LD(xk + 0)));
+            s1 = V4SF_ADD(s1, V4SF_MUL(V4SF_LD(gk + 4), V4SF_LD(xk + 4)));
+        }
+
+        j = (i + rot) & (2 * K - 1);
+        V4SF_ST(v + j, s0);
+        j = (i + 4 + rot) & (2 * K - 1);
+        V4SF_ST(v + j, s1);
+    }
+
+    ffts_sub_transform(p, p->plans[0], v, out, scratch);
+}
+
+static size_t
+ffts_channelize_scratch(ffts_plan_t *p, const float *in, size_t n,
+                        float *out, void *scratch)
+{
+    ffts_channelizer_state_t *s =
+        (ffts_channelizer_state_t*) p->state;
+    const size_t M = s->taps;
+    const size_t D = s->block;
+    size_t count = 0, chunk;
+
+    while (n > 0) {
+        /* slide the window back before the next block */
+        if (!s->fill && s->pos + M > 2 * M) {
+            memmove(s->history, s->history + 2 * s->pos,
+                2 * (M - D) * sizeof(float));
+            s->pos = 0;
+        }
+
+        chunk = D - s->fill;
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        memcpy(s->history + 2 * (s->pos + M - D + s->fill),
+            in, 2 * chunk * sizeof(float));
+
+        s->fill += chunk;
+        in += 2 * chunk;
+        n -= chunk;
+
+        if (s->fill == D) {
+            ffts_channelizer_block(p, out, scratch);
+            s->pos += D;
+            s->fill = 0;
+            s->frames++;
+            out += 2 * p->N;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void
+ffts_execute_channelizer_scratch(ffts_plan_t *p, const void *in, void *out,
+                                 void *scratch)
+{
+    ffts_channelizer_state_t *s =
+        (ffts_channelizer_state_t*) p->state;
+
+    ffts_channelize_scratch(p, (const float*) in, s->block, (float*) out,
+        scratch);
+}
+
+static void
+ffts_execute_channelizer(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_channelizer_scratch(p, in, out, NULL);
+}
+
+FFTS_API size_t
+ffts_channelize(ffts_plan_t *p, const void *input, size_t n, void *output)
+{
+    if (!p) {
+        return 0;
+    }
+
+    return ffts_channelize_scratch(p, (const float*) input, n,
+        (float*) output, NULL);
+}
+
+FFTS_API void
+ffts_channelizer_reset(ffts_plan_t *p)
+{
+    ffts_channelizer_state_t *s;
+
+    if (!p) {
+        return;
+    }
+
+    s = (ffts_channelizer_state_t*) p->state;
+    memset(s->history, 0, 4 * s->taps * sizeof(float));
+    s->pos = 0;
+    s->fill = 0;
+    s->frames = 0;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_channelizer(size_t K, const float *h, size_t M, int flags)
+{
+    ffts_channelizer_state_t *s;
+    ffts_plan_t *p;
+    size_t P, i, k, m;
+
+    if (!h || M < 1) {
+        return NULL;
+    }
+
+    if (K < 4 || (K & (K - 1)) != 0) {
+        LOG("number of channels must be a power of two of at least 4\n");
+        return NULL;
+    }
+
+    P = (M + K - 1) / K;
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_channelizer_state_t*) &p[1];
+
+    p->transform = &ffts_execute_channelizer;
+    p->transform_scratch = &ffts_execute_channelizer_scratch;
+    p->destroy = &ffts_free_channelizer;
+    p->N       = K;
+    p->rank    = 1;
+    p->state   = s;
+    p->plans   = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + sizeof(*p->plans);
+
+    s->taps  = P * K;
+    s->mode  = flags & FFTS_CHANNELIZER_OVERSAMPLED;
+    s->block = s->mode ? K / 2 : K;
+
+    p->plans[0] = ffts_init_1d(K, FFTS_FORWARD);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    p->buf = ffts_mem_alloc(&p->allocator, 2 * K * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+    p->scratch_bytes = 2 * K * sizeof(float);
+
+    /* the sliding window, kept between calls and so counted with
+       the plan */
+    s->history = ffts_mem_alloc(&p->allocator, 4 * P * K * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!s->history) {
+        goto cleanup;
+    }
+    p->plan_bytes += 4 * P * K * sizeof(float);
+
+    s->filter = (float*) ffts_mem_alloc(&p->allocator,
+        2 * P * K * sizeof(float), FFTS_MEM_TABLES);
+    if (!s->filter) {
+        goto cleanup;
+    }
+    p->table_bytes = 2 * P * K * sizeof(float);
+
+    for (k = 0; k < P; k++) {
+        for (i = 0; i < K; i++) {
+            m = K - 1 - i + k * K;
+            s->filter[2 * (k * K + i) + 0] = m < M ? h[m] : 0.0f;
+            s->filter[2 * (k * K + i) + 1] = m < M ? h[m] : 0.0f;
+        }
+    }
+
+    ffts_channelizer_reset(p);
+    return p;
+
+cleanup:
+    ffts_free_channelizer(p);
+    return NULL;
+}
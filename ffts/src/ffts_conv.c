@@ -0,0 +1,458 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_conv.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_trig.h"
+
+#ifdef HAVE_SSE
+#include <xmmintrin.h>
+#endif
+
+#include <string.h>
+
+/* Streaming convolution of blocks of L samples with a kernel of M
+   samples, by FFTs of N >= L + M - 1 points. The spectrum of the kernel,
+   scaled by 1 / N, is computed once when planning.
+
+   Overlap-save transforms the last N samples of input and keeps the
+   last L samples of the circular convolution, which are free of
+   wrap-around. Overlap-add transforms the L new samples padded with
+   zeros and adds the N - L samples that run past the block to the
+   next blocks.
+
+   The real plan multiplies the spectra inside the pre-processing of
+   its inverse real FFT, so the product is never stored: plans[0] is
+   the forward real FFT of N points and plans[1] the inverse complex
+   FFT of N/2 points, and A and B are the tables of the inverse real
+   FFT in their scalar layout. The complex plan multiplies in place
+   before its inverse FFT, which is generated code.
+*/
+
+#define FFTS_CONV_MIN_N 16
+
+/* private state of convolution plans */
+typedef struct _ffts_conv_state_t {
+    /* spectrum of the kernel, scaled by 1 / N */
+    float *kernel;
+
+    /* window of input, then the tail of overlap-add, of size floats */
+    float *history;
+    size_t size;
+
+    size_t block; /* samples per call */
+    int mode;
+} ffts_conv_state_t;
+
+static void
+ffts_free_conv(ffts_plan_t *p)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        if (p->plans[i]) {
+            ffts_free(p->plans[i]);
+        }
+    }
+
+    if (p->A) {
+        ffts_mem_free(&p->allocator, p->A, FFTS_MEM_TABLES);
+    }
+
+    if (p->B) {
+        ffts_mem_free(&p->allocator, p->B, FFTS_MEM_TABLES);
+    }
+
+    if (s->kernel) {
+        ffts_mem_free(&p->allocator, s->kernel, FFTS_MEM_TABLES);
+    }
+
+    if (s->history) {
+        ffts_mem_free(&p->allocator, s->history, FFTS_MEM_SCRATCH);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+/* the product of the spectra X and H of N/2 + 1 points, inverted by the
+   pre-processing of the inverse real FFT */
+static void
+ffts_conv_real_product(const ffts_plan_t *p, const float *FFTS_RESTRICT X,
+                       float *FFTS_RESTRICT out)
+{
+    const ffts_conv_state_t *s = (const ffts_conv_state_t*) p->state;
+    const float *FFTS_RESTRICT H =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->kernel);
+    const float *FFTS_RESTRICT A = (const float*) FFTS_ASSUME_ALIGNED_32(p->A);
+    const float *FFTS_RESTRICT B = (const float*) FFTS_ASSUME_ALIGNED_32(p->B);
+    const size_t N = p->N;
+    float ar, ai, br, bi;
+    size_t i = 0;
+
+#ifdef HAVE_SSE
+    /* four i at a time, with X[N/2 - i] and H[N/2 - i] read backwards */
+    for (; i + 3 < N/2; i += 4) {
+        __m128 x0 = _mm_loadu_ps(X + 2*i);
+        __m128 x1 = _mm_loadu_ps(X + 2*i + 4);
+        __m128 h0 = _mm_loadu_ps(H + 2*i);
+        __m128 h1 = _mm_loadu_ps(H + 2*i + 4);
+        __m128 u0 = _mm_loadu_ps(X + N - 2*i - 2);
+        __m128 u1 = _mm_loadu_ps(X + N - 2*i - 6);
+        __m128 g0 = _mm_loadu_ps(H + N - 2*i - 2);
+        __m128 g1 = _mm_loadu_ps(H + N - 2*i - 6);
+        __m128 a0 = _mm_loadu_ps(A + 2*i);
+        __m128 a1 = _mm_loadu_ps(A + 2*i + 4);
+        __m128 b0 = _mm_loadu_ps(B + 2*i);
+        __m128 b1 = _mm_loadu_ps(B + 2*i + 4);
+        __m128 xr = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2,0,2,0));
+        __m128 xi = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3,1,3,1));
+        __m128 hr = _mm_shuffle_ps(h0, h1, _MM_SHUFFLE(2,0,2,0));
+        __m128 hi = _mm_shuffle_ps(h0, h1, _MM_SHUFFLE(3,1,3,1));
+        __m128 ur = _mm_shuffle_ps(u0, u1, _MM_SHUFFLE(0,2,0,2));
+        __m128 ui = _mm_shuffle_ps(u0, u1, _MM_SHUFFLE(1,3,1,3));
+        __m128 gr = _mm_shuffle_ps(g0, g1, _MM_SHUFFLE(0,2,0,2));
+        __m128 gi = _mm_shuffle_ps(g0, g1, _MM_SHUFFLE(1,3,1,3));
+        __m128 va = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0));
+        __m128 vb = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1));
+        __m128 vc = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0));
+        __m128 vd = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1));
+        __m128 yr = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+        __m128 yi = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+        __m128 zr = _mm_sub_ps(_mm_mul_ps(ur, gr), _mm_mul_ps(ui, gi));
+        __m128 zi = _mm_add_ps(_mm_mul_ps(ur, gi), _mm_mul_ps(ui, gr));
+        __m128 re = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(yr, va), _mm_mul_ps(yi, vb)),
+            _mm_sub_ps(_mm_mul_ps(zr, vc), _mm_mul_ps(zi, vd)));
+        __m128 im = _mm_sub_ps(
+            _mm_sub_ps(_mm_mul_ps(yi, va), _mm_mul_ps(yr, vb)),
+            _mm_add_ps(_mm_mul_ps(zr, vd), _mm_mul_ps(zi, vc)));
+
+        _mm_storeu_ps(out + 2*i, _mm_unpacklo_ps(re, im));
+        _mm_storeu_ps(out + 2*i + 4, _mm_unpackhi_ps(re, im));
+    }
+#endif
+
+    for (; i < N/2; i++) {
+        ar = X[2*i + 0] * H[2*i + 0] - X[2*i + 1] * H[2*i + 1];
+        ai = X[2*i + 0] * H[2*i + 1] + X[2*i + 1] * H[2*i + 0];
+        br = X[N - 2*i + 0] * H[N - 2*i + 0] - X[N - 2*i + 1] * H[N - 2*i + 1];
+        bi = X[N - 2*i + 0] * H[N - 2*i + 1] + X[N - 2*i + 1] * H[N - 2*i + 0];
+
+        out[2*i + 0] = ar * A[2*i + 0] + ai * A[2*i + 1] +
+                       br * B[2*i + 0] - bi * B[2*i + 1];
+        out[2*i + 1] = ai * A[2*i + 0] - ar * A[2*i + 1] -
+                       br * B[2*i + 1] - bi * B[2*i + 0];
+    }
+}
+
+/* X *= H for N complex points */
+static void
+ffts_conv_complex_product(const ffts_plan_t *p, float *FFTS_RESTRICT X)
+{
+    const ffts_conv_state_t *s = (const ffts_conv_state_t*) p->state;
+    const float *FFTS_RESTRICT H =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->kernel);
+    const size_t N = p->N;
+    float re, im;
+    size_t i = 0;
+
+#ifdef HAVE_SSE
+    for (; i + 3 < N; i += 4) {
+        __m128 x0 = _mm_load_ps(X + 2*i);
+        __m128 x1 = _mm_load_ps(X + 2*i + 4);
+        __m128 h0 = _mm_load_ps(H + 2*i);
+        __m128 h1 = _mm_load_ps(H + 2*i + 4);
+        __m128 xr = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(2,0,2,0));
+        __m128 xi = _mm_shuffle_ps(x0, x1, _MM_SHUFFLE(3,1,3,1));
+        __m128 hr = _mm_shuffle_ps(h0, h1, _MM_SHUFFLE(2,0,2,0));
+        __m128 hi = _mm_shuffle_ps(h0, h1, _MM_SHUFFLE(3,1,3,1));
+        __m128 yr = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+        __m128 yi = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+
+        _mm_store_ps(X + 2*i, _mm_unpacklo_ps(yr, yi));
+        _mm_store_ps(X + 2*i + 4, _mm_unpackhi_ps(yr, yi));
+    }
+#endif
+
+    for (; i < N; i++) {
+        re = X[2*i + 0] * H[2*i + 0] - X[2*i + 1] * H[2*i + 1];
+        im = X[2*i + 0] * H[2*i + 1] + X[2*i + 1] * H[2*i + 0];
+        X[2*i + 0] = re;
+        X[2*i + 1] = im;
+    }
+}
+
+/* L samples of output from the circular convolution y of the window,
+   of c floats per sample, and the window or tail for the next call */
+static void
+ffts_conv_output(ffts_plan_t *p, const float *FFTS_RESTRICT y,
+                 float *FFTS_RESTRICT out, size_t c)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+    const size_t L = c * s->block;
+    const size_t K = c * (p->N - s->block);
+    float *FFTS_RESTRICT window = s->history;
+    float *FFTS_RESTRICT tail = s->history + c * p->N;
+    size_t j;
+
+    if (s->mode == FFTS_CONV_OVERLAP_SAVE) {
+        memcpy(out, y + K, L * sizeof(float));
+        memmove(window, window + L, K * sizeof(float));
+        return;
+    }
+
+    for (j = 0; j < L; j++) {
+        out[j] = y[j] + (j < K ? tail[j] : 0.0f);
+    }
+
+    for (j = 0; j < K; j++) {
+        tail[j] = y[L + j] + (L + j < K ? tail[L + j] : 0.0f);
+    }
+}
+
+/* the new block goes at the end of the window for overlap-save, and at
+   its start, followed by zeros, for overlap-add */
+static FFTS_INLINE float*
+ffts_conv_input(ffts_plan_t *p, size_t c)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+
+    if (s->mode == FFTS_CONV_OVERLAP_SAVE) {
+        return s->history + c * (p->N - s->block);
+    }
+
+    return s->history;
+}
+
+static void
+ffts_execute_conv_real_scratch(ffts_plan_t *p, const void *in, void *out,
+                               void *scratch)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+    const size_t N = p->N;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    float *spec = buf;
+    float *pre = buf + N + 4;
+
+    /* copy first, the output may overwrite the input */
+    memcpy(ffts_conv_input(p, 1), in, s->block * sizeof(float));
+
+    ffts_sub_transform(p, p->plans[0], s->history, spec, scratch);
+    ffts_conv_real_product(p, spec, pre);
+    ffts_sub_transform(p, p->plans[1], pre, spec, scratch);
+
+    ffts_conv_output(p, spec, (float*) out, 1);
+}
+
+static void
+ffts_execute_conv_real(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_conv_real_scratch(p, in, out, NULL);
+}
+
+static void
+ffts_execute_conv_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+    const size_t N = p->N;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    float *spec = buf;
+    float *y = buf + 2 * N;
+
+    memcpy(ffts_conv_input(p, 2), in, 2 * s->block * sizeof(float));
+
+    ffts_sub_transform(p, p->plans[0], s->history, spec, scratch);
+    ffts_conv_complex_product(p, spec);
+    ffts_sub_transform(p, p->plans[1], spec, y, scratch);
+
+    ffts_conv_output(p, y, (float*) out, 2);
+}
+
+static void
+ffts_execute_conv(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_conv_scratch(p, in, out, NULL);
+}
+
+FFTS_API void
+ffts_conv_reset(ffts_plan_t *p)
+{
+    ffts_conv_state_t *s = (ffts_conv_state_t*) p->state;
+
+    memset(s->history, 0, s->size * sizeof(float));
+}
+
+static ffts_plan_t*
+ffts_init_conv_1d(size_t L, const float *h, size_t M, int flags, int real)
+{
+    const size_t c = real ? 1 : 2;
+    ffts_conv_state_t *s;
+    ffts_plan_t *p;
+    size_t N, spectrum, j;
+    float scale;
+
+    if (!h || L < 1 || M < 1) {
+        return NULL;
+    }
+
+    for (N = FFTS_CONV_MIN_N; N < L + M - 1; N *= 2);
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + 2 * sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_conv_state_t*) &p[1];
+
+    if (real) {
+        p->transform = &ffts_execute_conv_real;
+        p->transform_scratch = &ffts_execute_conv_real_scratch;
+    } else {
+        p->transform = &ffts_execute_conv;
+        p->transform_scratch = &ffts_execute_conv_scratch;
+    }
+
+    p->destroy = &ffts_free_conv;
+    p->N       = N;
+    p->rank    = 2;
+    p->state   = s;
+    p->plans   = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + 2 * sizeof(*p->plans);
+
+    s->block = L;
+    s->mode  = flags & FFTS_CONV_OVERLAP_ADD;
+
+    if (real) {
+        p->plans[0] = ffts_init_1d_real(N, FFTS_FORWARD);
+        p->plans[1] = ffts_init_1d(N/2, FFTS_BACKWARD);
+    } else {
+        p->plans[0] = ffts_init_1d(N, FFTS_FORWARD);
+        p->plans[1] = ffts_init_1d(N, FFTS_BACKWARD);
+    }
+
+    if (!p->plans[0] || !p->plans[1]) {
+        goto cleanup;
+    }
+
+    /* the spectrum, then the product or the convolution */
+    p->scratch_bytes = (real ? 2 * N + 4 : 4 * N) * sizeof(float);
+    p->buf = ffts_mem_alloc(&p->allocator, p->scratch_bytes,
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    /* the window of input, then the tail of overlap-add, kept between
+       calls and so counted with the plan rather than the scratch */
+    s->size = c * N;
+    if (s->mode == FFTS_CONV_OVERLAP_ADD) {
+        s->size += c * (N - L);
+    }
+
+    s->history = ffts_mem_alloc(&p->allocator, s->size * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!s->history) {
+        goto cleanup;
+    }
+    p->plan_bytes += s->size * sizeof(float);
+
+    spectrum = real ? N + 2 : 2 * N;
+    s->kernel = (float*) ffts_mem_alloc(&p->allocator,
+        spectrum * sizeof(float), FFTS_MEM_TABLES);
+    if (!s->kernel) {
+        goto cleanup;
+    }
+    p->table_bytes = spectrum * sizeof(float);
+
+    if (real) {
+        p->A = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+            FFTS_MEM_TABLES);
+        if (!p->A) {
+            goto cleanup;
+        }
+
+        p->B = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+            FFTS_MEM_TABLES);
+        if (!p->B) {
+            goto cleanup;
+        }
+        p->table_bytes += 2 * N * sizeof(float);
+
+        ffts_generate_table_1d_real_32f(p, FFTS_BACKWARD, 0);
+    }
+
+    /* the kernel, reversed and conjugated for correlation, is padded
+       with zeros in the window and transformed */
+    memset(s->history, 0, c * N * sizeof(float));
+    for (j = 0; j < M; j++) {
+        size_t k = (flags & FFTS_CONV_CORRELATE) ? M - 1 - j : j;
+
+        s->history[c*k] = h[c*j];
+        if (!real) {
+            s->history[c*k + 1] =
+                (flags & FFTS_CONV_CORRELATE) ? -h[c*j + 1] : h[c*j + 1];
+        }
+    }
+
+    p->plans[0]->transform(p->plans[0], s->history, s->kernel);
+
+    scale = 1.0f / (float) N;
+    for (j = 0; j < spectrum; j++) {
+        s->kernel[j] *= scale;
+    }
+
+    ffts_conv_reset(p);
+    return p;
+
+cleanup:
+    ffts_free_conv(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_conv(size_t L, const float *h, size_t M, int flags)
+{
+    return ffts_init_conv_1d(L, h, M, flags, 0);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_conv_real(size_t L, const float *h, size_t M, int flags)
+{
+    return ffts_init_conv_1d(L, h, M, flags, 1);
+}
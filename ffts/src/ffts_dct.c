@@ -0,0 +1,447 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_dct.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_real.h"
+#include "ffts_transpose.h"
+#include "ffts_trig.h"
+
+#include <string.h>
+
+/* DCT-II and DCT-III of N points from a real FFT of N points (Makhoul):
+   the input is reordered evens first, odds reversed, and the spectrum
+   rotated by exp(-i * pi * k / (2 * N)), or the other way round for the
+   DCT-III. The DST-II and DST-III are the same with the signs of odd
+   samples changed and the order of the DCT output, or input, reversed.
+   Normalization is that of FFTW's REDFT10, REDFT01, RODFT10 and RODFT01.
+   The real FFT reads all of its input before writing its output, so it
+   runs in place in the work buffer, and the only buffer is its spectrum.
+*/
+
+static void
+ffts_free_1d_r2r(ffts_plan_t *p)
+{
+    if (p->A) {
+        ffts_mem_free(&p->allocator, p->A, FFTS_MEM_TABLES);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    ffts_plan_release(p);
+}
+
+static FFTS_INLINE void
+ffts_dct2(ffts_plan_t *p, const float *FFTS_RESTRICT in,
+          float *FFTS_RESTRICT out, float *FFTS_RESTRICT buf, void *scratch,
+          int dst)
+{
+    const float *FFTS_RESTRICT t = (const float*) FFTS_ASSUME_ALIGNED_32(p->A);
+    const size_t N = p->N;
+    const float odd = dst ? -1.0f : 1.0f;
+    size_t k, lo, hi;
+    float c, s, re, im;
+
+    for (k = 0; k < N/2; k++) {
+        buf[k] = in[2*k];
+        buf[N - 1 - k] = odd * in[2*k + 1];
+    }
+
+    ffts_sub_transform(p, p->plans[0], buf, buf, scratch);
+
+    /* the DST reads the DCT backwards */
+    lo = dst ? N - 1 : 0;
+    out[lo] = 2.0f * buf[0];
+
+    for (k = 1; k < N/2; k++) {
+        c  = t[2*k + 0];
+        s  = t[2*k + 1];
+        re = buf[2*k + 0];
+        im = buf[2*k + 1];
+
+        lo = dst ? N - 1 - k : k;
+        hi = dst ? k - 1 : N - k;
+        out[lo] = 2.0f * (c * re + s * im);
+        out[hi] = 2.0f * (s * re - c * im);
+    }
+
+    out[N/2 - (dst ? 1 : 0)] = 2.0f * t[N] * buf[N];
+}
+
+static FFTS_INLINE void
+ffts_dct3(ffts_plan_t *p, const float *FFTS_RESTRICT in,
+          float *FFTS_RESTRICT out, float *FFTS_RESTRICT buf, void *scratch,
+          int dst)
+{
+    const float *FFTS_RESTRICT t = (const float*) FFTS_ASSUME_ALIGNED_32(p->A);
+    const size_t N = p->N;
+    const float odd = dst ? -1.0f : 1.0f;
+    size_t k;
+    float c, s, a, b;
+
+    /* the DST transforms the input backwards */
+    buf[0] = in[dst ? N - 1 : 0];
+    buf[1] = 0.0f;
+
+    for (k = 1; k < N/2; k++) {
+        c = t[2*k + 0];
+        s = t[2*k + 1];
+        a = in[dst ? N - 1 - k : k];
+        b = in[dst ? k - 1 : N - k];
+
+        buf[2*k + 0] = c * a + s * b;
+        buf[2*k + 1] = s * a - c * b;
+    }
+
+    buf[N + 0] = 2.0f * t[N] * in[N/2 - (dst ? 1 : 0)];
+    buf[N + 1] = 0.0f;
+
+    ffts_sub_transform(p, p->plans[0], buf, buf, scratch);
+
+    for (k = 0; k < N/2; k++) {
+        out[2*k] = buf[k];
+        out[2*k + 1] = odd * buf[N - 1 - k];
+    }
+}
+
+static void
+ffts_execute_dct2_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_dct2(p, (const float*) in, (float*) out,
+        (float*) (scratch ? scratch : p->buf), scratch, 0);
+}
+
+static void
+ffts_execute_dct2(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_dct2_scratch(p, in, out, NULL);
+}
+
+static void
+ffts_execute_dst2_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_dct2(p, (const float*) in, (float*) out,
+        (float*) (scratch ? scratch : p->buf), scratch, 1);
+}
+
+static void
+ffts_execute_dst2(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_dst2_scratch(p, in, out, NULL);
+}
+
+static void
+ffts_execute_dct3_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_dct3(p, (const float*) in, (float*) out,
+        (float*) (scratch ? scratch : p->buf), scratch, 0);
+}
+
+static void
+ffts_execute_dct3(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_dct3_scratch(p, in, out, NULL);
+}
+
+static void
+ffts_execute_dst3_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_dct3(p, (const float*) in, (float*) out,
+        (float*) (scratch ? scratch : p->buf), scratch, 1);
+}
+
+static void
+ffts_execute_dst3(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_dst3_scratch(p, in, out, NULL);
+}
+
+static ffts_plan_t*
+ffts_init_1d_r2r(size_t N, int type, int dst)
+{
+    ffts_plan_t *p;
+    size_t k;
+
+    if (type != 2 && type != 3) {
+        LOG("DCT and DST type must be 2 or 3\n");
+        return NULL;
+    }
+
+    /* the real FFT of N points needs N >= 4 */
+    if (N < 4 || (N & (N - 1)) != 0) {
+        LOG("DCT and DST size must be a power of two of at least 4\n");
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    if (type == 2) {
+        p->transform = dst ? &ffts_execute_dst2 : &ffts_execute_dct2;
+        p->transform_scratch = dst ?
+            &ffts_execute_dst2_scratch : &ffts_execute_dct2_scratch;
+    } else {
+        p->transform = dst ? &ffts_execute_dst3 : &ffts_execute_dct3;
+        p->transform_scratch = dst ?
+            &ffts_execute_dst3_scratch : &ffts_execute_dct3_scratch;
+    }
+
+    p->destroy = &ffts_free_1d_r2r;
+    p->N       = N;
+    p->rank    = 1;
+    p->plans   = (ffts_plan_t**) &p[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*p->plans);
+
+    p->plans[0] = ffts_init_1d_real(N, type == 2 ? FFTS_FORWARD : FFTS_BACKWARD);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    p->buf = ffts_mem_alloc(&p->allocator, (N + 2) * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+    p->scratch_bytes = (N + 2) * sizeof(float);
+
+    /* cos and sin of pi * k / (2 * N) */
+    p->A = (float*) ffts_mem_alloc(&p->allocator, (N + 2) * sizeof(float),
+        FFTS_MEM_TABLES);
+    if (!p->A) {
+        goto cleanup;
+    }
+    p->table_bytes = (N + 2) * sizeof(float);
+
+    for (k = 0; k <= N/2; k++) {
+        ffts_cexp_32f(k, 4 * N, p->A + 2*k);
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_1d_r2r(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_dct(size_t N, int type)
+{
+    return ffts_init_1d_r2r(N, type, 0);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_dst(size_t N, int type)
+{
+    return ffts_init_1d_r2r(N, type, 1);
+}
+
+/* multi-dimensional transforms apply the 1D transform along every
+   dimension in turn, as ffts_init_nd does */
+static void
+ffts_free_nd_r2r(ffts_plan_t *p)
+{
+    if (p->plans) {
+        int i, j;
+
+        for (i = 0; i < p->rank; i++) {
+            ffts_plan_t *plan = p->plans[i];
+
+            if (plan) {
+                for (j = 0; j < i; j++) {
+                    if (p->Ns[i] == p->Ns[j]) {
+                        plan = NULL;
+                        break;
+                    }
+                }
+
+                if (plan) {
+                    ffts_free(plan);
+                }
+            }
+        }
+
+        ffts_mem_free(&p->allocator, p->plans, FFTS_MEM_PLAN);
+    }
+
+    if (p->Ns) {
+        ffts_mem_free(&p->allocator, p->Ns, FFTS_MEM_PLAN);
+    }
+
+    if (p->Ms) {
+        ffts_mem_free(&p->allocator, p->Ms, FFTS_MEM_PLAN);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+static void
+ffts_execute_nd_r2r_scratch(ffts_plan_t *p, const void *in, void *out,
+                            void *scratch)
+{
+    const float *din = (const float*) in;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    float *dout = (float*) out;
+    ffts_plan_t *plan;
+    int i;
+    size_t j;
+
+    for (i = 0; i < p->rank; i++) {
+        plan = p->plans[i];
+
+        for (j = 0; j < p->Ms[i]; j++) {
+            ffts_sub_transform(p, plan, din + j * p->Ns[i],
+                buf + j * p->Ns[i], scratch);
+        }
+
+        ffts_transpose_32f(buf, dout, p->Ns[i], p->Ms[i]);
+        din = dout;
+    }
+}
+
+static void
+ffts_execute_nd_r2r(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_nd_r2r_scratch(p, in, out, NULL);
+}
+
+static ffts_plan_t*
+ffts_init_nd_r2r(int rank, size_t *Ns, int type, int dst)
+{
+    ffts_plan_t *p;
+    size_t vol = 1;
+    int i, j;
+
+    if (!Ns || rank < 1) {
+        return NULL;
+    }
+
+    if (rank == 1) {
+        return ffts_init_1d_r2r(Ns[0], type, dst);
+    }
+
+    p = ffts_plan_alloc(sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+
+    p->transform = &ffts_execute_nd_r2r;
+    p->transform_scratch = &ffts_execute_nd_r2r_scratch;
+    p->destroy   = &ffts_free_nd_r2r;
+    p->rank      = rank;
+
+    p->Ms = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ms), FFTS_MEM_PLAN);
+    if (!p->Ms) {
+        goto cleanup;
+    }
+
+    p->Ns = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ns), FFTS_MEM_PLAN);
+    if (!p->Ns) {
+        goto cleanup;
+    }
+
+    /* reverse the order */
+    for (i = 0; i < rank; i++) {
+        size_t N = Ns[rank - i - 1];
+        p->Ns[i] = N;
+        vol *= N;
+    }
+
+    p->buf = ffts_mem_alloc(&p->allocator, vol * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    p->plans = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->plans),
+        FFTS_MEM_PLAN);
+    if (!p->plans) {
+        goto cleanup;
+    }
+    memset(p->plans, 0, rank * sizeof(*p->plans));
+
+    p->scratch_bytes = vol * sizeof(float);
+    p->plan_bytes = sizeof(*p) + rank * (sizeof(*p->Ms) + sizeof(*p->Ns) +
+        sizeof(*p->plans));
+
+    for (i = 0; i < rank; i++) {
+        p->Ms[i] = vol / p->Ns[i];
+
+        for (j = 0; j < i; j++) {
+            if (p->Ns[i] == p->Ns[j]) {
+                p->plans[i] = p->plans[j];
+                break;
+            }
+        }
+
+        if (!p->plans[i]) {
+            p->plans[i] = ffts_init_1d_r2r(p->Ns[i], type, dst);
+            if (!p->plans[i]) {
+                goto cleanup;
+            }
+        }
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_nd_r2r(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_nd_dct(int rank, size_t *Ns, int type)
+{
+    return ffts_init_nd_r2r(rank, Ns, type, 0);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_nd_dst(int rank, size_t *Ns, int type)
+{
+    return ffts_init_nd_r2r(rank, Ns, type, 1);
+}
@@ -0,0 +1,491 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_half.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_static.h"
+
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#elif HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* F16C conversions are compiled for that instruction set alone and
+   run when the cpu has it, the rest of the library keeping to SSE2 */
+#if defined(HAVE_SSE2) && (GCC_VERSION_AT_LEAST(4,9) || defined(__clang__))
+#define HAVE_F16C
+#include <cpuid.h>
+#include <immintrin.h>
+#define FFTS_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+/* NEON of ARMv8 and of ARMv7 with the half precision extension */
+#if defined(HAVE_NEON) && defined(__ARM_FP) && (__ARM_FP & 2)
+#define HAVE_NEON_FP16
+#endif
+
+/* Transforms of IEEE half precision (FFTS_FP16) or bfloat16 (FFTS_BF16)
+   input and/or output. Without dynamic code (DYNAMIC_DISABLED), the first
+   and last passes of the static transform of complex plans convert the
+   formats of ffts_static_half_format as they load and store them. As for
+   integer input, the generated code cannot convert at its scattered loads
+   and stores, so otherwise, for real plans, and for FP16 dispatched to
+   F16C at run time, the plan converts, eight values at a time, between
+   the caller's arrays and its work buffers, from and to which the float
+   plan transforms out of place. Conversions to half floats round to
+   nearest even, keeping infinities and NaNs. The conversions are also
+   exported for arrays of any alignment.
+*/
+
+typedef union {
+    float f;
+    uint32_t u;
+} ffts_float_bits;
+
+/* private state of half precision plans */
+typedef struct _ffts_half_state_t {
+    /* floats per transform, and storage formats, of input and output */
+    size_t in_size, out_size;
+    int in_format, out_format;
+} ffts_half_state_t;
+
+static void
+ffts_free_half(ffts_plan_t *p)
+{
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+static uint16_t
+ffts_float_to_fp16(float f)
+{
+    ffts_float_bits x;
+    uint32_t sign;
+    uint16_t h;
+
+    x.f = f;
+    sign = x.u & 0x80000000;
+    x.u ^= sign;
+
+    if (x.u >= 0x47800000) {
+        /* overflow to infinity, or NaN made quiet */
+        h = (x.u > 0x7f800000) ? 0x7e00 : 0x7c00;
+    } else if (x.u < 0x38800000) {
+        /* subnormal or zero, rounded by a float addition */
+        ffts_float_bits magic;
+
+        magic.u = 0x3f000000;
+        x.f += magic.f;
+        h = (uint16_t) (x.u - magic.u);
+    } else {
+        x.u += 0xc8000fff + ((x.u >> 13) & 1);
+        h = (uint16_t) (x.u >> 13);
+    }
+
+    return h | (uint16_t) (sign >> 16);
+}
+
+static float
+ffts_fp16_to_float(uint16_t h)
+{
+    ffts_float_bits x;
+    uint32_t exp;
+
+    x.u = (uint32_t) (h & 0x7fff) << 13;
+    exp = x.u & 0x0f800000;
+    x.u += 0x38000000;
+
+    if (exp == 0x0f800000) {
+        /* infinity or NaN */
+        x.u += 0x38000000;
+    } else if (!exp) {
+        /* subnormal or zero, normalized by a float subtraction */
+        ffts_float_bits magic;
+
+        magic.u = 0x38800000;
+        x.u += 0x00800000;
+        x.f -= magic.f;
+    }
+
+    x.u |= (uint32_t) (h & 0x8000) << 16;
+    return x.f;
+}
+
+static uint16_t
+ffts_float_to_bf16(float f)
+{
+    ffts_float_bits x;
+
+    x.f = f;
+    if ((x.u & 0x7fffffff) > 0x7f800000) {
+        return (uint16_t) ((x.u >> 16) | 0x40);
+    }
+
+    return (uint16_t) ((x.u + 0x7fff + ((x.u >> 16) & 1)) >> 16);
+}
+
+#ifdef HAVE_F16C
+static int
+ffts_cpu_has_f16c(void)
+{
+    static int has_f16c = -1;
+
+    if (has_f16c < 0) {
+        unsigned int a, b, c, d;
+
+        /* VEX encoded, so the OS must save the AVX state */
+        has_f16c = __get_cpuid(1, &a, &b, &c, &d) && (c & bit_F16C) &&
+            __builtin_cpu_supports("avx");
+    }
+
+    return has_f16c;
+}
+
+static FFTS_TARGET_F16C size_t
+ffts_fp16_to_float_f16c(const uint16_t *FFTS_RESTRICT in,
+                        float *FFTS_RESTRICT out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 7 < n; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i*) (in + i));
+
+        _mm_storeu_ps(out + i + 0, _mm_cvtph_ps(h));
+        _mm_storeu_ps(out + i + 4, _mm_cvtph_ps(_mm_unpackhi_epi64(h, h)));
+    }
+
+    return i;
+}
+
+static FFTS_TARGET_F16C size_t
+ffts_float_to_fp16_f16c(const float *FFTS_RESTRICT in,
+                        uint16_t *FFTS_RESTRICT out, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i + 7 < n; i += 8) {
+        __m128i lo = _mm_cvtps_ph(_mm_loadu_ps(in + i + 0),
+            _MM_FROUND_TO_NEAREST_INT);
+        __m128i hi = _mm_cvtps_ph(_mm_loadu_ps(in + i + 4),
+            _MM_FROUND_TO_NEAREST_INT);
+
+        _mm_storeu_si128((__m128i*) (out + i), _mm_unpacklo_epi64(lo, hi));
+    }
+
+    return i;
+}
+#endif
+
+static void
+ffts_load_half(const uint16_t *FFTS_RESTRICT in, float *FFTS_RESTRICT out,
+               size_t n, int format)
+{
+    size_t i = 0;
+
+    if (format == FFTS_BF16) {
+        /* bfloat16 is the high half of a float */
+#ifdef HAVE_NEON
+        for (; i + 7 < n; i += 8) {
+            uint16x8_t h = vld1q_u16(in + i);
+
+            vst1q_f32(out + i + 0, vreinterpretq_f32_u32(
+                vshll_n_u16(vget_low_u16(h), 16)));
+            vst1q_f32(out + i + 4, vreinterpretq_f32_u32(
+                vshll_n_u16(vget_high_u16(h), 16)));
+        }
+#elif HAVE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 7 < n; i += 8) {
+            __m128i h = _mm_loadu_si128((const __m128i*) (in + i));
+
+            _mm_storeu_ps(out + i + 0,
+                _mm_castsi128_ps(_mm_unpacklo_epi16(zero, h)));
+            _mm_storeu_ps(out + i + 4,
+                _mm_castsi128_ps(_mm_unpackhi_epi16(zero, h)));
+        }
+#endif
+
+        for (; i < n; i++) {
+            ffts_float_bits x;
+
+            x.u = (uint32_t) in[i] << 16;
+            out[i] = x.f;
+        }
+    } else {
+#if defined(HAVE_NEON_FP16)
+        for (; i + 7 < n; i += 8) {
+            float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(in + i));
+
+            vst1q_f32(out + i + 0, vcvt_f32_f16(vget_low_f16(h)));
+            vst1q_f32(out + i + 4, vcvt_f32_f16(vget_high_f16(h)));
+        }
+#elif defined(HAVE_F16C)
+        if (ffts_cpu_has_f16c()) {
+            i = ffts_fp16_to_float_f16c(in, out, n);
+        }
+#endif
+
+        for (; i < n; i++) {
+            out[i] = ffts_fp16_to_float(in[i]);
+        }
+    }
+}
+
+static void
+ffts_store_half(const float *FFTS_RESTRICT in, uint16_t *FFTS_RESTRICT out,
+                size_t n, int format)
+{
+    size_t i = 0;
+
+    if (format == FFTS_BF16) {
+#ifdef HAVE_SSE2
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i half = _mm_set1_epi32(0x7fff);
+        const __m128i quiet = _mm_set1_epi32(0x00400000);
+        const __m128i abs = _mm_set1_epi32(0x7fffffff);
+        const __m128i inf = _mm_set1_epi32(0x7f800000);
+
+        /* round to nearest even, quieting NaNs instead, and shift
+           arithmetically so that packing with saturation keeps the bits */
+        for (; i + 7 < n; i += 8) {
+            __m128i a = _mm_castps_si128(_mm_loadu_ps(in + i + 0));
+            __m128i b = _mm_castps_si128(_mm_loadu_ps(in + i + 4));
+            __m128i na = _mm_cmpgt_epi32(_mm_and_si128(a, abs), inf);
+            __m128i nb = _mm_cmpgt_epi32(_mm_and_si128(b, abs), inf);
+            __m128i ra = _mm_add_epi32(_mm_add_epi32(a, half),
+                _mm_and_si128(_mm_srli_epi32(a, 16), one));
+            __m128i rb = _mm_add_epi32(_mm_add_epi32(b, half),
+                _mm_and_si128(_mm_srli_epi32(b, 16), one));
+
+            ra = _mm_or_si128(_mm_and_si128(na, _mm_or_si128(a, quiet)),
+                _mm_andnot_si128(na, ra));
+            rb = _mm_or_si128(_mm_and_si128(nb, _mm_or_si128(b, quiet)),
+                _mm_andnot_si128(nb, rb));
+
+            _mm_storeu_si128((__m128i*) (out + i), _mm_packs_epi32(
+                _mm_srai_epi32(ra, 16), _mm_srai_epi32(rb, 16)));
+        }
+#endif
+
+        for (; i < n; i++) {
+            out[i] = ffts_float_to_bf16(in[i]);
+        }
+    } else {
+#if defined(HAVE_NEON_FP16)
+        for (; i + 7 < n; i += 8) {
+            float16x4_t lo = vcvt_f16_f32(vld1q_f32(in + i + 0));
+            float16x4_t hi = vcvt_f16_f32(vld1q_f32(in + i + 4));
+
+            vst1q_u16(out + i, vreinterpretq_u16_f16(vcombine_f16(lo, hi)));
+        }
+#elif defined(HAVE_F16C)
+        if (ffts_cpu_has_f16c()) {
+            i = ffts_float_to_fp16_f16c(in, out, n);
+        }
+#endif
+
+        for (; i < n; i++) {
+            out[i] = ffts_float_to_fp16(in[i]);
+        }
+    }
+}
+
+/* whether the first and last passes of the float plan convert the input
+   and output */
+static int
+ffts_half_fused(const ffts_plan_t *sub, int in_format, int out_format)
+{
+#if defined(DYNAMIC_DISABLED) && !defined(HAVE_NEON)
+    return (sub->transform == ffts_static_transform_f_32f ||
+        sub->transform == ffts_static_transform_i_32f) &&
+        ffts_static_half_format(in_format) &&
+        ffts_static_half_format(out_format);
+#else
+    (void) sub;
+    (void) in_format;
+    (void) out_format;
+    return 0;
+#endif
+}
+
+static void
+ffts_execute_half_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    const ffts_half_state_t *s = (const ffts_half_state_t*) p->state;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    const void *src = in;
+    void *dst = out;
+
+#if defined(DYNAMIC_DISABLED) && !defined(HAVE_NEON)
+    if (ffts_half_fused(p->plans[0], s->in_format, s->out_format)) {
+        ffts_static_transform_half_32f(p->plans[0], in, out, buf,
+            p->plans[0]->transform == ffts_static_transform_i_32f,
+            s->in_format, s->out_format);
+        return;
+    }
+#endif
+
+    if (s->in_format != FFTS_FLOAT) {
+        ffts_load_half((const uint16_t*) in, buf, s->in_size, s->in_format);
+        src = buf;
+        buf += FFTS_SCRATCH_ALIGN(s->in_size * sizeof(float)) / sizeof(float);
+    }
+
+    if (s->out_format != FFTS_FLOAT) {
+        dst = buf;
+    }
+
+    ffts_sub_transform(p, p->plans[0], src, dst, scratch);
+
+    if (s->out_format != FFTS_FLOAT) {
+        ffts_store_half(buf, (uint16_t*) out, s->out_size, s->out_format);
+    }
+}
+
+static void
+ffts_execute_half(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_half_scratch(p, in, out, NULL);
+}
+
+static int
+ffts_half_format(int format)
+{
+    return format == FFTS_FLOAT || format == FFTS_FP16 ||
+        format == FFTS_BF16;
+}
+
+static ffts_plan_t*
+ffts_init_half(size_t N, int sign, int in_format, int out_format, int real)
+{
+    ffts_half_state_t *s;
+    ffts_plan_t *p;
+
+    if (!ffts_half_format(in_format) || !ffts_half_format(out_format)) {
+        LOG("half precision formats must be FFTS_FLOAT, FFTS_FP16 or "
+            "FFTS_BF16\n");
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_half_state_t*) &p[1];
+
+    p->transform = &ffts_execute_half;
+    p->transform_scratch = &ffts_execute_half_scratch;
+    p->destroy   = &ffts_free_half;
+    p->N         = N;
+    p->rank      = 1;
+    p->state     = s;
+    p->plans     = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + sizeof(*p->plans);
+
+    s->in_format  = in_format;
+    s->out_format = out_format;
+
+    /* real transforms take or give N / 2 + 1 complex values */
+    if (!real) {
+        s->in_size = s->out_size = 2 * N;
+    } else if (sign == FFTS_FORWARD) {
+        s->in_size = N;
+        s->out_size = N + 2;
+    } else {
+        s->in_size = N + 2;
+        s->out_size = N;
+    }
+
+    p->plans[0] = real ? ffts_init_1d_real(N, sign) : ffts_init_1d(N, sign);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    if (in_format != FFTS_FLOAT &&
+        !ffts_half_fused(p->plans[0], in_format, out_format)) {
+        p->scratch_bytes += FFTS_SCRATCH_ALIGN(s->in_size * sizeof(float));
+    }
+
+    if (out_format != FFTS_FLOAT) {
+        p->scratch_bytes += s->out_size * sizeof(float);
+    }
+
+    if (p->scratch_bytes) {
+        p->buf = ffts_mem_alloc(&p->allocator, p->scratch_bytes,
+            FFTS_MEM_SCRATCH);
+        if (!p->buf) {
+            goto cleanup;
+        }
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_half(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_half(size_t N, int sign, int in_format, int out_format)
+{
+    return ffts_init_half(N, sign, in_format, out_format, 0);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_real_half(size_t N, int sign, int in_format, int out_format)
+{
+    return ffts_init_half(N, sign, in_format, out_format, 1);
+}
+
+FFTS_API void
+ffts_float_to_half(const float *in, void *out, size_t n, int format)
+{
+    ffts_store_half(in, (uint16_t*) out, n, format);
+}
+
+FFTS_API void
+ffts_half_to_float(const void *in, float *out, size_t n, int format)
+{
+    ffts_load_half((const uint16_t*) in, out, n, format);
+}
@@ -0,0 +1,277 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_int.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_static.h"
+
+#ifdef HAVE_NEON
+#include <arm_neon.h>
+#elif HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Transforms of 16 or 8 bit integer input. Without dynamic code
+   (DYNAMIC_DISABLED), the first pass of the static transform of complex
+   plans converts the samples as it loads them. The generated code loads
+   its input at scattered offsets and cannot convert it, so otherwise, and
+   for real plans, the samples are converted, sixteen at a time, into the
+   work buffer of the plan, from which the float plan reads out of place.
+   Up to the size of the caches, the floats never leave them: the input
+   is read once at half or a quarter of the bandwidth of floats, instead
+   of the caller converting to a float array and the transform reading it
+   again.
+*/
+
+/* private state of integer input plans */
+typedef struct _ffts_int_state_t {
+    size_t size; /* values per transform */
+    float scale;
+    int format;
+} ffts_int_state_t;
+
+static void
+ffts_free_int(ffts_plan_t *p)
+{
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+static void
+ffts_convert_int16(const int16_t *FFTS_RESTRICT in, float *FFTS_RESTRICT out,
+                   size_t n, float scale)
+{
+    size_t i = 0;
+
+#ifdef HAVE_NEON
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    for (; i + 15 < n; i += 16) {
+        int16x8_t a = vld1q_s16(in + i);
+        int16x8_t b = vld1q_s16(in + i + 8);
+
+        vst1q_f32(out + i +  0, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(a)))));
+        vst1q_f32(out + i +  4, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(a)))));
+        vst1q_f32(out + i +  8, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(b)))));
+        vst1q_f32(out + i + 12, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(b)))));
+    }
+#elif HAVE_SSE2
+    const __m128 s = _mm_set1_ps(scale);
+
+    /* sign extension by unpacking to the high halves and shifting */
+    for (; i + 15 < n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (in + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (in + i + 8));
+
+        _mm_store_ps(out + i +  0, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16))));
+        _mm_store_ps(out + i +  4, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16))));
+        _mm_store_ps(out + i +  8, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16))));
+        _mm_store_ps(out + i + 12, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16))));
+    }
+#endif
+
+    for (; i < n; i++) {
+        out[i] = scale * (float) in[i];
+    }
+}
+
+static void
+ffts_convert_int8(const int8_t *FFTS_RESTRICT in, float *FFTS_RESTRICT out,
+                  size_t n, float scale)
+{
+    size_t i = 0;
+
+#ifdef HAVE_NEON
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    for (; i + 15 < n; i += 16) {
+        int8x16_t a = vld1q_s8(in + i);
+        int16x8_t lo = vmovl_s8(vget_low_s8(a));
+        int16x8_t hi = vmovl_s8(vget_high_s8(a));
+
+        vst1q_f32(out + i +  0, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo)))));
+        vst1q_f32(out + i +  4, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo)))));
+        vst1q_f32(out + i +  8, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi)))));
+        vst1q_f32(out + i + 12, vmulq_f32(s,
+            vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi)))));
+    }
+#elif HAVE_SSE2
+    const __m128 s = _mm_set1_ps(scale);
+
+    for (; i + 15 < n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (in + i));
+        __m128i lo = _mm_unpacklo_epi8(a, a);
+        __m128i hi = _mm_unpackhi_epi8(a, a);
+
+        _mm_store_ps(out + i +  0, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 24))));
+        _mm_store_ps(out + i +  4, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 24))));
+        _mm_store_ps(out + i +  8, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 24))));
+        _mm_store_ps(out + i + 12, _mm_mul_ps(s, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 24))));
+    }
+#endif
+
+    for (; i < n; i++) {
+        out[i] = scale * (float) in[i];
+    }
+}
+
+/* whether the first pass of the float plan converts the input */
+static int
+ffts_int_fused(const ffts_plan_t *sub)
+{
+#if defined(DYNAMIC_DISABLED) && !defined(HAVE_NEON)
+    return sub->transform == ffts_static_transform_f_32f ||
+        sub->transform == ffts_static_transform_i_32f;
+#else
+    (void) sub;
+    return 0;
+#endif
+}
+
+static void
+ffts_execute_int_scratch(ffts_plan_t *p, const void *in, void *out,
+                         void *scratch)
+{
+    const ffts_int_state_t *s = (const ffts_int_state_t*) p->state;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+
+#if defined(DYNAMIC_DISABLED) && !defined(HAVE_NEON)
+    if (ffts_int_fused(p->plans[0])) {
+        ffts_static_transform_int_32f(p->plans[0], in, out,
+            p->plans[0]->transform == ffts_static_transform_i_32f,
+            s->format, s->scale);
+        return;
+    }
+#endif
+
+    if (s->format == FFTS_INT8) {
+        ffts_convert_int8((const int8_t*) in, buf, s->size, s->scale);
+    } else {
+        ffts_convert_int16((const int16_t*) in, buf, s->size, s->scale);
+    }
+
+    ffts_sub_transform(p, p->plans[0], buf, out, scratch);
+}
+
+static void
+ffts_execute_int(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_int_scratch(p, in, out, NULL);
+}
+
+static ffts_plan_t*
+ffts_init_int(size_t N, int sign, int format, float scale, int real)
+{
+    ffts_int_state_t *s;
+    ffts_plan_t *p;
+
+    if (format != FFTS_INT16 && format != FFTS_INT8) {
+        LOG("integer input must be FFTS_INT16 or FFTS_INT8\n");
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_int_state_t*) &p[1];
+
+    p->transform = &ffts_execute_int;
+    p->transform_scratch = &ffts_execute_int_scratch;
+    p->destroy = &ffts_free_int;
+    p->N       = N;
+    p->rank    = 1;
+    p->state   = s;
+    p->plans   = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + sizeof(*p->plans);
+
+    s->size   = real ? N : 2 * N;
+    s->scale  = scale;
+    s->format = format;
+
+    p->plans[0] = real ? ffts_init_1d_real(N, FFTS_FORWARD) :
+        ffts_init_1d(N, sign);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    if (!ffts_int_fused(p->plans[0])) {
+        p->scratch_bytes = s->size * sizeof(float);
+        p->buf = ffts_mem_alloc(&p->allocator, p->scratch_bytes,
+            FFTS_MEM_SCRATCH);
+        if (!p->buf) {
+            goto cleanup;
+        }
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_int(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_int(size_t N, int sign, int format, float scale)
+{
+    return ffts_init_int(N, sign, format, scale, 0);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_real_int(size_t N, int format, float scale)
+{
+    return ffts_init_int(N, FFTS_FORWARD, format, scale, 1);
+}
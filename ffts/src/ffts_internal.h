@@ -39,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "config.h"
 #endif
 
+#include "ffts.h"
 #include "ffts_attributes.h"
 #include "types.h"
 
@@ -99,7 +100,26 @@ extern void *valloc(size_t);
 #endif
 
 struct _ffts_plan_t;
+
+typedef struct _ffts_allocator_t {
+    ffts_alloc_func_t alloc; /* NULL for ffts_aligned_malloc */
+    ffts_free_func_t free;
+    void *user;
+
+    /* regions mapped by the default allocator */
+    struct _ffts_map *maps;
+    size_t huge_bytes;
+
+    int node; /* NUMA node of the tables, scratch and code, or -1 */
+} ffts_allocator_t;
+
 typedef void (*transform_func_t)(struct _ffts_plan_t *p, const void *in, void *out);
+typedef void (*transform_scratch_func_t)(struct _ffts_plan_t *p,
+    const void *in, void *out, void *scratch);
+
+/* caller-owned scratch is split into 32 byte aligned parts,
+   the work buffers of a plan followed by those of its sub-plans */
+#define FFTS_SCRATCH_ALIGN(n) (((n) + 31) & ~((size_t) 31))
 
 /**
  * Contains all the Information need to perform FFT
@@ -200,8 +220,61 @@ struct _ffts_plan_t {
     float *A, *B;
 
     size_t i2;
+
+    /**
+     * Bytes allocated by this plan (not by its sub-plans)
+     * for lookup tables, work buffers and bookkeeping
+     */
+    size_t table_bytes;
+    size_t scratch_bytes;
+    size_t plan_bytes;
+
+    /**
+     * Same as transform, but keeping its work buffers in scratch
+     * instead of buf when scratch is not NULL; NULL for plans
+     * without work buffers
+     */
+    transform_scratch_func_t transform_scratch;
+
+    /**
+     * Allocator of this plan and its tables, captured at creation
+     */
+    ffts_allocator_t allocator;
+
+    /**
+     * Twiddle factors stored once each instead of as broadcast
+     * real and imaginary vectors (x86 generated code only)
+     */
+    int compact_luts;
+
+    /**
+     * Direction of the transform, for plans that compute
+     * their twiddle factors while executing
+     */
+    int sign;
+
+    /**
+     * Private state of plans of convolution, STFT, channelizer, integer
+     * and half precision input and sliding DFT, laid out by the source
+     * file of each kind; it follows the plan in its allocation
+     */
+    void *state;
 };
 
+/* run a sub-plan with the scratch that follows the work buffers of p,
+   or with its own buffers if scratch is NULL */
+static FFTS_INLINE void
+ffts_sub_transform(struct _ffts_plan_t *p, struct _ffts_plan_t *sub,
+                   const void *in, void *out, void *scratch)
+{
+    if (scratch && sub->transform_scratch) {
+        sub->transform_scratch(sub, in, out,
+            (char*) scratch + FFTS_SCRATCH_ALIGN(p->scratch_bytes));
+    } else {
+        sub->transform(sub, in, out);
+    }
+}
+
 static FFTS_INLINE void*
 ffts_aligned_malloc(size_t size)
 {
@@ -34,8 +34,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ffts_nd.h"
 #include "ffts_internal.h"
+#include "ffts_alloc.h"
 #include "ffts_transpose.h"
 
+#include <string.h>
+
 static void
 ffts_free_nd(ffts_plan_t *p)
 {
@@ -59,29 +62,29 @@ ffts_free_nd(ffts_plan_t *p)
             }
         }
 
-        free(p->plans);
+        ffts_mem_free(&p->allocator, p->plans, FFTS_MEM_PLAN);
     }
 
     if (p->Ns) {
-        free(p->Ns);
+        ffts_mem_free(&p->allocator, p->Ns, FFTS_MEM_PLAN);
     }
 
     if (p->Ms) {
-        free(p->Ms);
+        ffts_mem_free(&p->allocator, p->Ms, FFTS_MEM_PLAN);
     }
 
     if (p->buf) {
-        ffts_aligned_free(p->buf);
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
     }
 
-    free(p);
+    ffts_plan_release(p);
 }
 
 static void
-ffts_execute_nd(ffts_plan_t *p, const void *in, void *out)
+ffts_execute_nd_scratch(ffts_plan_t *p, const void *in, void *out, void *scratch)
 {
     uint64_t *din = (uint64_t*) in;
-    uint64_t *buf = p->buf;
+    uint64_t *buf = (uint64_t*) (scratch ? scratch : p->buf);
     uint64_t *dout = (uint64_t*) out;
 
     ffts_plan_t *plan;
@@ -90,7 +93,8 @@ ffts_execute_nd(ffts_plan_t *p, const void *in, void *out)
 
     plan = p->plans[0];
     for (j = 0; j < p->Ms[0]; j++) {
-        plan->transform(plan, din + (j * p->Ns[0]), buf + (j * p->Ns[0]));
+        ffts_sub_transform(p, plan, din + (j * p->Ns[0]),
+            buf + (j * p->Ns[0]), scratch);
     }
 
     ffts_transpose(buf, dout, p->Ns[0], p->Ms[0]);
@@ -99,13 +103,20 @@ ffts_execute_nd(ffts_plan_t *p, const void *in, void *out)
         plan = p->plans[i];
 
         for (j = 0; j < p->Ms[i]; j++) {
-            plan->transform(plan, dout + (j * p->Ns[i]), buf + (j * p->Ns[i]));
+            ffts_sub_transform(p, plan, dout + (j * p->Ns[i]),
+                buf + (j * p->Ns[i]), scratch);
         }
 
         ffts_transpose(buf, dout, p->Ns[i], p->Ms[i]);
     }
 }
 
+static void
+ffts_execute_nd(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_nd_scratch(p, in, out, NULL);
+}
+
 FFTS_API ffts_plan_t*
 ffts_init_nd(int rank, size_t *Ns, int sign)
 {
@@ -121,21 +132,22 @@ ffts_init_nd(int rank, size_t *Ns, int sign)
          return ffts_init_1d(Ns[0], sign);
     }
 
-    p = calloc(1, sizeof(*p));
+    p = ffts_plan_alloc(sizeof(*p));
     if (!p) {
         return NULL;
     }
 
     p->transform = &ffts_execute_nd;
+    p->transform_scratch = &ffts_execute_nd_scratch;
     p->destroy   = &ffts_free_nd;
     p->rank      = rank;
 
-    p->Ms = malloc(rank * sizeof(*p->Ms));
+    p->Ms = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ms), FFTS_MEM_PLAN);
     if (!p->Ms) {
         goto cleanup;
     }
 
-    p->Ns = malloc(rank * sizeof(*p->Ns));
+    p->Ns = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ns), FFTS_MEM_PLAN);
     if (!p->Ns) {
         goto cleanup;
     }
@@ -147,15 +159,22 @@ ffts_init_nd(int rank, size_t *Ns, int sign)
         vol *= N;
     }
 
-    p->buf = ffts_aligned_malloc(2 * vol * sizeof(float));
+    p->buf = ffts_mem_alloc(&p->allocator, 2 * vol * sizeof(float),
+        FFTS_MEM_SCRATCH);
     if (!p->buf) {
         goto cleanup;
     }
 
-    p->plans = calloc(rank, sizeof(*p->plans));
+    p->plans = ffts_mem_alloc(&p->allocator, rank * sizeof(*p->plans),
+        FFTS_MEM_PLAN);
     if (!p->plans) {
         goto cleanup;
     }
+    memset(p->plans, 0, rank * sizeof(*p->plans));
+
+    p->scratch_bytes = 2 * vol * sizeof(float);
+    p->plan_bytes = sizeof(*p) + rank * (sizeof(*p->Ms) + sizeof(*p->Ns) +
+        sizeof(*p->plans));
 
     for (i = 0; i < rank; i++) {
         p->Ms[i] = vol / p->Ns[i];
@@ -0,0 +1,314 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_ooc.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_otf.h"
+#include "ffts_transpose.h"
+
+#include <string.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(MADV_WILLNEED) && defined(MS_ASYNC)
+#define HAVE_OOC_HINTS
+#endif
+
+/* work buffers of plans created with mem_size 0 */
+#define FFTS_OOC_DEFAULT_MEMORY ((size_t) 64 << 20)
+
+/* smallest block of columns, as ffts_transpose moves 8 x 8 tiles */
+#define FFTS_OOC_MIN_BLOCK 8
+
+/* Tell the system about rows of width complex values, stride apart:
+   read-ahead of rows about to be gathered, or write-back of rows just
+   scattered, so that the I/O of a mapped file overlaps the transforms
+   of the current block */
+static void
+ffts_ooc_hint(const float *base, size_t rows, size_t stride, size_t width,
+              int write)
+{
+#ifdef HAVE_OOC_HINTS
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t bytes = 2 * width * sizeof(*base);
+    uintptr_t start, end, offset;
+    size_t j;
+
+    /* contiguous rows are a single range */
+    if (width == stride) {
+        width *= rows;
+        rows = 1;
+    } else if (bytes < page) {
+        /* rows narrower than a page share it with the next blocks: hint
+           the pages when the first block reads them, or when the last
+           block has written them */
+        offset = (uintptr_t) base & (page - 1);
+        if (write ? ((offset + bytes) & (page - 1)) != 0 : offset != 0) {
+            return;
+        }
+    }
+
+    for (j = 0; j < rows; j++) {
+        start = (uintptr_t) (base + 2 * j * stride) & ~(uintptr_t) (page - 1);
+        end = (uintptr_t) (base + 2 * (j * stride + width));
+
+        /* errors only mean that the hint was not taken */
+        if (write) {
+            msync((void*) start, end - start, MS_ASYNC);
+        } else {
+            madvise((void*) start, end - start, MADV_WILLNEED);
+        }
+    }
+#else
+    (void) base;
+    (void) rows;
+    (void) stride;
+    (void) width;
+    (void) write;
+#endif
+}
+
+static void
+ffts_free_ooc(ffts_plan_t *p)
+{
+    if (p->plans) {
+        if (p->plans[0]) {
+            ffts_free(p->plans[0]);
+        }
+
+        if (p->plans[1] && p->plans[1] != p->plans[0]) {
+            ffts_free(p->plans[1]);
+        }
+
+        ffts_mem_free(&p->allocator, p->plans, FFTS_MEM_PLAN);
+    }
+
+    if (p->Ns) {
+        ffts_mem_free(&p->allocator, p->Ns, FFTS_MEM_PLAN);
+    }
+
+    if (p->Ms) {
+        ffts_mem_free(&p->allocator, p->Ms, FFTS_MEM_PLAN);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+/* Four-step schedule with N = N1 * N2 and x[n1 * N2 + n2], in which
+   every pass streams through the arrays in blocks of whole columns:
+   transforms of size N1 over blocks of Ms[0] columns of the input,
+   twiddled into rows of the output, then transforms of size N2 over
+   blocks of Ms[1] columns of the output, in place */
+static void
+ffts_execute_ooc_scratch(ffts_plan_t *p, const void *in, void *out, void *scratch)
+{
+    const float *din = (const float*) in;
+    float *dout = (float*) out;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    float *buf2;
+    size_t N1 = p->Ns[0], N2 = p->Ns[1];
+    size_t B1 = p->Ms[0], B2 = p->Ms[1];
+    size_t c, b, j;
+
+    buf2 = buf + 2 * (N1 * B1 > N2 * B2 ? N1 * B1 : N2 * B2);
+
+    ffts_ooc_hint(din, N1, N2, B1, 0);
+
+    for (c = 0; c < N2; c += B1) {
+        for (j = 0; j < N1; j++) {
+            memcpy(buf + 2 * j * B1, din + 2 * (j * N2 + c),
+                2 * B1 * sizeof(*buf));
+        }
+
+        if (c + B1 < N2) {
+            ffts_ooc_hint(din + 2 * (c + B1), N1, N2, B1, 0);
+        }
+
+        ffts_transpose((uint64_t*) buf, (uint64_t*) buf2, (int) B1, (int) N1);
+
+        for (b = 0; b < B1; b++) {
+            ffts_sub_transform(p, p->plans[0], buf2 + 2 * b * N1,
+                buf + 2 * b * N1, scratch);
+            ffts_otf_twiddle(dout + 2 * (c + b) * N1, buf + 2 * b * N1, N1,
+                c + b, p->N, p->sign);
+        }
+
+        ffts_ooc_hint(dout + 2 * c * N1, B1, N1, N1, 1);
+    }
+
+    ffts_ooc_hint(dout, N2, N1, B2, 0);
+
+    for (c = 0; c < N1; c += B2) {
+        for (j = 0; j < N2; j++) {
+            memcpy(buf + 2 * j * B2, dout + 2 * (j * N1 + c),
+                2 * B2 * sizeof(*buf));
+        }
+
+        if (c + B2 < N1) {
+            ffts_ooc_hint(dout + 2 * (c + B2), N2, N1, B2, 0);
+        }
+
+        ffts_transpose((uint64_t*) buf, (uint64_t*) buf2, (int) B2, (int) N2);
+
+        for (b = 0; b < B2; b++) {
+            ffts_sub_transform(p, p->plans[1], buf2 + 2 * b * N2,
+                buf + 2 * b * N2, scratch);
+        }
+
+        ffts_transpose((uint64_t*) buf, (uint64_t*) buf2, (int) N2, (int) B2);
+
+        for (j = 0; j < N2; j++) {
+            memcpy(dout + 2 * (j * N1 + c), buf2 + 2 * j * B2,
+                2 * B2 * sizeof(*buf));
+        }
+
+        ffts_ooc_hint(dout + 2 * c, N2, N1, B2, 1);
+    }
+}
+
+static void
+ffts_execute_ooc(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_ooc_scratch(p, in, out, NULL);
+}
+
+/* largest power of two block of columns of height h whose two buffers
+   fit in mem_size, at least FFTS_OOC_MIN_BLOCK and at most w */
+static size_t
+ffts_ooc_block(size_t h, size_t w, size_t mem_size)
+{
+    size_t B = FFTS_OOC_MIN_BLOCK;
+
+    while (2 * B <= w && 2 * (2 * B) * h * 2 * sizeof(float) <= mem_size) {
+        B *= 2;
+    }
+
+    return B;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_ooc(size_t N, int sign, size_t mem_size)
+{
+    ffts_plan_t *p;
+    size_t size;
+    int log_N;
+
+    /* both passes move blocks of at least 8 columns of 8 rows or more */
+    if ((N & (N - 1)) != 0 || N < 64) {
+        LOG("FFT size must be a power of two of at least 64\n");
+        return NULL;
+    }
+
+    if (!mem_size) {
+        mem_size = FFTS_OOC_DEFAULT_MEMORY;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+
+    p->transform = &ffts_execute_ooc;
+    p->transform_scratch = &ffts_execute_ooc_scratch;
+    p->destroy   = &ffts_free_ooc;
+    p->rank      = 2;
+    p->N         = N;
+    p->sign      = sign;
+
+    p->Ns = ffts_mem_alloc(&p->allocator, 2 * sizeof(*p->Ns), FFTS_MEM_PLAN);
+    if (!p->Ns) {
+        goto cleanup;
+    }
+
+    p->Ms = ffts_mem_alloc(&p->allocator, 2 * sizeof(*p->Ms), FFTS_MEM_PLAN);
+    if (!p->Ms) {
+        goto cleanup;
+    }
+
+    for (log_N = 0; ((size_t) 1 << log_N) < N; log_N++);
+    p->Ns[0] = (size_t) 1 << ((log_N + 1) / 2);
+    p->Ns[1] = N / p->Ns[0];
+
+    p->Ms[0] = ffts_ooc_block(p->Ns[0], p->Ns[1], mem_size);
+    p->Ms[1] = ffts_ooc_block(p->Ns[1], p->Ns[0], mem_size);
+
+    /* two buffers of a block of columns */
+    size = p->Ns[0] * p->Ms[0];
+    if (size < p->Ns[1] * p->Ms[1]) {
+        size = p->Ns[1] * p->Ms[1];
+    }
+    size *= 2 * 2 * sizeof(float);
+
+    p->buf = ffts_mem_alloc(&p->allocator, size, FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    p->plans = ffts_mem_alloc(&p->allocator, 2 * sizeof(*p->plans),
+        FFTS_MEM_PLAN);
+    if (!p->plans) {
+        goto cleanup;
+    }
+    memset(p->plans, 0, 2 * sizeof(*p->plans));
+
+    p->scratch_bytes = size;
+    p->plan_bytes = sizeof(*p) + 2 * (sizeof(*p->Ns) + sizeof(*p->Ms) +
+        sizeof(*p->plans));
+
+    p->plans[0] = ffts_init_1d(p->Ns[0], sign);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    if (p->Ns[1] == p->Ns[0]) {
+        p->plans[1] = p->plans[0];
+    } else {
+        p->plans[1] = ffts_init_1d(p->Ns[1], sign);
+        if (!p->plans[1]) {
+            goto cleanup;
+        }
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_ooc(p);
+    return NULL;
+}
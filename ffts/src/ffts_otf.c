@@ -0,0 +1,283 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_otf.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_trig.h"
+
+#include <string.h>
+
+/* columns moved together between the input and the work buffers */
+#define FFTS_OTF_BLOCK 8
+
+/* twiddles computed by recurrence before one is computed exactly again */
+#define FFTS_OTF_RESEED 64
+
+static void
+ffts_free_otf(ffts_plan_t *p)
+{
+    if (p->plans) {
+        if (p->plans[0]) {
+            ffts_free(p->plans[0]);
+        }
+
+        if (p->plans[1] && p->plans[1] != p->plans[0]) {
+            ffts_free(p->plans[1]);
+        }
+
+        ffts_mem_free(&p->allocator, p->plans, FFTS_MEM_PLAN);
+    }
+
+    if (p->Ns) {
+        ffts_mem_free(&p->allocator, p->Ns, FFTS_MEM_PLAN);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+/* out[k] = in[k] * exp(sign * 2 * pi * i * n2 * k / N) for k < N1; the
+   twiddles are rotated in double precision, four interleaved sequences
+   stepping by the fourth power of the rotation, and recomputed exactly
+   every FFTS_OTF_RESEED, so the error stays far below that of single
+   precision */
+void
+ffts_otf_twiddle(float *FFTS_RESTRICT out, const float *FFTS_RESTRICT in,
+                 size_t N1, size_t n2, size_t N, int sign)
+{
+    double FFTS_ALIGN(16) r[2];
+    double FFTS_ALIGN(16) r4[2];
+    double FFTS_ALIGN(16) w[2];
+    double wr[4], wi[4];
+    double re, im, t;
+    size_t j, k, end;
+    int l;
+
+    if (!n2) {
+        memcpy(out, in, 2 * N1 * sizeof(*out));
+        return;
+    }
+
+    ffts_cexp_64f(n2, N, r);
+    ffts_cexp_64f(4 * n2, N, r4);
+    r[1] *= sign;
+    r4[1] *= sign;
+
+    /* N1 is a multiple of 4 */
+    for (k = 0; k < N1; k = end) {
+        end = k + FFTS_OTF_RESEED;
+        if (end > N1) {
+            end = N1;
+        }
+
+        /* n2 * k < N */
+        ffts_cexp_64f(n2 * k, N, w);
+        wr[0] = w[0];
+        wi[0] = w[1] * sign;
+        for (l = 1; l < 4; l++) {
+            wr[l] = wr[l - 1] * r[0] - wi[l - 1] * r[1];
+            wi[l] = wr[l - 1] * r[1] + wi[l - 1] * r[0];
+        }
+
+        for (j = k; j < end; j += 4) {
+            for (l = 0; l < 4; l++) {
+                re = in[2 * (j + l) + 0];
+                im = in[2 * (j + l) + 1];
+
+                out[2 * (j + l) + 0] = (float) (re * wr[l] - im * wi[l]);
+                out[2 * (j + l) + 1] = (float) (re * wi[l] + im * wr[l]);
+
+                t     = wr[l] * r4[0] - wi[l] * r4[1];
+                wi[l] = wr[l] * r4[1] + wi[l] * r4[0];
+                wr[l] = t;
+            }
+        }
+    }
+}
+
+/* N = N1 * N2 with x[n1 * N2 + n2]: transforms of size N1 over the
+   columns of x, twiddled into the rows of out, then transforms of size
+   N2 over the columns of out, which leaves X[k1 + N1 * k2] in place */
+static void
+ffts_execute_otf_scratch(ffts_plan_t *p, const void *in, void *out, void *scratch)
+{
+    const float *din = (const float*) in;
+    float *dout = (float*) out;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    const float *src;
+    float *tmp, *dst;
+    size_t N1 = p->Ns[0];
+    size_t N2 = p->Ns[1];
+    size_t c, b, j;
+
+    if (in == out) {
+        /* the first pass writes rows of out over columns of in not read
+           yet, so in place the input is transformed from a copy */
+        float *copy = (float*) ffts_aligned_malloc(2 * p->N * sizeof(float));
+        if (!copy) {
+            LOG("ffts_execute: out of memory for an in-place transform\n");
+            return;
+        }
+
+        memcpy(copy, in, 2 * p->N * sizeof(float));
+        ffts_execute_otf_scratch(p, copy, out, scratch);
+        ffts_aligned_free(copy);
+        return;
+    }
+
+    tmp = buf + 2 * FFTS_OTF_BLOCK * (N1 > N2 ? N1 : N2);
+
+    for (c = 0; c < N2; c += FFTS_OTF_BLOCK) {
+        for (j = 0; j < N1; j++) {
+            src = din + 2 * (j * N2 + c);
+
+            for (b = 0; b < FFTS_OTF_BLOCK; b++) {
+                buf[2 * (b * N1 + j) + 0] = src[2 * b + 0];
+                buf[2 * (b * N1 + j) + 1] = src[2 * b + 1];
+            }
+        }
+
+        for (b = 0; b < FFTS_OTF_BLOCK; b++) {
+            ffts_sub_transform(p, p->plans[0], buf + 2 * b * N1, tmp, scratch);
+            ffts_otf_twiddle(dout + 2 * (c + b) * N1, tmp, N1, c + b, p->N,
+                p->sign);
+        }
+    }
+
+    for (c = 0; c < N1; c += FFTS_OTF_BLOCK) {
+        for (j = 0; j < N2; j++) {
+            src = dout + 2 * (j * N1 + c);
+
+            for (b = 0; b < FFTS_OTF_BLOCK; b++) {
+                buf[2 * (b * N2 + j) + 0] = src[2 * b + 0];
+                buf[2 * (b * N2 + j) + 1] = src[2 * b + 1];
+            }
+        }
+
+        for (b = 0; b < FFTS_OTF_BLOCK; b++) {
+            ffts_sub_transform(p, p->plans[1], buf + 2 * b * N2,
+                tmp + 2 * b * N2, scratch);
+        }
+
+        for (j = 0; j < N2; j++) {
+            dst = dout + 2 * (j * N1 + c);
+
+            for (b = 0; b < FFTS_OTF_BLOCK; b++) {
+                dst[2 * b + 0] = tmp[2 * (b * N2 + j) + 0];
+                dst[2 * b + 1] = tmp[2 * (b * N2 + j) + 1];
+            }
+        }
+    }
+}
+
+static void
+ffts_execute_otf(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_otf_scratch(p, in, out, NULL);
+}
+
+ffts_plan_t*
+ffts_init_1d_otf(size_t N, int sign)
+{
+    ffts_plan_t *p;
+    size_t M, size;
+    int log_N;
+
+    /* both passes move whole blocks of columns */
+    if ((N & (N - 1)) != 0 || N < FFTS_OTF_BLOCK * FFTS_OTF_BLOCK) {
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+
+    p->transform = &ffts_execute_otf;
+    p->transform_scratch = &ffts_execute_otf_scratch;
+    p->destroy   = &ffts_free_otf;
+    p->rank      = 2;
+    p->N         = N;
+    p->sign      = sign;
+
+    p->Ns = ffts_mem_alloc(&p->allocator, 2 * sizeof(*p->Ns), FFTS_MEM_PLAN);
+    if (!p->Ns) {
+        goto cleanup;
+    }
+
+    for (log_N = 0; ((size_t) 1 << log_N) < N; log_N++);
+    p->Ns[0] = (size_t) 1 << ((log_N + 1) / 2);
+    p->Ns[1] = N / p->Ns[0];
+
+    /* a block of columns and the transforms of a block of columns */
+    M = p->Ns[0];
+    size = 2 * 2 * FFTS_OTF_BLOCK * M * sizeof(float);
+
+    p->buf = ffts_mem_alloc(&p->allocator, size, FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    p->plans = ffts_mem_alloc(&p->allocator, 2 * sizeof(*p->plans),
+        FFTS_MEM_PLAN);
+    if (!p->plans) {
+        goto cleanup;
+    }
+    memset(p->plans, 0, 2 * sizeof(*p->plans));
+
+    p->scratch_bytes = size;
+    p->plan_bytes = sizeof(*p) + 2 * (sizeof(*p->Ns) + sizeof(*p->plans));
+
+    p->plans[0] = ffts_init_1d(p->Ns[0], sign);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    if (p->Ns[1] == p->Ns[0]) {
+        p->plans[1] = p->plans[0];
+    } else {
+        p->plans[1] = ffts_init_1d(p->Ns[1], sign);
+        if (!p->plans[1]) {
+            goto cleanup;
+        }
+    }
+
+    return p;
+
+cleanup:
+    ffts_free_otf(p);
+    return NULL;
+}
@@ -34,6 +34,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "ffts_real.h"
 #include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_stats.h"
 #include "ffts_trig.h"
 
 #ifdef HAVE_NEON
@@ -61,31 +63,33 @@ static void
 ffts_free_1d_real(ffts_plan_t *p)
 {
     if (p->B) {
-        ffts_aligned_free(p->B);
+        ffts_mem_free(&p->allocator, p->B, FFTS_MEM_TABLES);
     }
 
     if (p->A) {
-        ffts_aligned_free(p->A);
+        ffts_mem_free(&p->allocator, p->A, FFTS_MEM_TABLES);
     }
 
     if (p->buf) {
-        ffts_aligned_free(p->buf);
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
     }
 
     if (p->plans[0]) {
         ffts_free(p->plans[0]);
     }
 
-    free(p);
+    ffts_plan_release(p);
 }
 
 static void
-ffts_execute_1d_real(ffts_plan_t *p, const void *input, void *output)
+ffts_execute_1d_real_scratch(ffts_plan_t *p, const void *input, void *output,
+                             void *scratch)
 {
     float *const FFTS_RESTRICT out =
         (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_16(output);
     float *const FFTS_RESTRICT buf =
-        (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->buf);
+        (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(
+            scratch ? scratch : p->buf);
     const float *const FFTS_RESTRICT A =
         (const float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->A);
     const float *const FFTS_RESTRICT B =
@@ -102,7 +106,7 @@ ffts_execute_1d_real(ffts_plan_t *p, const void *input, void *output)
     /* we know this */
     FFTS_ASSUME(N/2 > 0);
 
-    p->plans[0]->transform(p->plans[0], input, buf);
+    ffts_sub_transform(p, p->plans[0], input, buf, scratch);
 
 #ifndef HAVE_SSE
     buf[N + 0] = buf[0];
@@ -343,12 +347,20 @@ ffts_execute_1d_real(ffts_plan_t *p, const void *input, void *output)
 }
 
 static void
-ffts_execute_1d_real_inv(ffts_plan_t *p, const void *input, void *output)
+ffts_execute_1d_real(ffts_plan_t *p, const void *input, void *output)
+{
+    ffts_execute_1d_real_scratch(p, input, output, NULL);
+}
+
+static void
+ffts_execute_1d_real_inv_scratch(ffts_plan_t *p, const void *input,
+                                 void *output, void *scratch)
 {
     float *const FFTS_RESTRICT in =
         (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_16(input);
     float *const FFTS_RESTRICT buf =
-        (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->buf);
+        (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(
+            scratch ? scratch : p->buf);
     const float *const FFTS_RESTRICT A =
         (const float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->A);
     const float *const FFTS_RESTRICT B =
@@ -596,59 +608,219 @@ ffts_execute_1d_real_inv(ffts_plan_t *p, const void *input, void *output)
     }
 #endif
 
-    p->plans[0]->transform(p->plans[0], buf, output);
+    ffts_sub_transform(p, p->plans[0], buf, output, scratch);
+}
+
+static void
+ffts_execute_1d_real_inv(ffts_plan_t *p, const void *input, void *output)
+{
+    ffts_execute_1d_real_inv_scratch(p, input, output, NULL);
 }
 
 FFTS_API ffts_plan_t*
 ffts_init_1d_real(size_t N, int sign)
 {
     ffts_plan_t *p;
+    double t0;
 
-    p = (ffts_plan_t*) calloc(1, sizeof(*p) + sizeof(*p->plans));
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*p->plans));
     if (!p) {
         return NULL;
     }
 
     if (sign < 0) {
         p->transform = &ffts_execute_1d_real;
+        p->transform_scratch = &ffts_execute_1d_real_scratch;
     } else {
         p->transform = &ffts_execute_1d_real_inv;
+        p->transform_scratch = &ffts_execute_1d_real_inv_scratch;
     }
 
     p->destroy = &ffts_free_1d_real;
     p->N       = N;
     p->rank    = 1;
     p->plans   = (ffts_plan_t**) &p[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*p->plans);
 
     p->plans[0] = ffts_init_1d(N/2, sign);
     if (!p->plans[0]) {
         goto cleanup;
     }
 
-    p->buf = ffts_aligned_malloc(2 * ((N/2) + 1) * sizeof(float));
+    p->buf = ffts_mem_alloc(&p->allocator, 2 * ((N/2) + 1) * sizeof(float),
+        FFTS_MEM_SCRATCH);
     if (!p->buf) {
         goto cleanup;
     }
+    p->scratch_bytes = 2 * ((N/2) + 1) * sizeof(float);
 
-    p->A = (float*) ffts_aligned_malloc(N * sizeof(float));
+    p->A = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+        FFTS_MEM_TABLES);
     if (!p->A) {
         goto cleanup;
     }
 
-    p->B = (float*) ffts_aligned_malloc(N * sizeof(float));
+    p->B = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+        FFTS_MEM_TABLES);
     if (!p->B) {
         goto cleanup;
     }
+    p->table_bytes = 2 * N * sizeof(float);
 
+    FFTS_STATS_START(t0);
 #ifdef HAVE_SSE3
     ffts_generate_table_1d_real_32f(p, sign, 1);
 #else
     ffts_generate_table_1d_real_32f(p, sign, 0);
 #endif
+    FFTS_STATS_STOP(real_tables, t0);
+
+    return p;
+
+cleanup:
+    ffts_free_1d_real(p);
+    return NULL;
+}
+
+/* Discrete Hartley transform H[k] = Re X[k] - Im X[k] of the real FFT X:
+   the post-processing of the real FFT computes X[k] for k <= N/2 and
+   writes H[k] and H[N - k] = Re X[k] + Im X[k] at once */
+static void
+ffts_execute_1d_dht_scratch(ffts_plan_t *p, const void *input, void *output,
+                            void *scratch)
+{
+    float *const FFTS_RESTRICT out = (float *const FFTS_RESTRICT) output;
+    float *const FFTS_RESTRICT buf =
+        (float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(
+            scratch ? scratch : p->buf);
+    const float *const FFTS_RESTRICT A =
+        (const float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->A);
+    const float *const FFTS_RESTRICT B =
+        (const float *const FFTS_RESTRICT) FFTS_ASSUME_ALIGNED_32(p->B);
+    const int N = (const int) p->N;
+    float re, im;
+    int i;
+
+    /* we know this */
+    FFTS_ASSUME(N/2 > 0);
+
+    ffts_sub_transform(p, p->plans[0], input, buf, scratch);
+
+    buf[N + 0] = buf[0];
+    buf[N + 1] = buf[1];
+
+    out[0] = buf[0] + buf[1];
+    i = 1;
+
+#ifdef HAVE_SSE
+    /* four k at a time, with buf[N - 2*k] read backwards */
+    for (; i + 3 < N/2; i += 4) {
+        __m128 z0 = _mm_loadu_ps(buf + 2*i);
+        __m128 z1 = _mm_loadu_ps(buf + 2*i + 4);
+        __m128 w0 = _mm_loadu_ps(buf + N - 2*i - 2);
+        __m128 w1 = _mm_loadu_ps(buf + N - 2*i - 6);
+        __m128 a0 = _mm_loadu_ps(A + 2*i);
+        __m128 a1 = _mm_loadu_ps(A + 2*i + 4);
+        __m128 b0 = _mm_loadu_ps(B + 2*i);
+        __m128 b1 = _mm_loadu_ps(B + 2*i + 4);
+        __m128 zr = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(2,0,2,0));
+        __m128 zi = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(3,1,3,1));
+        __m128 wr = _mm_shuffle_ps(w0, w1, _MM_SHUFFLE(0,2,0,2));
+        __m128 wi = _mm_shuffle_ps(w0, w1, _MM_SHUFFLE(1,3,1,3));
+        __m128 ar = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0));
+        __m128 ai = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1));
+        __m128 br = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0));
+        __m128 bi = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1));
+        __m128 xr = _mm_add_ps(
+            _mm_sub_ps(_mm_mul_ps(zr, ar), _mm_mul_ps(zi, ai)),
+            _mm_add_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi)));
+        __m128 xi = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(zi, ar), _mm_mul_ps(zr, ai)),
+            _mm_sub_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br)));
+        __m128 hi = _mm_add_ps(xr, xi);
+
+        _mm_storeu_ps(out + i, _mm_sub_ps(xr, xi));
+        _mm_storeu_ps(out + N - i - 3,
+            _mm_shuffle_ps(hi, hi, _MM_SHUFFLE(0,1,2,3)));
+    }
+#endif
+
+    for (; i < N/2; i++) {
+        re = buf[    2*i + 0] * A[2*i + 0] - buf[    2*i + 1] * A[2*i + 1] +
+             buf[N - 2*i + 0] * B[2*i + 0] + buf[N - 2*i + 1] * B[2*i + 1];
+        im = buf[    2*i + 1] * A[2*i + 0] + buf[    2*i + 0] * A[2*i + 1] +
+             buf[N - 2*i + 0] * B[2*i + 1] - buf[N - 2*i + 1] * B[2*i + 0];
+
+        out[    i] = re - im;
+        out[N - i] = re + im;
+    }
+
+    out[N/2] = buf[0] - buf[1];
+}
+
+static void
+ffts_execute_1d_dht(ffts_plan_t *p, const void *input, void *output)
+{
+    ffts_execute_1d_dht_scratch(p, input, output, NULL);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_1d_dht(size_t N)
+{
+    ffts_plan_t *p;
+    double t0;
+
+    if (N < 4 || (N & (N - 1)) != 0) {
+        LOG("DHT size must be a power of two of at least 4\n");
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    p->transform = &ffts_execute_1d_dht;
+    p->transform_scratch = &ffts_execute_1d_dht_scratch;
+    p->destroy = &ffts_free_1d_real;
+    p->N       = N;
+    p->rank    = 1;
+    p->plans   = (ffts_plan_t**) &p[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*p->plans);
+
+    p->plans[0] = ffts_init_1d(N/2, FFTS_FORWARD);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    p->buf = ffts_mem_alloc(&p->allocator, 2 * ((N/2) + 1) * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+    p->scratch_bytes = 2 * ((N/2) + 1) * sizeof(float);
+
+    p->A = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+        FFTS_MEM_TABLES);
+    if (!p->A) {
+        goto cleanup;
+    }
+
+    p->B = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+        FFTS_MEM_TABLES);
+    if (!p->B) {
+        goto cleanup;
+    }
+    p->table_bytes = 2 * N * sizeof(float);
+
+    /* the scalar layout, which the fused loop reads */
+    FFTS_STATS_START(t0);
+    ffts_generate_table_1d_real_32f(p, FFTS_FORWARD, 0);
+    FFTS_STATS_STOP(real_tables, t0);
 
     return p;
 
 cleanup:
     ffts_free_1d_real(p);
     return NULL;
-}
\ No newline at end of file
+}
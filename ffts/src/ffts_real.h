@@ -44,4 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ffts_plan_t*
 ffts_init_1d_real(size_t N, int sign);
 
+ffts_plan_t*
+ffts_init_1d_dht(size_t N);
+
 #endif /* FFTS_REAL_H */
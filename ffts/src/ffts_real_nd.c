@@ -34,8 +34,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "ffts_real_nd.h"
 #include "ffts_real.h"
 #include "ffts_internal.h"
+#include "ffts_alloc.h"
 #include "ffts_transpose.h"
 
+#include <string.h>
+
+/* complex values of the row in which the real stage works, rounded up
+   so that the buffers after it stay aligned */
+#define FFTS_REAL_ND_ROW(N) (((N) / 2 + 4) & ~((size_t) 3))
+
 static void
 ffts_free_nd_real(ffts_plan_t *p)
 {
@@ -45,58 +52,67 @@ ffts_free_nd_real(ffts_plan_t *p)
         for (i = 0; i < p->rank; i++) {
             ffts_plan_t *plan = p->plans[i];
 
-			if (plan) {
-				for (j = 0; j < i; j++) {
-					if (p->Ns[i] == p->Ns[j]) {
-						plan = NULL;
-						break;
-					}
-				}
-
-				if (plan) {
-					ffts_free(plan);
-				}
-			}
+            /* complex stages of the same size share their plan */
+            if (plan) {
+                for (j = 1; j < i; j++) {
+                    if (p->Ns[i] == p->Ns[j]) {
+                        plan = NULL;
+                        break;
+                    }
+                }
+
+                if (plan) {
+                    ffts_free(plan);
+                }
+            }
         }
 
-        free(p->plans);
+        ffts_mem_free(&p->allocator, p->plans, FFTS_MEM_PLAN);
     }
 
     if (p->buf) {
-        ffts_aligned_free(p->buf);
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
     }
 
     if (p->Ns) {
-        free(p->Ns);
+        ffts_mem_free(&p->allocator, p->Ns, FFTS_MEM_PLAN);
     }
 
     if (p->Ms) {
-        free(p->Ms);
+        ffts_mem_free(&p->allocator, p->Ms, FFTS_MEM_PLAN);
     }
 
-    free(p);
+    ffts_plan_release(p);
 }
 
+/* The real stage transforms the last dimension; then, as in ffts_nd.c,
+   every complex stage transforms the contiguous dimension and rotates it
+   to the front with a transpose, so that after the last stage the
+   dimensions are back in their order. */
 static void
-ffts_execute_nd_real(ffts_plan_t *p, const void *in, void *out)
+ffts_execute_nd_real_scratch(ffts_plan_t *p, const void *in, void *out,
+                             void *scratch)
 {
-    const size_t Ms0 = p->Ms[0];
-    const size_t Ns0 = p->Ns[0];
+    const size_t N0 = p->Ns[0];
+    const size_t H  = N0 / 2 + 1;
 
-    uint32_t *din = (uint32_t*) in;
-    uint64_t *buf = p->buf;
+    const float *din = (const float*) in;
+    uint64_t *row = (uint64_t*) (scratch ? scratch : p->buf);
+    uint64_t *buf = row + FFTS_REAL_ND_ROW(N0);
     uint64_t *dout = (uint64_t*) out;
 
     ffts_plan_t *plan;
     int i;
     size_t j;
 
+    /* the rows of buf are not aligned, the real plan writes to row */
     plan = p->plans[0];
-    for (j = 0; j < Ns0; j++) {
-        plan->transform(plan, din + (j * Ms0), buf + (j * (Ms0 / 2 + 1)));
+    for (j = 0; j < p->Ms[0]; j++) {
+        ffts_sub_transform(p, plan, din + (j * N0), row, scratch);
+        memcpy(buf + (j * H), row, H * sizeof(*row));
     }
 
-    ffts_transpose(buf, dout, Ms0 / 2 + 1, Ns0);
+    ffts_transpose(buf, dout, H, p->Ms[0]);
 
     for (i = 1; i < p->rank; i++) {
         const size_t Ms = p->Ms[i];
@@ -104,150 +120,165 @@ ffts_execute_nd_real(ffts_plan_t *p, const void *in, void *out)
 
         plan = p->plans[i];
 
-        for (j = 0; j < Ns; j++) {
-            plan->transform(plan, dout + (j * Ms), buf + (j * Ms));
+        for (j = 0; j < Ms; j++) {
+            ffts_sub_transform(p, plan, dout + (j * Ns), buf + (j * Ns),
+                scratch);
         }
 
-        ffts_transpose(buf, dout, Ms, Ns);
+        ffts_transpose(buf, dout, Ns, Ms);
     }
 }
 
 static void
-ffts_execute_nd_real_inv(ffts_plan_t *p, const void *in, void *out)
+ffts_execute_nd_real(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_nd_real_scratch(p, in, out, NULL);
+}
+
+/* the same rotations, with the real stage last */
+static void
+ffts_execute_nd_real_inv_scratch(ffts_plan_t *p, const void *in, void *out,
+                                 void *scratch)
 {
-    const size_t Ms0 = p->Ms[0];
-    const size_t Ms1 = p->Ms[1];
-    const size_t Ns0 = p->Ns[0];
-    const size_t Ns1 = p->Ns[1];
+    const size_t N0 = p->Ns[0];
+    const size_t H  = N0 / 2 + 1;
 
     uint64_t *din = (uint64_t*) in;
-    uint64_t *buf = p->buf;
-    uint64_t *buf2;
-    float    *doutr = (float*) out;
+    uint64_t *row = (uint64_t*) (scratch ? scratch : p->buf);
+    uint64_t *buf = row + FFTS_REAL_ND_ROW(N0);
+    uint64_t *buf2 = buf + H * p->Ms[0];
+    float *doutr = (float*) out;
 
     ffts_plan_t *plan;
-    size_t vol;
-
     int i;
     size_t j;
 
-    vol = p->Ns[0];
+    ffts_transpose(din, buf, H, p->Ms[0]);
+
     for (i = 1; i < p->rank; i++) {
-        vol *= p->Ns[i];
-    }
+        const size_t Ms = p->Ms[i];
+        const size_t Ns = p->Ns[i];
 
-    buf2 = buf + vol;
+        plan = p->plans[i];
 
-    ffts_transpose(din, buf, Ms0, Ns0);
+        for (j = 0; j < Ms; j++) {
+            ffts_sub_transform(p, plan, buf + (j * Ns), buf2 + (j * Ns),
+                scratch);
+        }
 
-    plan = p->plans[0];
-    for (j = 0; j < Ms0; j++) {
-        plan->transform(plan, buf + (j * Ns0), buf2 + (j * Ns0));
+        ffts_transpose(buf2, buf, Ns, Ms);
     }
 
-    ffts_transpose(buf2, buf, Ns0, Ms0);
-
-    plan = p->plans[1];
-    for (j = 0; j < Ms1; j++) {
-        plan->transform(plan, buf + (j * Ms0), &doutr[j * Ns1]);
+    /* the rows of buf are not aligned, the real plan reads from row */
+    plan = p->plans[0];
+    for (j = 0; j < p->Ms[0]; j++) {
+        memcpy(row, buf + (j * H), H * sizeof(*row));
+        ffts_sub_transform(p, plan, row, doutr + (j * N0), scratch);
     }
 }
 
+static void
+ffts_execute_nd_real_inv(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_nd_real_inv_scratch(p, in, out, NULL);
+}
+
 FFTS_API ffts_plan_t*
 ffts_init_nd_real(int rank, size_t *Ns, int sign)
 {
-    int i;
+    int i, j;
     size_t vol = 1;
     size_t bufsize;
     ffts_plan_t *p;
 
-    p = (ffts_plan_t*) calloc(1, sizeof(*p));
+    if (!Ns || rank < 1) {
+        return NULL;
+    }
+
+    if (rank == 1) {
+        return ffts_init_1d_real(Ns[0], sign);
+    }
+
+    p = ffts_plan_alloc(sizeof(*p));
     if (!p) {
         return NULL;
     }
 
     if (sign < 0) {
         p->transform = &ffts_execute_nd_real;
+        p->transform_scratch = &ffts_execute_nd_real_scratch;
     } else {
         p->transform = &ffts_execute_nd_real_inv;
+        p->transform_scratch = &ffts_execute_nd_real_inv_scratch;
     }
 
     p->destroy = &ffts_free_nd_real;
     p->rank    = rank;
 
-    p->Ms = (size_t*) malloc(rank * sizeof(*p->Ms));
+    p->Ms = (size_t*) ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ms),
+        FFTS_MEM_PLAN);
     if (!p->Ms) {
         goto cleanup;
     }
 
-    p->Ns = (size_t*) malloc(rank * sizeof(*p->Ns));
+    p->Ns = (size_t*) ffts_mem_alloc(&p->allocator, rank * sizeof(*p->Ns),
+        FFTS_MEM_PLAN);
     if (!p->Ns) {
         goto cleanup;
     }
 
+    /* the real stage first, then the other dimensions in reverse order */
     for (i = 0; i < rank; i++) {
-        p->Ns[i] = Ns[i];
-        vol *= Ns[i];
+        p->Ns[i] = Ns[rank - i - 1];
+        vol *= p->Ns[i];
     }
 
-    /* there is probably a prettier way of doing this, but it works.. */
-    if (sign < 0) {
-        bufsize = 2 * vol;
-    } else {
-        bufsize = 2 * (Ns[0] * ((vol / Ns[0]) / 2 + 1) + vol);
+    /* complex values of the half spectrum */
+    vol = (vol / p->Ns[0]) * (p->Ns[0] / 2 + 1);
+
+    p->Ms[0] = vol / (p->Ns[0] / 2 + 1);
+    for (i = 1; i < rank; i++) {
+        p->Ms[i] = vol / p->Ns[i];
     }
 
-    p->buf = ffts_aligned_malloc(bufsize * sizeof(float));
+    /* an aligned row for the real plan, then one or two half spectra */
+    bufsize = 2 * (FFTS_REAL_ND_ROW(p->Ns[0]) + (sign < 0 ? 1 : 2) * vol);
+
+    p->buf = ffts_mem_alloc(&p->allocator, bufsize * sizeof(float),
+        FFTS_MEM_SCRATCH);
     if (!p->buf) {
         goto cleanup;
     }
 
-    p->plans = (ffts_plan_t**) calloc(rank, sizeof(*p->plans));
+    p->plans = (ffts_plan_t**) ffts_mem_alloc(&p->allocator,
+        rank * sizeof(*p->plans), FFTS_MEM_PLAN);
     if (!p->plans) {
         goto cleanup;
     }
+    memset(p->plans, 0, rank * sizeof(*p->plans));
 
-    for (i = 0; i < rank; i++) {
-        int k;
+    p->scratch_bytes = bufsize * sizeof(float);
+    p->plan_bytes = sizeof(*p) + rank * (sizeof(*p->Ms) + sizeof(*p->Ns) +
+        sizeof(*p->plans));
 
-        p->Ms[i] = vol / p->Ns[i];
-
-        if (sign < 0) {
-            if (!i) {
-                p->plans[i] = ffts_init_1d_real(p->Ms[i], sign);
-            } else {
-                for (k = 1; k < i; k++) {
-                    if (p->Ms[k] == p->Ms[i]) {
-                        p->plans[i] = p->plans[k];
-                        break;
-                    }
-                }
-
-                if (!p->plans[i]) {
-                    p->plans[i] = ffts_init_1d(p->Ms[i], sign);
-                    p->Ns[i] = p->Ns[i] / 2 + 1;
-                }
-            }
-        } else {
-            if (i == rank - 1) {
-                p->plans[i] = ffts_init_1d_real(p->Ns[i], sign);
-            } else {
-                for (k = 0; k < i; k++) {
-                    if (p->Ns[k] == p->Ns[i]) {
-                        p->plans[i] = p->plans[k];
-                        break;
-                    }
-                }
+    p->plans[0] = ffts_init_1d_real(p->Ns[0], sign);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
 
-                if (!p->plans[i]) {
-                    p->plans[i] = ffts_init_1d(p->Ns[i], sign);
-                    p->Ms[i] = p->Ms[i] / 2 + 1;
-                }
+    for (i = 1; i < rank; i++) {
+        for (j = 1; j < i; j++) {
+            if (p->Ns[i] == p->Ns[j]) {
+                p->plans[i] = p->plans[j];
+                break;
             }
         }
 
         if (!p->plans[i]) {
-            goto cleanup;
+            p->plans[i] = ffts_init_1d(p->Ns[i], sign);
+            if (!p->plans[i]) {
+                goto cleanup;
+            }
         }
     }
 
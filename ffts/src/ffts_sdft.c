@@ -0,0 +1,360 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_sdft.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_trig.h"
+#include "macros.h"
+
+#include <string.h>
+
+/* Sliding DFT of the last N samples, for a chosen set of bins. With the
+   oldest sample of the window at time zero, every new sample x[n]
+   updates bin k as
+
+     X[k] = W[k] * (X[k] + x[n] - x[n - N]),  W[k] = exp(2 pi i k / N)
+
+   which costs O(1) per bin instead of a full FFT per hop. The bins are
+   updated eight at a time, their real and imaginary parts kept in four
+   vectors over a whole chunk of samples, whose differences are first
+   broadcast into the work buffer. Rounding makes the bins drift from
+   the DFT of the window, so every anchor samples they are recomputed by
+   a full FFT of the window, kept in a ring buffer of N samples.
+*/
+
+#define FFTS_SDFT_BINS(count) (((count) + 7) & ~((size_t) 7))
+
+/* private state of sliding DFT plans */
+typedef struct _ffts_sdft_state_t {
+    /* W[k] of the bins, eight real parts then eight imaginary parts */
+    float *twiddles;
+
+    /* ring buffer of the window, whose oldest sample is at pos, then
+       the bins in the layout of the twiddles */
+    float *history;
+    size_t pos;
+
+    /* count bins, padded to a multiple of eight */
+    size_t *bins;
+    size_t count;
+
+    size_t hop;
+    size_t anchor; /* samples between full transforms */
+    size_t fill;   /* samples since the last full transform */
+} ffts_sdft_state_t;
+
+static void
+ffts_free_sdft(ffts_plan_t *p)
+{
+    ffts_sdft_state_t *s = (ffts_sdft_state_t*) p->state;
+
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    if (s->twiddles) {
+        ffts_mem_free(&p->allocator, s->twiddles, FFTS_MEM_TABLES);
+    }
+
+    if (s->history) {
+        ffts_mem_free(&p->allocator, s->history, FFTS_MEM_SCRATCH);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+/* n new samples of broadcast differences d, eight floats each */
+static void
+ffts_sdft_update(ffts_plan_t *p, const float *d, size_t n)
+{
+    ffts_sdft_state_t *s = (ffts_sdft_state_t*) p->state;
+    const float *FFTS_RESTRICT w =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->twiddles);
+    float *FFTS_RESTRICT x =
+        (float*) FFTS_ASSUME_ALIGNED_32(s->history + 2 * p->N);
+    const size_t bins = FFTS_SDFT_BINS(s->count);
+    size_t i, j;
+
+    for (i = 0; i < 2 * bins; i += 16) {
+        V4SF wr0 = V4SF_LD(w + i +  0), wr1 = V4SF_LD(w + i +  4);
+        V4SF wi0 = V4SF_LD(w + i +  8), wi1 = V4SF_LD(w + i + 12);
+        V4SF xr0 = V4SF_LD(x + i +  0), xr1 = V4SF_LD(x + i +  4);
+        V4SF xi0 = V4SF_LD(x + i +  8), xi1 = V4SF_LD(x + i + 12);
+
+        for (j = 0; j < n; j++) {
+            V4SF dr = V4SF_LD(d + 8 * j + 0);
+            V4SF di = V4SF_LD(d + 8 * j + 4);
+            V4SF ar0 = V4SF_ADD(xr0, dr), ai0 = V4SF_ADD(xi0, di);
+            V4SF ar1 = V4SF_ADD(xr1, dr), ai1 = V4SF_ADD(xi1, di);
+
+            xr0 = V4SF_SUB(V4SF_MUL(wr0, ar0), V4SF_MUL(wi0, ai0));
+            xi0 = V4SF_ADD(V4SF_MUL(wr0, ai0), V4SF_MUL(wi0, ar0));
+            xr1 = V4SF_SUB(V4SF_MUL(wr1, ar1), V4SF_MUL(wi1, ai1));
+            xi1 = V4SF_ADD(V4SF_MUL(wr1, ai1), V4SF_MUL(wi1, ar1));
+        }
+
+        V4SF_ST(x + i +  0, xr0);
+        V4SF_ST(x + i +  4, xr1);
+        V4SF_ST(x + i +  8, xi0);
+        V4SF_ST(x + i + 12, xi1);
+    }
+}
+
+/* recompute the bins by a full FFT of the window, oldest sample first */
+static void
+ffts_sdft_anchor(ffts_plan_t *p, float *buf, void *scratch)
+{
+    ffts_sdft_state_t *s = (ffts_sdft_state_t*) p->state;
+    const size_t N = p->N;
+    const size_t bins = FFTS_SDFT_BINS(s->count);
+    const size_t head = N - s->pos;
+    float *x = s->history + 2 * N;
+    float *spectrum = buf + 2 * N;
+    size_t i, k;
+
+    memcpy(buf, s->history + 2 * s->pos, 2 * head * sizeof(float));
+    memcpy(buf + 2 * head, s->history, 2 * s->pos * sizeof(float));
+
+    ffts_sub_transform(p, p->plans[0], buf, spectrum, scratch);
+
+    for (i = 0; i < bins; i++) {
+        k = s->bins[i];
+        x[2 * (i & ~7) + 0 + (i & 7)] = spectrum[2 * k + 0];
+        x[2 * (i & ~7) + 8 + (i & 7)] = spectrum[2 * k + 1];
+    }
+}
+
+static void
+ffts_sdft_scratch(ffts_plan_t *p, const float *in, size_t n, float *out,
+                  void *scratch)
+{
+    ffts_sdft_state_t *s = (ffts_sdft_state_t*) p->state;
+    const size_t N = p->N;
+    float *FFTS_RESTRICT ring = s->history;
+    float *FFTS_RESTRICT d = (float*) (scratch ? scratch : p->buf);
+    size_t chunk, i, j;
+
+    while (n > 0) {
+        /* the broadcast differences of N / 2 samples fill the buffer */
+        chunk = s->anchor - s->fill;
+        if (chunk > N / 2) {
+            chunk = N / 2;
+        }
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        for (j = 0; j < chunk; j++) {
+            const size_t k = 2 * s->pos;
+            const float dr = in[2 * j + 0] - ring[k + 0];
+            const float di = in[2 * j + 1] - ring[k + 1];
+
+            ring[k + 0] = in[2 * j + 0];
+            ring[k + 1] = in[2 * j + 1];
+            s->pos = (s->pos + 1) & (N - 1);
+
+            for (i = 0; i < 4; i++) {
+                d[8 * j + 0 + i] = dr;
+                d[8 * j + 4 + i] = di;
+            }
+        }
+
+        ffts_sdft_update(p, d, chunk);
+
+        s->fill += chunk;
+        in += 2 * chunk;
+        n -= chunk;
+
+        if (s->fill == s->anchor) {
+            ffts_sdft_anchor(p, d, scratch);
+            s->fill = 0;
+        }
+    }
+
+    if (out) {
+        const float *x = s->history + 2 * N;
+
+        for (i = 0; i < s->count; i++) {
+            out[2 * i + 0] = x[2 * (i & ~7) + 0 + (i & 7)];
+            out[2 * i + 1] = x[2 * (i & ~7) + 8 + (i & 7)];
+        }
+    }
+}
+
+static void
+ffts_execute_sdft_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_sdft_state_t *s = (ffts_sdft_state_t*) p->state;
+
+    ffts_sdft_scratch(p, (const float*) in, s->hop, (float*) out, scratch);
+}
+
+static void
+ffts_execute_sdft(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_sdft_scratch(p, in, out, NULL);
+}
+
+FFTS_API void
+ffts_sdft(ffts_plan_t *p, const void *input, size_t n, void *spectrum)
+{
+    if (p) {
+        ffts_sdft_scratch(p, (const float*) input, n, (float*) spectrum,
+            NULL);
+    }
+}
+
+FFTS_API void
+ffts_sdft_reset(ffts_plan_t *p)
+{
+    ffts_sdft_state_t *s;
+
+    if (!p) {
+        return;
+    }
+
+    s = (ffts_sdft_state_t*) p->state;
+    memset(s->history, 0,
+        2 * (p->N + FFTS_SDFT_BINS(s->count)) * sizeof(float));
+    s->pos = 0;
+    s->fill = 0;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_sdft(size_t N, size_t hop, const size_t *bins, size_t count,
+               size_t anchor)
+{
+    ffts_sdft_state_t *s;
+    ffts_plan_t *p;
+    size_t padded, i;
+
+    if (N < 4 || (N & (N - 1)) != 0) {
+        LOG("window must be a power of two of at least 4\n");
+        return NULL;
+    }
+
+    if (!bins) {
+        count = N;
+    }
+
+    if (hop < 1 || count < 1) {
+        return NULL;
+    }
+
+    for (i = 0; bins && i < count; i++) {
+        if (bins[i] >= N) {
+            LOG("bins must be less than the window\n");
+            return NULL;
+        }
+    }
+
+    /* bins of the padding lanes are 0, and never output */
+    padded = FFTS_SDFT_BINS(count);
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + sizeof(*p->plans) +
+        padded * sizeof(*s->bins));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_sdft_state_t*) &p[1];
+
+    p->transform = &ffts_execute_sdft;
+    p->transform_scratch = &ffts_execute_sdft_scratch;
+    p->destroy = &ffts_free_sdft;
+    p->N       = N;
+    p->rank    = 1;
+    p->state   = s;
+    p->plans   = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + sizeof(*p->plans) +
+        padded * sizeof(*s->bins);
+
+    s->bins   = (size_t*) &p->plans[1];
+    s->count  = count;
+    s->hop    = hop;
+    s->anchor = anchor ? anchor : N;
+
+    for (i = 0; i < padded; i++) {
+        s->bins[i] = (i >= count) ? 0 : (bins ? bins[i] : i);
+    }
+
+    p->plans[0] = ffts_init_1d(N, FFTS_FORWARD);
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    /* the window and its spectrum when anchoring, or the differences
+       of N / 2 samples broadcast to eight floats each */
+    p->scratch_bytes = 4 * N * sizeof(float);
+    p->buf = ffts_mem_alloc(&p->allocator, p->scratch_bytes,
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    /* the ring buffer of the window and the bins, kept between calls
+       and so counted with the plan */
+    s->history = ffts_mem_alloc(&p->allocator,
+        2 * (N + padded) * sizeof(float), FFTS_MEM_SCRATCH);
+    if (!s->history) {
+        goto cleanup;
+    }
+    p->plan_bytes += 2 * (N + padded) * sizeof(float);
+
+    s->twiddles = (float*) ffts_mem_alloc(&p->allocator,
+        2 * padded * sizeof(float), FFTS_MEM_TABLES);
+    if (!s->twiddles) {
+        goto cleanup;
+    }
+    p->table_bytes = 2 * padded * sizeof(float);
+
+    for (i = 0; i < padded; i++) {
+        float w[2];
+
+        ffts_cexp_32f(s->bins[i], N, w);
+        s->twiddles[2 * (i & ~7) + 0 + (i & 7)] = w[0];
+        s->twiddles[2 * (i & ~7) + 8 + (i & 7)] = w[1];
+    }
+
+    ffts_sdft_reset(p);
+    return p;
+
+cleanup:
+    ffts_free_sdft(p);
+    return NULL;
+}
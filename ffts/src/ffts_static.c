@@ -38,9 +38,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #if defined(HAVE_NEON)
 #include "neon.h"
+#elif defined(HAVE_SSE2)
+#include <emmintrin.h>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
 #endif
 
 #include <assert.h>
+#include <string.h>
 
 static const FFTS_ALIGN(16) float ffts_constants_small_32f[24] = {
      1.0f,
@@ -258,6 +264,99 @@ static const FFTS_ALIGN(16) double ffts_constants_inv_64f[16] = {
     -0.7071067811865475244008443621048490392848359376884740
 };
 
+/* Loads two complex numbers of the input of the first pass, at offset i
+   in values of its format: float (FFTS_FLOAT), FFTS_INT16 or FFTS_INT8
+   integers converted and multiplied by scale in the same registers, or
+   the half floats of ffts_static_half_format, so that integer and half
+   precision input plans need no conversion pass. */
+static FFTS_INLINE V4SF
+V4SF_LD_IN(int format, const void *in, ptrdiff_t i, V4SF scale)
+{
+#ifdef HAVE_SSE2
+    if (format == FFTS_INT16) {
+        __m128i a = _mm_loadl_epi64((const __m128i*) ((const int16_t*) in + i));
+
+        return V4SF_MUL(scale, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16)));
+    } else if (format == FFTS_INT8) {
+        __m128i a;
+        int32_t v;
+
+        memcpy(&v, (const int8_t*) in + i, sizeof(v));
+        a = _mm_cvtsi32_si128(v);
+        a = _mm_unpacklo_epi8(a, a);
+
+        return V4SF_MUL(scale, _mm_cvtepi32_ps(
+            _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 24)));
+    } else if (format == FFTS_BF16) {
+        /* bfloat16 is the high half of a float */
+        __m128i a = _mm_loadl_epi64((const __m128i*) ((const uint16_t*) in + i));
+
+        return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), a));
+    }
+#ifdef __F16C__
+    else if (format == FFTS_FP16) {
+        return _mm_cvtph_ps(
+            _mm_loadl_epi64((const __m128i*) ((const uint16_t*) in + i)));
+    }
+#endif
+#else
+    if (format == FFTS_INT16 || format == FFTS_INT8) {
+        float FFTS_ALIGN(16) t[4];
+        int k;
+
+        for (k = 0; k < 4; k++) {
+            t[k] = (format == FFTS_INT16) ?
+                (float) ((const int16_t*) in)[i + k] :
+                (float) ((const int8_t*) in)[i + k];
+        }
+
+        return V4SF_MUL(scale, V4SF_LD(t));
+    }
+#endif
+
+    return V4SF_LD((const float*) in + i);
+}
+
+/* Stores two complex numbers of the output of the last pass, at offset i
+   in half floats of a format of ffts_static_half_format, rounded to
+   nearest even as ffts_float_to_half does. */
+static FFTS_INLINE void
+V4SF_ST_OUT(int format, void *out, ptrdiff_t i, V4SF v)
+{
+#ifdef HAVE_SSE2
+    if (format == FFTS_BF16) {
+        const __m128i a = _mm_castps_si128(v);
+        __m128i n, r;
+
+        /* quiet NaNs instead of rounding them, and shift arithmetically
+           so that packing with saturation keeps the bits */
+        n = _mm_cmpgt_epi32(_mm_and_si128(a, _mm_set1_epi32(0x7fffffff)),
+            _mm_set1_epi32(0x7f800000));
+        r = _mm_add_epi32(_mm_add_epi32(a, _mm_set1_epi32(0x7fff)),
+            _mm_and_si128(_mm_srli_epi32(a, 16), _mm_set1_epi32(1)));
+        r = _mm_or_si128(_mm_and_si128(n,
+            _mm_or_si128(a, _mm_set1_epi32(0x00400000))),
+            _mm_andnot_si128(n, r));
+        r = _mm_srai_epi32(r, 16);
+
+        _mm_storel_epi64((__m128i*) ((uint16_t*) out + i),
+            _mm_packs_epi32(r, r));
+        return;
+    }
+#ifdef __F16C__
+    if (format == FFTS_FP16) {
+        _mm_storel_epi64((__m128i*) ((uint16_t*) out + i),
+            _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+        return;
+    }
+#endif
+#endif
+
+    (void) format;
+    V4SF_ST((float*) out + i, v);
+}
+
 static FFTS_INLINE void
 V4SF_K_0(int inv,
          V4SF *r0,
@@ -280,10 +379,10 @@ V4SF_K_0(int inv,
 }
 
 static FFTS_INLINE void
-V4SF_L_2(const float *FFTS_RESTRICT i0,
-         const float *FFTS_RESTRICT i1,
-         const float *FFTS_RESTRICT i2,
-         const float *FFTS_RESTRICT i3,
+V4SF_L_2(V4SF x0,
+         V4SF x1,
+         V4SF x2,
+         V4SF x3,
          V4SF *r0,
          V4SF *r1,
          V4SF *r2,
@@ -291,10 +390,10 @@ V4SF_L_2(const float *FFTS_RESTRICT i0,
 {
     V4SF t0, t1, t2, t3;
 
-    t0 = V4SF_LD(i0);
-    t1 = V4SF_LD(i1);
-    t2 = V4SF_LD(i2);
-    t3 = V4SF_LD(i3);
+    t0 = x0;
+    t1 = x1;
+    t2 = x2;
+    t3 = x3;
 
     *r0 = V4SF_ADD(t0, t1);
     *r1 = V4SF_SUB(t0, t1);
@@ -304,10 +403,10 @@ V4SF_L_2(const float *FFTS_RESTRICT i0,
 
 static FFTS_INLINE void
 V4SF_L_4(int inv,
-         const float *FFTS_RESTRICT i0,
-         const float *FFTS_RESTRICT i1,
-         const float *FFTS_RESTRICT i2,
-         const float *FFTS_RESTRICT i3,
+         V4SF x0,
+         V4SF x1,
+         V4SF x2,
+         V4SF x3,
          V4SF *r0,
          V4SF *r1,
          V4SF *r2,
@@ -315,10 +414,10 @@ V4SF_L_4(int inv,
 {
     V4SF t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = V4SF_LD(i0);
-    t1 = V4SF_LD(i1);
-    t2 = V4SF_LD(i2);
-    t3 = V4SF_LD(i3);
+    t0 = x0;
+    t1 = x1;
+    t2 = x2;
+    t3 = x3;
 
     t4 = V4SF_ADD(t0, t1);
     t5 = V4SF_SUB(t0, t1);
@@ -334,9 +433,11 @@ V4SF_L_4(int inv,
 static FFTS_INLINE void
 V4SF_LEAF_EE(float *const FFTS_RESTRICT out,
              const ptrdiff_t *FFTS_RESTRICT os,
-             const float     *FFTS_RESTRICT in,
+             const void *FFTS_RESTRICT in,
              const ptrdiff_t *FFTS_RESTRICT is,
-             int inv)
+             int inv,
+             int format,
+             V4SF scale)
 {
     const float *FFTS_RESTRICT LUT = inv ? ffts_constants_inv_32f : ffts_constants_32f;
 
@@ -345,8 +446,18 @@ V4SF_LEAF_EE(float *const FFTS_RESTRICT out,
     float *out0 = out + os[0];
     float *out1 = out + os[1];
 
-    V4SF_L_4(inv, in + is[0], in + is[1], in + is[2], in + is[3], &r0, &r1, &r2, &r3);
-    V4SF_L_2(in + is[4], in + is[5], in + is[6], in + is[7], &r4, &r5, &r6, &r7);
+    V4SF_L_4(inv,
+        V4SF_LD_IN(format, in, is[0], scale),
+        V4SF_LD_IN(format, in, is[1], scale),
+        V4SF_LD_IN(format, in, is[2], scale),
+        V4SF_LD_IN(format, in, is[3], scale),
+        &r0, &r1, &r2, &r3);
+    V4SF_L_2(
+        V4SF_LD_IN(format, in, is[4], scale),
+        V4SF_LD_IN(format, in, is[5], scale),
+        V4SF_LD_IN(format, in, is[6], scale),
+        V4SF_LD_IN(format, in, is[7], scale),
+        &r4, &r5, &r6, &r7);
 
     V4SF_K_0(inv, &r0, &r2, &r4, &r6);
     V4SF_K_N(inv, V4SF_LD(LUT + 0), V4SF_LD(LUT + 4), &r1, &r3, &r5, &r7);
@@ -362,9 +473,11 @@ V4SF_LEAF_EE(float *const FFTS_RESTRICT out,
 static FFTS_INLINE void
 V4SF_LEAF_EE2(float *const FFTS_RESTRICT out,
               const ptrdiff_t *FFTS_RESTRICT os,
-              const float *FFTS_RESTRICT in,
+              const void *FFTS_RESTRICT in,
               const ptrdiff_t *FFTS_RESTRICT is,
-              int inv)
+              int inv,
+              int format,
+              V4SF scale)
 {
     const float *FFTS_RESTRICT LUT = inv ? ffts_constants_inv_32f : ffts_constants_32f;
 
@@ -373,8 +486,18 @@ V4SF_LEAF_EE2(float *const FFTS_RESTRICT out,
     float *out0 = out + os[0];
     float *out1 = out + os[1];
 
-    V4SF_L_4(inv, in + is[6], in + is[7], in + is[4], in + is[5], &r0, &r1, &r2, &r3);
-    V4SF_L_2(in + is[0], in + is[1], in + is[3], in + is[2], &r4, &r5, &r6, &r7);
+    V4SF_L_4(inv,
+        V4SF_LD_IN(format, in, is[6], scale),
+        V4SF_LD_IN(format, in, is[7], scale),
+        V4SF_LD_IN(format, in, is[4], scale),
+        V4SF_LD_IN(format, in, is[5], scale),
+        &r0, &r1, &r2, &r3);
+    V4SF_L_2(
+        V4SF_LD_IN(format, in, is[0], scale),
+        V4SF_LD_IN(format, in, is[1], scale),
+        V4SF_LD_IN(format, in, is[3], scale),
+        V4SF_LD_IN(format, in, is[2], scale),
+        &r4, &r5, &r6, &r7);
 
     V4SF_K_0(inv, &r0, &r2, &r4, &r6);
     V4SF_K_N(inv, V4SF_LD(LUT + 0), V4SF_LD(LUT + 4), &r1, &r3, &r5, &r7);
@@ -390,9 +513,11 @@ V4SF_LEAF_EE2(float *const FFTS_RESTRICT out,
 static FFTS_INLINE void
 V4SF_LEAF_EO(float *const FFTS_RESTRICT out,
              const ptrdiff_t *FFTS_RESTRICT os,
-             const float *FFTS_RESTRICT in,
+             const void *FFTS_RESTRICT in,
              const ptrdiff_t *FFTS_RESTRICT is,
-             int inv)
+             int inv,
+             int format,
+             V4SF scale)
 {
     const float *FFTS_RESTRICT LUT = inv ? ffts_constants_inv_32f : ffts_constants_32f;
 
@@ -401,8 +526,18 @@ V4SF_LEAF_EO(float *const FFTS_RESTRICT out,
     float *out0 = out + os[0];
     float *out1 = out + os[1];
 
-    V4SF_L_4_4(inv, in + is[0], in + is[1], in + is[2], in + is[3], &r0, &r1, &r2, &r3);
-    V4SF_L_2_4(inv, in + is[4], in + is[5], in + is[6], in + is[7], &r4, &r5, &r6, &r7);
+    V4SF_L_4_4(inv,
+        V4SF_LD_IN(format, in, is[0], scale),
+        V4SF_LD_IN(format, in, is[1], scale),
+        V4SF_LD_IN(format, in, is[2], scale),
+        V4SF_LD_IN(format, in, is[3], scale),
+        &r0, &r1, &r2, &r3);
+    V4SF_L_2_4(inv,
+        V4SF_LD_IN(format, in, is[4], scale),
+        V4SF_LD_IN(format, in, is[5], scale),
+        V4SF_LD_IN(format, in, is[6], scale),
+        V4SF_LD_IN(format, in, is[7], scale),
+        &r4, &r5, &r6, &r7);
 
     V4SF_S_4(r2, r3, r7, r6, out1 + 0, out1 + 4, out1 + 8, out1 + 12);
     V4SF_K_N(inv, V4SF_LD(LUT + 8), V4SF_LD(LUT + 12), &r0, &r1, &r4, &r5);
@@ -412,9 +547,11 @@ V4SF_LEAF_EO(float *const FFTS_RESTRICT out,
 static FFTS_INLINE void
 V4SF_LEAF_OE(float *const FFTS_RESTRICT out,
              const ptrdiff_t *FFTS_RESTRICT os,
-             const float *FFTS_RESTRICT in,
+             const void *FFTS_RESTRICT in,
              const ptrdiff_t *FFTS_RESTRICT is,
-             int inv)
+             int inv,
+             int format,
+             V4SF scale)
 {
     const float *FFTS_RESTRICT LUT = inv ? ffts_constants_inv_32f : ffts_constants_32f;
 
@@ -423,8 +560,18 @@ V4SF_LEAF_OE(float *const FFTS_RESTRICT out,
     float *out0 = out + os[0];
     float *out1 = out + os[1];
 
-    V4SF_L_4_2(inv, in + is[0], in + is[1], in + is[2], in + is[3], &r0, &r1, &r2, &r3);
-    V4SF_L_4_4(inv, in + is[6], in + is[7], in + is[4], in + is[5], &r4, &r5, &r6, &r7);
+    V4SF_L_4_2(inv,
+        V4SF_LD_IN(format, in, is[0], scale),
+        V4SF_LD_IN(format, in, is[1], scale),
+        V4SF_LD_IN(format, in, is[2], scale),
+        V4SF_LD_IN(format, in, is[3], scale),
+        &r0, &r1, &r2, &r3);
+    V4SF_L_4_4(inv,
+        V4SF_LD_IN(format, in, is[6], scale),
+        V4SF_LD_IN(format, in, is[7], scale),
+        V4SF_LD_IN(format, in, is[4], scale),
+        V4SF_LD_IN(format, in, is[5], scale),
+        &r4, &r5, &r6, &r7);
 
     V4SF_S_4(r0, r1, r4, r5, out0 + 0, out0 + 4, out0 + 8, out0 + 12);
     V4SF_K_N(inv, V4SF_LD(LUT + 8), V4SF_LD(LUT + 12), &r6, &r7, &r2, &r3);
@@ -434,17 +581,29 @@ V4SF_LEAF_OE(float *const FFTS_RESTRICT out,
 static FFTS_INLINE void
 V4SF_LEAF_OO(float *const FFTS_RESTRICT out,
              const ptrdiff_t *FFTS_RESTRICT os,
-             const float *FFTS_RESTRICT in,
+             const void *FFTS_RESTRICT in,
              const ptrdiff_t *FFTS_RESTRICT is,
-             int inv)
+             int inv,
+             int format,
+             V4SF scale)
 {
     V4SF r0, r1, r2, r3, r4, r5, r6, r7;
 
     float *out0 = out + os[0];
     float *out1 = out + os[1];
 
-    V4SF_L_4_4(inv, in + is[0], in + is[1], in + is[2], in + is[3], &r0, &r1, &r2, &r3);
-    V4SF_L_4_4(inv, in + is[6], in + is[7], in + is[4], in + is[5], &r4, &r5, &r6, &r7);
+    V4SF_L_4_4(inv,
+        V4SF_LD_IN(format, in, is[0], scale),
+        V4SF_LD_IN(format, in, is[1], scale),
+        V4SF_LD_IN(format, in, is[2], scale),
+        V4SF_LD_IN(format, in, is[3], scale),
+        &r0, &r1, &r2, &r3);
+    V4SF_L_4_4(inv,
+        V4SF_LD_IN(format, in, is[6], scale),
+        V4SF_LD_IN(format, in, is[7], scale),
+        V4SF_LD_IN(format, in, is[4], scale),
+        V4SF_LD_IN(format, in, is[5], scale),
+        &r4, &r5, &r6, &r7);
 
     V4SF_S_4(r0, r1, r4, r5, out0 + 0, out0 + 4, out0 + 8, out0 + 12);
     V4SF_S_4(r2, r3, r6, r7, out1 + 0, out1 + 4, out1 + 8, out1 + 12);
@@ -536,35 +695,98 @@ V4SF_X_8(int inv,
     }
 }
 
+/* V4SF_X_8 of the last pass, storing to out in format instead of
+   back to data */
+static FFTS_INLINE void
+V4SF_X_8_OUT(int inv,
+             const float *FFTS_RESTRICT data,
+             size_t N,
+             const float *FFTS_RESTRICT LUT,
+             void *FFTS_RESTRICT out,
+             int format)
+{
+    size_t i;
+
+    for (i = 0; i < N/16; i++) {
+        V4SF r0, r1, r2, r3, r4, r5, r6, r7;
+
+        r0 = V4SF_LD(data + 0*N/4);
+        r1 = V4SF_LD(data + 1*N/4);
+        r2 = V4SF_LD(data + 2*N/4);
+        r3 = V4SF_LD(data + 3*N/4);
+
+        V4SF_K_N(inv, V4SF_LD(LUT), V4SF_LD(LUT + 4), &r0, &r1, &r2, &r3);
+        r4 = V4SF_LD(data + 4*N/4);
+        r6 = V4SF_LD(data + 6*N/4);
+
+        V4SF_K_N(inv, V4SF_LD(LUT + 8), V4SF_LD(LUT + 12), &r0, &r2, &r4, &r6);
+        r5 = V4SF_LD(data + 5*N/4);
+        r7 = V4SF_LD(data + 7*N/4);
+
+        V4SF_K_N(inv, V4SF_LD(LUT + 16), V4SF_LD(LUT + 20), &r1, &r3, &r5, &r7);
+        LUT += 24;
+
+        V4SF_ST_OUT(format, out, 0*N/4 + 4*i, r0);
+        V4SF_ST_OUT(format, out, 1*N/4 + 4*i, r1);
+        V4SF_ST_OUT(format, out, 2*N/4 + 4*i, r2);
+        V4SF_ST_OUT(format, out, 3*N/4 + 4*i, r3);
+        V4SF_ST_OUT(format, out, 4*N/4 + 4*i, r4);
+        V4SF_ST_OUT(format, out, 5*N/4 + 4*i, r5);
+        V4SF_ST_OUT(format, out, 6*N/4 + 4*i, r6);
+        V4SF_ST_OUT(format, out, 7*N/4 + 4*i, r7);
+
+        data += 4;
+    }
+}
+
+/* bytes of a value of the input of the first pass */
+static FFTS_INLINE size_t
+ffts_static_input_size(int format)
+{
+    if (format == FFTS_INT16) {
+        return sizeof(int16_t);
+    } else if (format == FFTS_INT8) {
+        return sizeof(int8_t);
+    } else if (format == FFTS_FP16 || format == FFTS_BF16) {
+        return sizeof(uint16_t);
+    }
+
+    return sizeof(float);
+}
+
 static FFTS_INLINE void
 ffts_static_firstpass_odd_32f(float *const FFTS_RESTRICT out,
-                              const float *FFTS_RESTRICT in,
+                              const void *FFTS_RESTRICT in,
                               const ffts_plan_t *FFTS_RESTRICT p,
-                              int inv)
+                              int inv,
+                              int format,
+                              float scale)
 {
     size_t i, i0 = p->i0, i1 = p->i1;
     const ptrdiff_t *is = (const ptrdiff_t*) p->is;
     const ptrdiff_t *os = (const ptrdiff_t*) p->offsets;
+    const size_t step = 4 * ffts_static_input_size(format);
+    const V4SF s = V4SF_LIT4(scale, scale, scale, scale);
 
     for (i = i0; i > 0; --i) {
-        V4SF_LEAF_EE(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_EE(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 
     for (i = i1; i > 0; --i) {
-        V4SF_LEAF_OO(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_OO(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 
-    V4SF_LEAF_OE(out, os, in, is, inv);
-    in += 4;
+    V4SF_LEAF_OE(out, os, in, is, inv, format, s);
+    in = (const char*) in + step;
     os += 2;
 
     for (i = i1; i > 0; --i) {
-        V4SF_LEAF_EE2(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_EE2(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 }
@@ -784,7 +1006,8 @@ ffts_small_forward8_32f(ffts_plan_t *p, const void *in, void *out)
     /* unreferenced parameter */
     (void) p;
 
-    V4SF_L_4_2(0, din, din+8, din+4, din+12, &r0_1, &r2_3, &r4_5, &r6_7);
+    V4SF_L_4_2(0, V4SF_LD(din), V4SF_LD(din+8), V4SF_LD(din+4),
+        V4SF_LD(din+12), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_K_N(0, V4SF_LD(lut), V4SF_LD(lut + 4), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_S_4(r0_1, r2_3, r4_5, r6_7, dout+0, dout+4, dout+8, dout+12);
 }
@@ -818,7 +1041,8 @@ ffts_small_backward8_32f(ffts_plan_t *p, const void *in, void *out)
     /* unreferenced parameter */
     (void) p;
 
-    V4SF_L_4_2(1, din, din+8, din+4, din+12, &r0_1, &r2_3, &r4_5, &r6_7);
+    V4SF_L_4_2(1, V4SF_LD(din), V4SF_LD(din+8), V4SF_LD(din+4),
+        V4SF_LD(din+12), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_K_N(1, V4SF_LD(lut), V4SF_LD(lut+4), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_S_4(r0_1, r2_3, r4_5, r6_7, dout+0, dout+4, dout+8, dout+12);
 }
@@ -853,8 +1077,10 @@ ffts_small_forward16_32f(ffts_plan_t *p, const void *in, void *out)
     /* unreferenced parameter */
     (void) p;
 
-    V4SF_L_4_4(0, din+0, din+16, din+8, din+24, &r0_1, &r2_3, &r8_9, &r10_11);
-    V4SF_L_2_4(0, din+4, din+20, din+28, din+12, &r4_5, &r6_7, &r14_15, &r12_13);
+    V4SF_L_4_4(0, V4SF_LD(din+0), V4SF_LD(din+16), V4SF_LD(din+8),
+        V4SF_LD(din+24), &r0_1, &r2_3, &r8_9, &r10_11);
+    V4SF_L_2_4(0, V4SF_LD(din+4), V4SF_LD(din+20), V4SF_LD(din+28),
+        V4SF_LD(din+12), &r4_5, &r6_7, &r14_15, &r12_13);
     V4SF_K_N(0, V4SF_LD(lut), V4SF_LD(lut+4), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_K_N(0, V4SF_LD(lut+8), V4SF_LD(lut+12), &r0_1, &r4_5, &r8_9, &r12_13);
     V4SF_S_4(r0_1, r4_5, r8_9, r12_13, dout+0, dout+8, dout+16, dout+24);
@@ -895,8 +1121,10 @@ ffts_small_backward16_32f(ffts_plan_t *p, const void *in, void *out)
     /* unreferenced parameter */
     (void) p;
 
-    V4SF_L_4_4(1, din+0, din+16, din+8, din+24, &r0_1, &r2_3, &r8_9, &r10_11);
-    V4SF_L_2_4(1, din+4, din+20, din+28, din+12, &r4_5, &r6_7, &r14_15, &r12_13);
+    V4SF_L_4_4(1, V4SF_LD(din+0), V4SF_LD(din+16), V4SF_LD(din+8),
+        V4SF_LD(din+24), &r0_1, &r2_3, &r8_9, &r10_11);
+    V4SF_L_2_4(1, V4SF_LD(din+4), V4SF_LD(din+20), V4SF_LD(din+28),
+        V4SF_LD(din+12), &r4_5, &r6_7, &r14_15, &r12_13);
     V4SF_K_N(1, V4SF_LD(lut), V4SF_LD(lut+4), &r0_1, &r2_3, &r4_5, &r6_7);
     V4SF_K_N(1, V4SF_LD(lut+8), V4SF_LD(lut+12), &r0_1, &r4_5, &r8_9, &r12_13);
     V4SF_S_4(r0_1, r4_5, r8_9, r12_13, dout+0, dout+8, dout+16, dout+24);
@@ -928,33 +1156,37 @@ ffts_small_backward16_64f(ffts_plan_t *p, const void *in, void *out)
 
 static FFTS_INLINE void
 ffts_static_firstpass_even_32f(float *FFTS_RESTRICT out,
-                               const float *FFTS_RESTRICT in,
+                               const void *FFTS_RESTRICT in,
                                const ffts_plan_t *FFTS_RESTRICT p,
-                               int inv)
+                               int inv,
+                               int format,
+                               float scale)
 {
     size_t i, i0 = p->i0, i1 = p->i1;
     const ptrdiff_t *is = (const ptrdiff_t*) p->is;
     const ptrdiff_t *os = (const ptrdiff_t*) p->offsets;
+    const size_t step = 4 * ffts_static_input_size(format);
+    const V4SF s = V4SF_LIT4(scale, scale, scale, scale);
 
     for(i = i0; i > 0; --i) {
-        V4SF_LEAF_EE(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_EE(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 
-    V4SF_LEAF_EO(out, os, in, is, inv);
-    in += 4;
+    V4SF_LEAF_EO(out, os, in, is, inv, format, s);
+    in = (const char*) in + step;
     os += 2;
 
     for (i = i1; i > 0; --i) {
-        V4SF_LEAF_OO(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_OO(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 
     for (i = i1; i > 0; --i) {
-        V4SF_LEAF_EE2(out, os, in, is, inv);
-        in += 4;
+        V4SF_LEAF_EE2(out, os, in, is, inv, format, s);
+        in = (const char*) in + step;
         os += 2;
     }
 }
@@ -1163,9 +1395,9 @@ ffts_static_transform_f_32f(ffts_plan_t *p, const void *in, void *out)
     }
 #else
     if (N_log_2 & 1) {
-        ffts_static_firstpass_odd_32f(dout, din, p, 0);
+        ffts_static_firstpass_odd_32f(dout, din, p, 0, FFTS_FLOAT, 1.0f);
     } else {
-        ffts_static_firstpass_even_32f(dout, din, p, 0);
+        ffts_static_firstpass_even_32f(dout, din, p, 0, FFTS_FLOAT, 1.0f);
     }
 
     ffts_static_rec_f_32f(p, dout, N);
@@ -1224,11 +1456,120 @@ ffts_static_transform_i_32f(ffts_plan_t *p, const void *in, void *out)
     }
 #else
     if (N_log_2 & 1) {
-        ffts_static_firstpass_odd_32f(dout, din, p, 1);
+        ffts_static_firstpass_odd_32f(dout, din, p, 1, FFTS_FLOAT, 1.0f);
     } else {
-        ffts_static_firstpass_even_32f(dout, din, p, 1);
+        ffts_static_firstpass_even_32f(dout, din, p, 1, FFTS_FLOAT, 1.0f);
     }
 
     ffts_static_rec_i_32f(p, dout, N);
 #endif
-}
\ No newline at end of file
+}
+
+#ifndef HAVE_NEON
+/* the recursion of ffts_static_rec_f_32f or ffts_static_rec_i_32f on the
+   whole transform, whose last pass stores to out in format */
+static void
+ffts_static_rec_out_32f(const ffts_plan_t *p, float *data, size_t N, int inv,
+                        void *out, int format)
+{
+    void (*rec)(const ffts_plan_t*, float*, size_t) =
+        inv ? &ffts_static_rec_i_32f : &ffts_static_rec_f_32f;
+    const float *ws = (const float*) p->ws;
+
+    if (N > 128) {
+        const size_t N1 = N >> 1;
+        const size_t N2 = N >> 2;
+        const size_t N3 = N >> 3;
+
+        rec(p, data              , N2);
+        rec(p, data +     N1     , N3);
+        rec(p, data +     N1 + N2, N3);
+        rec(p, data + N          , N2);
+        rec(p, data + N + N1     , N2);
+
+        V4SF_X_8_OUT(inv, data, N, ws + (p->ws_is[ffts_ctzl(N) - 4] << 1),
+            out, format);
+    } else if (N == 128) {
+        const float *ws1 = ws + (p->ws_is[1] << 1);
+
+        V4SF_X_8(inv, data +   0, 32, ws1);
+        V4SF_X_4(inv, data +  64, 16, ws);
+        V4SF_X_4(inv, data +  96, 16, ws);
+        V4SF_X_8(inv, data + 128, 32, ws1);
+        V4SF_X_8(inv, data + 192, 32, ws1);
+
+        V4SF_X_8_OUT(inv, data, 128, ws + (p->ws_is[3] << 1), out, format);
+    } else if (N == 64) {
+        V4SF_X_4(inv, data +  0, 16, ws);
+        V4SF_X_4(inv, data + 64, 16, ws);
+        V4SF_X_4(inv, data + 96, 16, ws);
+
+        V4SF_X_8_OUT(inv, data, 64, ws + (p->ws_is[2] << 1), out, format);
+    } else {
+        assert(N == 32);
+        V4SF_X_8_OUT(inv, data, 32, ws + (p->ws_is[1] << 1), out, format);
+    }
+}
+
+/* static transform whose first pass loads in_format multiplied by scale,
+   and whose last pass stores out_format, working in buf unless out is
+   float */
+static void
+ffts_static_transform_format_32f(ffts_plan_t *p, const void *in, void *out,
+                                 float *buf, int inv, int in_format,
+                                 float scale, int out_format)
+{
+    float *dout = (out_format == FFTS_FLOAT) ? (float*) out : buf;
+
+    const size_t N = p->N;
+    const int N_log_2 = ffts_ctzl(N);
+
+    if (N_log_2 & 1) {
+        ffts_static_firstpass_odd_32f(dout, in, p, inv, in_format, scale);
+    } else {
+        ffts_static_firstpass_even_32f(dout, in, p, inv, in_format, scale);
+    }
+
+    if (out_format != FFTS_FLOAT) {
+        ffts_static_rec_out_32f(p, dout, N, inv, out, out_format);
+    } else if (inv) {
+        ffts_static_rec_i_32f(p, dout, N);
+    } else {
+        ffts_static_rec_f_32f(p, dout, N);
+    }
+}
+
+void
+ffts_static_transform_int_32f(ffts_plan_t *p, const void *in, void *out,
+                              int inv, int format, float scale)
+{
+    ffts_static_transform_format_32f(p, in, out, NULL, inv, format, scale,
+        FFTS_FLOAT);
+}
+
+int
+ffts_static_half_format(int format)
+{
+#ifdef HAVE_SSE2
+    if (format == FFTS_BF16) {
+        return 1;
+    }
+#ifdef __F16C__
+    if (format == FFTS_FP16) {
+        return 1;
+    }
+#endif
+#endif
+
+    return format == FFTS_FLOAT;
+}
+
+void
+ffts_static_transform_half_32f(ffts_plan_t *p, const void *in, void *out,
+                               float *buf, int inv, int in_format,
+                               int out_format)
+{
+    ffts_static_transform_format_32f(p, in, out, buf, inv, in_format, 1.0f,
+        out_format);
+}
+#endif
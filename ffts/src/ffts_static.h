@@ -88,4 +88,26 @@ ffts_static_transform_f_32f(ffts_plan_t *p, const void *in, void *out);
 void
 ffts_static_transform_i_32f(ffts_plan_t *p, const void *in, void *out);
 
+#ifndef HAVE_NEON
+/* static transform of a plan above whose first pass converts FFTS_INT16
+   or FFTS_INT8 input multiplied by scale as it loads it */
+void
+ffts_static_transform_int_32f(ffts_plan_t *p, const void *in, void *out,
+                              int inv, int format, float scale);
+
+/* whether the first and last passes of the transform below load and
+   store format (FFTS_FLOAT, and FFTS_BF16 or FFTS_FP16 on SSE2, the
+   latter when compiled for F16C) */
+int
+ffts_static_half_format(int format);
+
+/* static transform of a plan above whose first pass converts in_format
+   as it loads it, and whose last pass converts out_format as it stores
+   it, working in buf of 2 * N floats unless out_format is FFTS_FLOAT */
+void
+ffts_static_transform_half_32f(ffts_plan_t *p, const void *in, void *out,
+                               float *buf, int inv, int in_format,
+                               int out_format);
+#endif
+
 #endif /* FFTS_STATIC_H */
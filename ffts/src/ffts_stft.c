@@ -0,0 +1,576 @@
+/*
+
+This file is part of FFTS -- The Fastest Fourier Transform in the South
+
+Copyright (c) 2016, Jukka Ojanen <jukka.ojanen@kolumbus.fi>
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of the organization nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ANTHONY M. BLAKE BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "ffts_stft.h"
+#include "ffts_internal.h"
+#include "ffts_alloc.h"
+#include "ffts_trig.h"
+
+#ifdef HAVE_SSE
+#include <xmmintrin.h>
+#endif
+
+#include <string.h>
+
+/* Short-time Fourier transform of a stream of real samples: every hop
+   samples, the real FFT of the last N samples multiplied by the window.
+   The samples are kept in a ring buffer of N samples, whose oldest one
+   is at pos. Frames that wrap around the ring have to be gathered
+   anyway, so the window is applied by the gather, the only pass over
+   the frame before the real FFT, which writes the spectrum straight
+   into the caller's frame.
+*/
+
+/* kinds of plans of this file */
+#define FFTS_STFT_ANALYSIS  0
+#define FFTS_STFT_SYNTHESIS 1
+#define FFTS_STFT_PSD       2
+
+/* private state of STFT, inverse STFT and PSD plans */
+typedef struct _ffts_stft_state_t {
+    /* window, followed by the inverse of the sum of its squares */
+    float *window;
+
+    /* ring buffer of the last N samples, or the sums of the
+       overlap-add, then the sums of PSD plans, of size floats */
+    float *history;
+    size_t size;
+
+    size_t hop;
+    size_t pos;    /* oldest sample of the ring buffer */
+    size_t fill;   /* samples received since the last frame */
+    size_t frames; /* segments summed by PSD plans */
+} ffts_stft_state_t;
+
+static void
+ffts_free_stft(ffts_plan_t *p)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+
+    if (p->plans[0]) {
+        ffts_free(p->plans[0]);
+    }
+
+    if (p->A) {
+        ffts_mem_free(&p->allocator, p->A, FFTS_MEM_TABLES);
+    }
+
+    if (p->B) {
+        ffts_mem_free(&p->allocator, p->B, FFTS_MEM_TABLES);
+    }
+
+    if (s->window) {
+        ffts_mem_free(&p->allocator, s->window, FFTS_MEM_TABLES);
+    }
+
+    if (s->history) {
+        ffts_mem_free(&p->allocator, s->history, FFTS_MEM_SCRATCH);
+    }
+
+    if (p->buf) {
+        ffts_mem_free(&p->allocator, p->buf, FFTS_MEM_SCRATCH);
+    }
+
+    ffts_plan_release(p);
+}
+
+/* appends at most need - history_fill samples to the ring buffer, and
+   returns how many */
+static size_t
+ffts_stft_push(ffts_plan_t *p, const float *in, size_t n, size_t need)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    const size_t N = p->N;
+    size_t chunk, part;
+
+    chunk = need - s->fill;
+    if (chunk > n) {
+        chunk = n;
+    }
+
+    /* a chunk is at most N samples, so it wraps around once */
+    part = N - s->pos;
+    if (part > chunk) {
+        part = chunk;
+    }
+
+    memcpy(s->history + s->pos, in, part * sizeof(float));
+    memcpy(s->history, in + part, (chunk - part) * sizeof(float));
+
+    s->pos = (s->pos + chunk) & (N - 1);
+    s->fill += chunk;
+    return chunk;
+}
+
+/* the last N samples multiplied by the window */
+static void
+ffts_stft_gather(ffts_plan_t *p, float *FFTS_RESTRICT buf)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    const float *FFTS_RESTRICT w =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->window);
+    const float *FFTS_RESTRICT ring = (const float*) s->history;
+    const size_t N = p->N;
+    const size_t head = N - s->pos;
+    size_t t;
+
+    for (t = 0; t < head; t++) {
+        buf[t] = ring[s->pos + t] * w[t];
+    }
+
+    for (t = head; t < N; t++) {
+        buf[t] = ring[t - head] * w[t];
+    }
+}
+
+static size_t
+ffts_stft_scratch(ffts_plan_t *p, const float *in, size_t n, float *out,
+                  size_t stride, void *scratch)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    size_t count = 0, chunk;
+
+    while (n > 0) {
+        chunk = ffts_stft_push(p, in, n, s->hop);
+        in += chunk;
+        n -= chunk;
+
+        if (s->fill == s->hop) {
+            ffts_stft_gather(p, buf);
+            ffts_sub_transform(p, p->plans[0], buf, out, scratch);
+            s->fill = 0;
+            out += stride;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void
+ffts_execute_stft_scratch(ffts_plan_t *p, const void *in, void *out,
+                          void *scratch)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+
+    ffts_stft_scratch(p, (const float*) in, s->hop, (float*) out,
+        p->N + 2, scratch);
+}
+
+static void
+ffts_execute_stft(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_stft_scratch(p, in, out, NULL);
+}
+
+FFTS_API size_t
+ffts_stft(ffts_plan_t *p, const float *input, size_t n, void *frames,
+          size_t stride)
+{
+    /* rows are written by aligned stores */
+    if (!p || stride < p->N + 2 || (stride & 3)) {
+        return 0;
+    }
+
+    return ffts_stft_scratch(p, input, n, (float*) frames, stride, NULL);
+}
+
+/* Inverse STFT by weighted overlap-add: the inverse real FFT of every
+   frame, multiplied by the synthesis window, is added to the last N -
+   hop samples of the previous frames. The window is the same as that
+   of the analysis, and divided by N times the sum of its squares over
+   the frames that overlap each sample, which depends only on its
+   position modulo hop, so that the inverse of the STFT is the signal.
+   The window and the overlap-add are one pass over the frame, which
+   writes every output sample once and moves the rest of the sums.
+*/
+static size_t
+ffts_istft_scratch(ffts_plan_t *p, const float *in, size_t count,
+                   size_t stride, float *FFTS_RESTRICT out, void *scratch)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    const float *FFTS_RESTRICT w =
+        (const float*) FFTS_ASSUME_ALIGNED_32(s->window);
+    float *FFTS_RESTRICT y = (float*) (scratch ? scratch : p->buf);
+    float *FFTS_RESTRICT acc = s->history;
+    const size_t L = s->hop;
+    const size_t K = p->N - s->hop;
+    size_t f, j;
+
+    for (f = 0; f < count; f++) {
+        ffts_sub_transform(p, p->plans[0], in, y, scratch);
+
+        for (j = 0; j < L; j++) {
+            out[j] = (j < K ? acc[j] : 0.0f) + w[j] * y[j];
+        }
+
+        for (j = 0; j < K; j++) {
+            acc[j] = (L + j < K ? acc[L + j] : 0.0f) + w[L + j] * y[L + j];
+        }
+
+        in += stride;
+        out += L;
+    }
+
+    return count * L;
+}
+
+static void
+ffts_execute_istft_scratch(ffts_plan_t *p, const void *in, void *out,
+                           void *scratch)
+{
+    ffts_istft_scratch(p, (const float*) in, 1, p->N + 2, (float*) out,
+        scratch);
+}
+
+static void
+ffts_execute_istft(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_istft_scratch(p, in, out, NULL);
+}
+
+FFTS_API size_t
+ffts_istft(ffts_plan_t *p, const void *frames, size_t count, size_t stride,
+           float *output)
+{
+    /* rows are read by aligned loads */
+    if (!p || stride < p->N + 2 || (stride & 3)) {
+        return 0;
+    }
+
+    return ffts_istft_scratch(p, (const float*) frames, count, stride,
+        output, NULL);
+}
+
+/* Welch's averaged periodogram: segments of N samples every hop
+   samples, starting with the first N, are multiplied by the window and
+   their squared magnitudes summed. The plan has its own complex FFT of
+   N/2 points and tables of the real FFT in their scalar layout, so that
+   the post-processing of the real FFT adds |X[k]|^2 to the sums instead
+   of writing X[k]; the spectra are never stored. The sums follow the
+   ring buffer.
+*/
+static void
+ffts_psd_accumulate(ffts_plan_t *p, float *FFTS_RESTRICT buf)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    const float *FFTS_RESTRICT A = (const float*) FFTS_ASSUME_ALIGNED_32(p->A);
+    const float *FFTS_RESTRICT B = (const float*) FFTS_ASSUME_ALIGNED_32(p->B);
+    float *FFTS_RESTRICT acc = s->history + p->N;
+    const size_t N = p->N;
+    float re, im;
+    size_t i = 0;
+
+    buf[N + 0] = buf[0];
+    buf[N + 1] = buf[1];
+
+#ifdef HAVE_SSE
+    /* four k at a time, with buf[N - 2*k] read backwards */
+    for (; i + 3 < N/2; i += 4) {
+        __m128 z0 = _mm_loadu_ps(buf + 2*i);
+        __m128 z1 = _mm_loadu_ps(buf + 2*i + 4);
+        __m128 w0 = _mm_loadu_ps(buf + N - 2*i - 2);
+        __m128 w1 = _mm_loadu_ps(buf + N - 2*i - 6);
+        __m128 a0 = _mm_loadu_ps(A + 2*i);
+        __m128 a1 = _mm_loadu_ps(A + 2*i + 4);
+        __m128 b0 = _mm_loadu_ps(B + 2*i);
+        __m128 b1 = _mm_loadu_ps(B + 2*i + 4);
+        __m128 zr = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(2,0,2,0));
+        __m128 zi = _mm_shuffle_ps(z0, z1, _MM_SHUFFLE(3,1,3,1));
+        __m128 wr = _mm_shuffle_ps(w0, w1, _MM_SHUFFLE(0,2,0,2));
+        __m128 wi = _mm_shuffle_ps(w0, w1, _MM_SHUFFLE(1,3,1,3));
+        __m128 ar = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0));
+        __m128 ai = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1));
+        __m128 br = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0));
+        __m128 bi = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1));
+        __m128 xr = _mm_add_ps(
+            _mm_sub_ps(_mm_mul_ps(zr, ar), _mm_mul_ps(zi, ai)),
+            _mm_add_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi)));
+        __m128 xi = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(zi, ar), _mm_mul_ps(zr, ai)),
+            _mm_sub_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br)));
+
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i),
+            _mm_add_ps(_mm_mul_ps(xr, xr), _mm_mul_ps(xi, xi))));
+    }
+#endif
+
+    for (; i < N/2; i++) {
+        re = buf[    2*i + 0] * A[2*i + 0] - buf[    2*i + 1] * A[2*i + 1] +
+             buf[N - 2*i + 0] * B[2*i + 0] + buf[N - 2*i + 1] * B[2*i + 1];
+        im = buf[    2*i + 1] * A[2*i + 0] + buf[    2*i + 0] * A[2*i + 1] +
+             buf[N - 2*i + 0] * B[2*i + 1] - buf[N - 2*i + 1] * B[2*i + 0];
+
+        acc[i] += re * re + im * im;
+    }
+
+    re = buf[0] - buf[1];
+    acc[N/2] += re * re;
+}
+
+/* the average of the sums, one-sided and divided by the sum of the
+   squares of the window */
+static void
+ffts_psd_output(const ffts_plan_t *p, float *FFTS_RESTRICT out)
+{
+    const ffts_stft_state_t *s = (const ffts_stft_state_t*) p->state;
+    const float *FFTS_RESTRICT acc = s->history + p->N;
+    const size_t N = p->N;
+    float scale;
+    size_t k;
+
+    scale = s->frames ?
+        s->window[N] / (float) s->frames : 0.0f;
+
+    out[0] = scale * acc[0];
+    for (k = 1; k < N/2; k++) {
+        out[k] = 2.0f * scale * acc[k];
+    }
+    out[N/2] = scale * acc[N/2];
+}
+
+static size_t
+ffts_psd_scratch(ffts_plan_t *p, const float *in, size_t n, float *out,
+                 void *scratch)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+    float *buf = (float*) (scratch ? scratch : p->buf);
+    float *spec = buf + p->N;
+    size_t need, chunk;
+
+    while (n > 0) {
+        /* the first segment needs N samples, the next ones hop */
+        need = s->frames ? s->hop : p->N;
+        chunk = ffts_stft_push(p, in, n, need);
+        in += chunk;
+        n -= chunk;
+
+        if (s->fill == need) {
+            ffts_stft_gather(p, buf);
+            ffts_sub_transform(p, p->plans[0], buf, spec, scratch);
+            ffts_psd_accumulate(p, spec);
+            s->fill = 0;
+            s->frames++;
+        }
+    }
+
+    if (out) {
+        ffts_psd_output(p, out);
+    }
+
+    return s->frames;
+}
+
+static void
+ffts_execute_psd_scratch(ffts_plan_t *p, const void *in, void *out,
+                         void *scratch)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+
+    ffts_psd_scratch(p, (const float*) in, s->hop, (float*) out, scratch);
+}
+
+static void
+ffts_execute_psd(ffts_plan_t *p, const void *in, void *out)
+{
+    ffts_execute_psd_scratch(p, in, out, NULL);
+}
+
+FFTS_API size_t
+ffts_psd(ffts_plan_t *p, const float *input, size_t n, float *psd)
+{
+    if (!p) {
+        return 0;
+    }
+
+    return ffts_psd_scratch(p, input, n, psd, NULL);
+}
+
+FFTS_API void
+ffts_stft_reset(ffts_plan_t *p)
+{
+    ffts_stft_state_t *s = (ffts_stft_state_t*) p->state;
+
+    memset(s->history, 0, s->size * sizeof(float));
+    s->pos = 0;
+    s->fill = 0;
+    s->frames = 0;
+}
+
+static ffts_plan_t*
+ffts_init_stft_1d(size_t N, size_t hop, const float *window, int kind)
+{
+    ffts_stft_state_t *s;
+    ffts_plan_t *p;
+    size_t t;
+    float sum;
+
+    if (N < 4 || (N & (N - 1)) != 0) {
+        LOG("STFT size must be a power of two of at least 4\n");
+        return NULL;
+    }
+
+    if (hop < 1 || hop > N) {
+        LOG("STFT hop must be between 1 and the size\n");
+        return NULL;
+    }
+
+    p = ffts_plan_alloc(sizeof(*p) + sizeof(*s) + sizeof(*p->plans));
+    if (!p) {
+        return NULL;
+    }
+
+    s = (ffts_stft_state_t*) &p[1];
+
+    if (kind == FFTS_STFT_ANALYSIS) {
+        p->transform = &ffts_execute_stft;
+        p->transform_scratch = &ffts_execute_stft_scratch;
+    } else if (kind == FFTS_STFT_SYNTHESIS) {
+        p->transform = &ffts_execute_istft;
+        p->transform_scratch = &ffts_execute_istft_scratch;
+    } else {
+        p->transform = &ffts_execute_psd;
+        p->transform_scratch = &ffts_execute_psd_scratch;
+    }
+
+    p->destroy = &ffts_free_stft;
+    p->N       = N;
+    p->rank    = 1;
+    p->state   = s;
+    p->plans   = (ffts_plan_t**) &s[1];
+    p->plan_bytes = sizeof(*p) + sizeof(*s) + sizeof(*p->plans);
+
+    s->hop = hop;
+
+    if (kind == FFTS_STFT_PSD) {
+        p->plans[0] = ffts_init_1d(N/2, FFTS_FORWARD);
+    } else {
+        p->plans[0] = ffts_init_1d_real(N,
+            kind == FFTS_STFT_ANALYSIS ? FFTS_FORWARD : FFTS_BACKWARD);
+    }
+
+    if (!p->plans[0]) {
+        goto cleanup;
+    }
+
+    /* the frame, then the spectrum of PSD plans */
+    p->scratch_bytes = (kind == FFTS_STFT_PSD ? 2 * N + 4 : N) *
+        sizeof(float);
+    p->buf = ffts_mem_alloc(&p->allocator, p->scratch_bytes,
+        FFTS_MEM_SCRATCH);
+    if (!p->buf) {
+        goto cleanup;
+    }
+
+    /* the ring buffer, or the sums of the overlap-add, and the sums of
+       PSD plans, kept between calls and so counted with the plan */
+    s->size = kind == FFTS_STFT_PSD ? N + N/2 + 1 : N;
+    s->history = ffts_mem_alloc(&p->allocator, s->size * sizeof(float),
+        FFTS_MEM_SCRATCH);
+    if (!s->history) {
+        goto cleanup;
+    }
+    p->plan_bytes += s->size * sizeof(float);
+
+    /* the window, and the scale of PSD plans */
+    s->window = (float*) ffts_mem_alloc(&p->allocator,
+        (N + 1) * sizeof(float), FFTS_MEM_TABLES);
+    if (!s->window) {
+        goto cleanup;
+    }
+    p->table_bytes = (N + 1) * sizeof(float);
+
+    sum = 0.0f;
+    for (t = 0; t < N; t++) {
+        s->window[t] = window ? window[t] : 1.0f;
+        sum += s->window[t] * s->window[t];
+    }
+    s->window[N] = sum > 0.0f ? 1.0f / sum : 0.0f;
+
+    if (kind == FFTS_STFT_PSD) {
+        p->A = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+            FFTS_MEM_TABLES);
+        if (!p->A) {
+            goto cleanup;
+        }
+
+        p->B = (float*) ffts_mem_alloc(&p->allocator, N * sizeof(float),
+            FFTS_MEM_TABLES);
+        if (!p->B) {
+            goto cleanup;
+        }
+        p->table_bytes += 2 * N * sizeof(float);
+
+        ffts_generate_table_1d_real_32f(p, FFTS_FORWARD, 0);
+    }
+
+    if (kind == FFTS_STFT_SYNTHESIS) {
+        /* the sums of squares of every position modulo hop */
+        float *sums = (float*) p->buf;
+
+        memset(sums, 0, hop * sizeof(float));
+        for (t = 0; t < N; t++) {
+            sums[t % hop] += s->window[t] * s->window[t];
+        }
+
+        for (t = 0; t < N; t++) {
+            s->window[t] = sums[t % hop] > 0.0f ?
+                s->window[t] / ((float) N * sums[t % hop]) : 0.0f;
+        }
+    }
+
+    ffts_stft_reset(p);
+    return p;
+
+cleanup:
+    ffts_free_stft(p);
+    return NULL;
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_stft(size_t N, size_t hop, const float *window)
+{
+    return ffts_init_stft_1d(N, hop, window, FFTS_STFT_ANALYSIS);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_istft(size_t N, size_t hop, const float *window)
+{
+    return ffts_init_stft_1d(N, hop, window, FFTS_STFT_SYNTHESIS);
+}
+
+FFTS_API ffts_plan_t*
+ffts_init_psd(size_t N, size_t hop, const float *window)
+{
+    return ffts_init_stft_1d(N, hop, window, FFTS_STFT_PSD);
+}
@@ -44,9 +44,35 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define TSIZE 8
 
+/* sizes that are not multiples of the tiles below */
+static void
+ffts_transpose_any(const uint64_t *in, uint64_t *out, int w, int h)
+{
+    int i, j, x, y, x1, y1;
+
+    for (y = 0; y < h; y += TSIZE) {
+        y1 = (y + TSIZE < h) ? y + TSIZE : h;
+
+        for (x = 0; x < w; x += TSIZE) {
+            x1 = (x + TSIZE < w) ? x + TSIZE : w;
+
+            for (i = x; i < x1; i++) {
+                for (j = y; j < y1; j++) {
+                    out[i*h + j] = in[j*w + i];
+                }
+            }
+        }
+    }
+}
+
 void
 ffts_transpose(uint64_t *in, uint64_t *out, int w, int h)
 {
+    if ((w % TSIZE) || (h % TSIZE)) {
+        ffts_transpose_any(in, out, w, h);
+        return;
+    }
+
 #ifdef HAVE_NEON
 #if 0
     neon_transpose4(in, out, w, h);
@@ -191,4 +217,25 @@ ffts_transpose(uint64_t *in, uint64_t *out, int w, int h)
         }
     }
 #endif
-}
\ No newline at end of file
+}
+
+void
+ffts_transpose_32f(const float *in, float *out, size_t w, size_t h)
+{
+    size_t i, j, x, y, x1, y1;
+
+    /* tiles of TSIZE x TSIZE keep both sides in cache */
+    for (y = 0; y < h; y += TSIZE) {
+        y1 = (y + TSIZE < h) ? y + TSIZE : h;
+
+        for (x = 0; x < w; x += TSIZE) {
+            x1 = (x + TSIZE < w) ? x + TSIZE : w;
+
+            for (i = x; i < x1; i++) {
+                for (j = y; j < y1; j++) {
+                    out[i*h + j] = in[j*w + i];
+                }
+            }
+        }
+    }
+}
@@ -43,4 +43,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 void
 ffts_transpose(uint64_t *in, uint64_t *out, int w, int h);
 
+/* transpose a matrix of h rows of w floats */
+void
+ffts_transpose_32f(const float *in, float *out, size_t w, size_t h);
+
 #endif /* FFTS_TRANSPOSE_H */
@@ -337,6 +337,26 @@ ffts_cexp_32f(size_t n, size_t d, float *output)
     return 0;
 }
 
+/* same angle as ffts_cexp_32f, in double precision */
+int
+ffts_cexp_64f(size_t n, size_t d, double *output)
+{
+    double FFTS_ALIGN(16) z[2];
+
+    if (!d || !output)
+        return -1;
+
+    /* reduction */
+    if (FFTS_UNLIKELY(n >= d))
+        n %= d;
+
+    ffts_cexp_32f64f(n, d, z);
+
+    output[0] = z[0];
+    output[1] = z[1];
+    return 0;
+}
+
 /* used as intermediate result for single precision calculations */
 static int
 ffts_cexp_32f64f(size_t n, size_t d, double *output)
@@ -43,6 +43,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 int
 ffts_cexp_32f(size_t n, size_t d, float *output);
 
+int
+ffts_cexp_64f(size_t n, size_t d, double *output);
+
 int
 ffts_generate_chirp_32f(ffts_cpx_32f *const table, size_t table_size);
 
@@ -86,10 +86,10 @@ V4SF_K_N(int inv,
 
 static FFTS_INLINE void
 V4SF_L_2_4(int inv,
-           const float *FFTS_RESTRICT i0,
-           const float *FFTS_RESTRICT i1,
-           const float *FFTS_RESTRICT i2,
-           const float *FFTS_RESTRICT i3,
+           V4SF x0,
+           V4SF x1,
+           V4SF x2,
+           V4SF x3,
            V4SF *r0,
            V4SF *r1,
            V4SF *r2,
@@ -97,10 +97,10 @@ V4SF_L_2_4(int inv,
 {
     V4SF t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = V4SF_LD(i0);
-    t1 = V4SF_LD(i1);
-    t2 = V4SF_LD(i2);
-    t3 = V4SF_LD(i3);
+    t0 = x0;
+    t1 = x1;
+    t2 = x2;
+    t3 = x3;
 
     t4 = V4SF_ADD(t0, t1);
     t5 = V4SF_SUB(t0, t1);
@@ -123,10 +123,10 @@ V4SF_L_2_4(int inv,
 
 static FFTS_INLINE void
 V4SF_L_4_4(int inv,
-           const float *FFTS_RESTRICT i0,
-           const float *FFTS_RESTRICT i1,
-           const float *FFTS_RESTRICT i2,
-           const float *FFTS_RESTRICT i3,
+           V4SF x0,
+           V4SF x1,
+           V4SF x2,
+           V4SF x3,
            V4SF *r0,
            V4SF *r1,
            V4SF *r2,
@@ -134,10 +134,10 @@ V4SF_L_4_4(int inv,
 {
     V4SF t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = V4SF_LD(i0);
-    t1 = V4SF_LD(i1);
-    t2 = V4SF_LD(i2);
-    t3 = V4SF_LD(i3);
+    t0 = x0;
+    t1 = x1;
+    t2 = x2;
+    t3 = x3;
 
     t4 = V4SF_ADD(t0, t1);
     t5 = V4SF_SUB(t0, t1);
@@ -161,10 +161,10 @@ V4SF_L_4_4(int inv,
 
 static FFTS_INLINE void
 V4SF_L_4_2(int inv,
-           const float *FFTS_RESTRICT i0,
-           const float *FFTS_RESTRICT i1,
-           const float *FFTS_RESTRICT i2,
-           const float *FFTS_RESTRICT i3,
+           V4SF x0,
+           V4SF x1,
+           V4SF x2,
+           V4SF x3,
            V4SF *r0,
            V4SF *r1,
            V4SF *r2,
@@ -172,10 +172,10 @@ V4SF_L_4_2(int inv,
 {
     V4SF t0, t1, t2, t3, t4, t5, t6, t7;
 
-    t0 = V4SF_LD(i0);
-    t1 = V4SF_LD(i1);
-    t6 = V4SF_LD(i2);
-    t7 = V4SF_LD(i3);
+    t0 = x0;
+    t1 = x1;
+    t6 = x2;
+    t7 = x3;
 
     t2 = V4SF_BLEND(t6, t7);
     t3 = V4SF_BLEND(t7, t6);
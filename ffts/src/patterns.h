@@ -39,6 +39,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 #endif
 
+#include "ffts_alloc.h"
+
 #include <stddef.h>
 
 #ifdef HAVE_STDLIB_H
@@ -420,13 +422,13 @@ ffts_hardcodedleaf_is_rec_odd(ptrdiff_t **is,
 #endif
 
 static ptrdiff_t*
-ffts_init_is(size_t N, size_t leaf_N, int VL)
+ffts_init_is(ffts_allocator_t *a, size_t N, size_t leaf_N, int VL)
 {
     int i, i0, i1, i2;
     int stride = ffts_ctzl(N/leaf_N);
     ptrdiff_t *is, *pis;
 
-    is = malloc(N / VL * sizeof(*is));
+    is = ffts_mem_alloc(a, N / VL * sizeof(*is), FFTS_MEM_TABLES);
     if (!is) {
         return NULL;
     }
@@ -479,19 +481,19 @@ ffts_init_is(size_t N, size_t leaf_N, int VL)
 }
 
 static ptrdiff_t*
-ffts_init_offsets(size_t N, size_t leaf_N)
+ffts_init_offsets(ffts_allocator_t *a, size_t N, size_t leaf_N)
 {
     ptrdiff_t *offsets, *tmp;
     size_t i;
 
-    offsets = malloc(N/leaf_N * sizeof(*offsets));
+    offsets = ffts_mem_alloc(a, N/leaf_N * sizeof(*offsets), FFTS_MEM_TABLES);
     if (!offsets) {
         return NULL;
     }
 
-    tmp = malloc(2 * N/leaf_N * sizeof(*tmp));
+    tmp = ffts_mem_alloc(a, 2 * N/leaf_N * sizeof(*tmp), FFTS_MEM_TEMP);
     if (!tmp) {
-        free(offsets);
+        ffts_mem_free(a, offsets, FFTS_MEM_TABLES);
         return NULL;
     }
 
@@ -513,7 +515,7 @@ ffts_init_offsets(size_t N, size_t leaf_N)
         offsets[i] = 2 * tmp[2*i + 1];
     }
 
-    free(tmp);
+    ffts_mem_free(a, tmp, FFTS_MEM_TEMP);
     return offsets;
 }
 
@@ -39,8 +39,14 @@
 #include <xmmintrin.h>
 #endif
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -128,8 +134,850 @@ int test_transform(int n, int sign)
     return 1;
 }
 
+static void *test_malloc(size_t size)
+{
+    void *p;
+
+#ifdef HAVE_SSE
+    p = _mm_malloc(size ? size : 1, 32);
+#else
+    p = valloc(size ? size : 1);
+#endif
+
+    if (p) {
+        memset(p, 0, size);
+    }
+
+    return p;
+}
+
+static void test_free(void *p)
+{
+#ifdef HAVE_SSE
+    _mm_free(p);
+#else
+    free(p);
+#endif
+}
+
+static void random_fill(float *data, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        data[i] = (float) rand() / (float) RAND_MAX - 0.5f;
+    }
+}
+
+#define SHARED_THREADS 4
+#define SHARED_ROUNDS  16
+
+typedef struct shared_thread {
+    ffts_plan_t *p;
+    const float *input;
+    const float *expected;
+    size_t output_size;
+    int errors;
+} shared_thread;
+
+/* executes the shared plan with private scratch and output */
+static void *shared_thread_run(void *arg)
+{
+    shared_thread *t = (shared_thread*) arg;
+    float *output = test_malloc(t->output_size * sizeof(float));
+    void *scratch = test_malloc(ffts_scratch_size(t->p));
+    int i;
+
+    if (!output || !scratch) {
+        t->errors++;
+    } else {
+        for (i = 0; i < SHARED_ROUNDS; i++) {
+            memset(output, 0, t->output_size * sizeof(float));
+            ffts_execute_with_scratch(t->p, t->input, output, scratch);
+            if (memcmp(output, t->expected, t->output_size * sizeof(float))) {
+                t->errors++;
+            }
+        }
+    }
+
+    test_free(output);
+    test_free(scratch);
+    return NULL;
+}
+
+/* runs one plan on several threads, each with its own scratch, and
+   compares their outputs against ffts_execute */
+static int test_shared_plan(const char *name, ffts_plan_t *p,
+                            size_t input_size, size_t output_size)
+{
+    shared_thread threads[SHARED_THREADS];
+#ifdef HAVE_PTHREAD
+    pthread_t tids[SHARED_THREADS];
+#endif
+    float *input, *expected;
+    int i, errors = 0;
+
+    if (!p) {
+        printf(" %-26s | plan unsupported\n", name);
+        return 1;
+    }
+
+    input = test_malloc(input_size * sizeof(float));
+    expected = test_malloc(output_size * sizeof(float));
+    random_fill(input, input_size);
+    ffts_execute(p, input, expected);
+
+    for (i = 0; i < SHARED_THREADS; i++) {
+        threads[i].p = p;
+        threads[i].input = input;
+        threads[i].expected = expected;
+        threads[i].output_size = output_size;
+        threads[i].errors = 0;
+    }
+
+#ifdef HAVE_PTHREAD
+    for (i = 0; i < SHARED_THREADS; i++) {
+        if (pthread_create(&tids[i], NULL, shared_thread_run, &threads[i])) {
+            shared_thread_run(&threads[i]);
+            tids[i] = pthread_self();
+        }
+    }
+
+    for (i = 0; i < SHARED_THREADS; i++) {
+        if (!pthread_equal(tids[i], pthread_self())) {
+            pthread_join(tids[i], NULL);
+        }
+    }
+#else
+    /* without threads, still check that the scratch path matches */
+    for (i = 0; i < SHARED_THREADS; i++) {
+        shared_thread_run(&threads[i]);
+    }
+#endif
+
+    for (i = 0; i < SHARED_THREADS; i++) {
+        errors += threads[i].errors;
+    }
+
+    printf(" %-26s | %s\n", name, errors ? "FAILED" : "ok");
+
+    ffts_free(p);
+    test_free(input);
+    test_free(expected);
+    return errors != 0;
+}
+
+static int test_shared_plans(void)
+{
+    size_t dims[3] = { 16, 32, 64 };
+    int otf, failed = 0;
+
+    printf(" Shared plan, %d threads    | Result\n", SHARED_THREADS);
+    printf("----------------------------+-------\n");
+
+    /* plans of 64 points or more with twiddles computed on the fly
+       keep their work buffers in the scratch as well */
+    for (otf = 0; otf < 2; otf++) {
+        ffts_set_otf_twiddles(otf ? 64 : 0);
+
+        failed += test_shared_plan(otf ? "complex 1D 4096, otf" :
+            "complex 1D 4096", ffts_init_1d(4096, FFTS_FORWARD),
+            2 * 4096, 2 * 4096);
+        failed += test_shared_plan(otf ? "real 1D 8192, otf" :
+            "real 1D 8192", ffts_init_1d_real(8192, FFTS_FORWARD),
+            8192, 8192 + 2);
+        failed += test_shared_plan(otf ? "complex 2D 64x128, otf" :
+            "complex 2D 64x128", ffts_init_2d(64, 128, FFTS_FORWARD),
+            2 * 64 * 128, 2 * 64 * 128);
+        failed += test_shared_plan(otf ? "complex 3D 16x32x64, otf" :
+            "complex 3D 16x32x64", ffts_init_nd(3, dims, FFTS_FORWARD),
+            2 * 16 * 32 * 64, 2 * 16 * 32 * 64);
+        failed += test_shared_plan(otf ? "real 2D 64x128, otf" :
+            "real 2D 64x128", ffts_init_2d_real(64, 128, FFTS_FORWARD),
+            64 * 128, 64 * (128 / 2 + 1) * 2);
+        failed += test_shared_plan(otf ? "real 3D 16x32x64, otf" :
+            "real 3D 16x32x64", ffts_init_nd_real(3, dims, FFTS_FORWARD),
+            16 * 32 * 64, 16 * 32 * (64 / 2 + 1) * 2);
+        failed += test_shared_plan(otf ? "real 3D 16x32x64 inv, otf" :
+            "real 3D 16x32x64 inv", ffts_init_nd_real(3, dims,
+            FFTS_BACKWARD), 16 * 32 * (64 / 2 + 1) * 2, 16 * 32 * 64);
+    }
+
+    ffts_set_otf_twiddles(0);
+    printf("\n");
+    return failed;
+}
+
+#define CONV_L      100
+#define CONV_M      37
+#define CONV_CALLS  5
+
+/* streams CONV_CALLS blocks of CONV_L samples through a convolution plan
+   and compares them against the direct sum */
+static int test_conv(const char *name, int real, int flags)
+{
+    const size_t c = real ? 1 : 2;
+    const size_t T = CONV_CALLS * CONV_L;
+    float *h = test_malloc(c * CONV_M * sizeof(float));
+    float *x = test_malloc(c * T * sizeof(float));
+    float *y = test_malloc(c * T * sizeof(float));
+    ffts_plan_t *p;
+    double err = 0.0, norm = 0.0;
+    size_t i, n, m;
+
+    random_fill(h, c * CONV_M);
+    random_fill(x, c * T);
+
+    p = real ? ffts_init_conv_real(CONV_L, h, CONV_M, flags) :
+        ffts_init_conv(CONV_L, h, CONV_M, flags);
+    if (!p) {
+        printf(" %-26s | plan unsupported\n", name);
+        test_free(h);
+        test_free(x);
+        test_free(y);
+        return 1;
+    }
+
+    for (i = 0; i < CONV_CALLS; i++) {
+        ffts_execute(p, x + c * i * CONV_L, y + c * i * CONV_L);
+    }
+
+    for (n = 0; n < T; n++) {
+        double re = 0.0, im = 0.0;
+
+        for (m = 0; m < CONV_M; m++) {
+            /* x[n - m], or x[n - M + 1 + m] against conj(h[m]) */
+            ptrdiff_t k = (flags & FFTS_CONV_CORRELATE) ?
+                (ptrdiff_t) (n + m) - (CONV_M - 1) : (ptrdiff_t) (n - m);
+            double hr, hi, xr, xi;
+
+            if (k < 0) {
+                continue;
+            }
+
+            hr = h[c * m];
+            hi = real ? 0.0 : h[c * m + 1];
+            xr = x[c * k];
+            xi = real ? 0.0 : x[c * k + 1];
+
+            if (flags & FFTS_CONV_CORRELATE) {
+                hi = -hi;
+            }
+
+            re += hr * xr - hi * xi;
+            im += hr * xi + hi * xr;
+        }
+
+        err += (y[c * n] - re) * (y[c * n] - re);
+        norm += re * re;
+        if (!real) {
+            err += (y[c * n + 1] - im) * (y[c * n + 1] - im);
+            norm += im * im;
+        }
+    }
+
+    err = sqrt(err / norm);
+    printf(" %-26s | %s (%.2e)\n", name, err < 1e-5 ? "ok" : "FAILED", err);
+
+    ffts_free(p);
+    test_free(h);
+    test_free(x);
+    test_free(y);
+    return err >= 1e-5;
+}
+
+static int test_convs(void)
+{
+    int failed = 0;
+
+    printf(" Convolution, L %d, M %d   | Result\n", CONV_L, CONV_M);
+    printf("----------------------------+-------\n");
+
+    failed += test_conv("real, overlap-save", 1,
+        FFTS_CONV_OVERLAP_SAVE);
+    failed += test_conv("real, overlap-add", 1,
+        FFTS_CONV_OVERLAP_ADD);
+    failed += test_conv("real, correlate save", 1,
+        FFTS_CONV_OVERLAP_SAVE | FFTS_CONV_CORRELATE);
+    failed += test_conv("real, correlate add", 1,
+        FFTS_CONV_OVERLAP_ADD | FFTS_CONV_CORRELATE);
+    failed += test_conv("complex, overlap-save", 0,
+        FFTS_CONV_OVERLAP_SAVE);
+    failed += test_conv("complex, overlap-add", 0,
+        FFTS_CONV_OVERLAP_ADD);
+    failed += test_conv("complex, correlate save", 0,
+        FFTS_CONV_OVERLAP_SAVE | FFTS_CONV_CORRELATE);
+    failed += test_conv("complex, correlate add", 0,
+        FFTS_CONV_OVERLAP_ADD | FFTS_CONV_CORRELATE);
+
+    printf("\n");
+    return failed;
+}
+
+#define PSD_N    64
+#define PSD_HOP  16
+#define PSD_T    1000
+#define PSD_STEP 37
+
+/* feeds PSD_T samples to a Welch PSD plan in chunks of PSD_STEP and
+   compares the segment count and the average against periodograms
+   computed directly */
+static int test_psd(const char *name, int hann)
+{
+    const size_t count = (PSD_T - PSD_N) / PSD_HOP + 1;
+    float *window = test_malloc(PSD_N * sizeof(float));
+    float *x = test_malloc(PSD_T * sizeof(float));
+    float *psd = test_malloc((PSD_N / 2 + 1) * sizeof(float));
+    double ref[PSD_N / 2 + 1] = { 0.0 };
+    double w2 = 0.0, err = 0.0, norm = 0.0, power = 0.0, sum = 0.0;
+    ffts_plan_t *p;
+    size_t i, j, k, n, segments = 0;
+    int failed;
+
+    for (j = 0; j < PSD_N; j++) {
+        window[j] = hann ?
+            (float) (0.5 - 0.5 * cos(2 * M_PI * j / PSD_N)) : 1.0f;
+        w2 += (double) window[j] * window[j];
+    }
+
+    random_fill(x, PSD_T);
+
+    p = ffts_init_psd(PSD_N, PSD_HOP, hann ? window : NULL);
+    if (!p) {
+        printf(" %-26s | plan unsupported\n", name);
+        test_free(window);
+        test_free(x);
+        test_free(psd);
+        return 1;
+    }
+
+    for (i = 0; i < PSD_T; i += n) {
+        n = (PSD_T - i < PSD_STEP) ? PSD_T - i : PSD_STEP;
+        segments = ffts_psd(p, x + i, n, (i + n == PSD_T) ? psd : NULL);
+    }
+
+    /* one-sided |X[k]|^2 of every segment, divided by the sum of the
+       squares of the window */
+    for (i = 0; i < count; i++) {
+        const float *seg = x + i * PSD_HOP;
+
+        for (k = 0; k <= PSD_N / 2; k++) {
+            double re = 0.0, im = 0.0;
+
+            for (j = 0; j < PSD_N; j++) {
+                re += window[j] * seg[j] * cos(2 * M_PI * j * k / PSD_N);
+                im -= window[j] * seg[j] * sin(2 * M_PI * j * k / PSD_N);
+            }
+
+            ref[k] += ((k == 0 || k == PSD_N / 2) ? 1.0 : 2.0) *
+                (re * re + im * im) / (w2 * count);
+        }
+
+        for (j = 0; j < PSD_N; j++) {
+            power += (double) seg[j] * seg[j] / (PSD_N * count);
+        }
+    }
+
+    for (k = 0; k <= PSD_N / 2; k++) {
+        err += (psd[k] - ref[k]) * (psd[k] - ref[k]);
+        norm += ref[k] * ref[k];
+        sum += psd[k];
+    }
+
+    err = sqrt(err / norm);
+    failed = segments != count || err >= 1e-5;
+
+    /* Parseval: without a window, the sum over N is the mean square */
+    if (!hann && fabs(sum / PSD_N - power) >= 1e-5 * power) {
+        failed = 1;
+    }
+
+    printf(" %-26s | %s (%.2e, %d segments)\n", name,
+        failed ? "FAILED" : "ok", err, (int) segments);
+
+    ffts_free(p);
+    test_free(window);
+    test_free(x);
+    test_free(psd);
+    return failed;
+}
+
+#define STFT_N      256
+#define STFT_HOP    64
+#define STFT_STRIDE (STFT_N + 4)
+#define STFT_T      4096
+
+/* STFT of a random signal followed by the ISTFT of its frames, which
+   must give the signal back delayed by N - hop samples */
+static int test_stft_round_trip(const char *name)
+{
+    const size_t count = STFT_T / STFT_HOP;
+    float *window = test_malloc(STFT_N * sizeof(float));
+    float *x = test_malloc(STFT_T * sizeof(float));
+    float *y = test_malloc(STFT_T * sizeof(float));
+    float *frames = test_malloc(count * STFT_STRIDE * sizeof(float));
+    ffts_plan_t *p, *q;
+    double err = 0.0, norm = 0.0;
+    size_t i, written = 0, samples = 0;
+    int failed;
+
+    for (i = 0; i < STFT_N; i++) {
+        window[i] = (float) (0.5 - 0.5 * cos(2 * M_PI * i / STFT_N));
+    }
+
+    random_fill(x, STFT_T);
+
+    p = ffts_init_stft(STFT_N, STFT_HOP, window);
+    q = ffts_init_istft(STFT_N, STFT_HOP, window);
+    if (!p || !q) {
+        printf(" %-26s | plan unsupported\n", name);
+        failed = 1;
+        goto cleanup;
+    }
+
+    /* in two calls, the first ending in the middle of a hop */
+    written = ffts_stft(p, x, 1000, frames, STFT_STRIDE);
+    written += ffts_stft(p, x + 1000, STFT_T - 1000,
+        frames + written * STFT_STRIDE, STFT_STRIDE);
+    samples = ffts_istft(q, frames, written, STFT_STRIDE, y);
+
+    for (i = 0; i + STFT_N - STFT_HOP < samples; i++) {
+        double d = y[i + STFT_N - STFT_HOP] - x[i];
+
+        err += d * d;
+        norm += (double) x[i] * x[i];
+    }
+
+    err = sqrt(err / norm);
+    failed = written != count || samples != STFT_T || err >= 1e-5;
+
+    printf(" %-26s | %s (%.2e, %d frames)\n", name,
+        failed ? "FAILED" : "ok", err, (int) written);
+
+cleanup:
+    if (p) {
+        ffts_free(p);
+    }
+
+    if (q) {
+        ffts_free(q);
+    }
+
+    test_free(window);
+    test_free(x);
+    test_free(y);
+    test_free(frames);
+    return failed;
+}
+
+static int test_spectra(void)
+{
+    int failed = 0;
+
+    printf(" Welch PSD and STFT         | Result\n");
+    printf("----------------------------+-------\n");
+
+    failed += test_psd("PSD 64, hop 16, Hann", 1);
+    failed += test_psd("PSD 64, hop 16, no window", 0);
+    failed += test_stft_round_trip("STFT/ISTFT 256, hop 64");
+
+    printf("\n");
+    return failed;
+}
+
+#define INT_SCALE (1.0f / 4096)
+
+/* transforms random integer input with an integer input plan, one value
+   past an aligned address, and compares it against the float plan of the
+   same size on the converted input */
+static int test_int(const char *name, size_t N, int sign, int format,
+                    int real)
+{
+    const size_t n = real ? N : 2 * N;
+    const size_t size = (format == FFTS_INT16) ? 2 : 1;
+    const size_t out_n = real ? 2 * (N / 2 + 1) : 2 * N;
+    char *data = test_malloc((n + 1) * size);
+    float *x = test_malloc(n * sizeof(float));
+    float *y = test_malloc(out_n * sizeof(float));
+    float *ref = test_malloc(out_n * sizeof(float));
+    ffts_plan_t *p, *q;
+    double err = 0.0, norm = 0.0;
+    size_t i;
+
+    p = real ? ffts_init_1d_real_int(N, format, INT_SCALE) :
+        ffts_init_1d_int(N, sign, format, INT_SCALE);
+    q = real ? ffts_init_1d_real(N, sign) : ffts_init_1d(N, sign);
+    if (!p || !q) {
+        printf(" %-26s | plan unsupported\n", name);
+        if (p) {
+            ffts_free(p);
+        }
+        if (q) {
+            ffts_free(q);
+        }
+        test_free(data);
+        test_free(x);
+        test_free(y);
+        test_free(ref);
+        return 1;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (format == FFTS_INT16) {
+            int16_t v = (int16_t) (rand() % 65536 - 32768);
+
+            memcpy(data + (i + 1) * size, &v, sizeof(v));
+            x[i] = v * INT_SCALE;
+        } else {
+            int8_t v = (int8_t) (rand() % 256 - 128);
+
+            data[i + 1] = v;
+            x[i] = v * INT_SCALE;
+        }
+    }
+
+    ffts_execute(p, data + size, y);
+    ffts_execute(q, x, ref);
+
+    for (i = 0; i < out_n; i++) {
+        err += (y[i] - ref[i]) * (y[i] - ref[i]);
+        norm += ref[i] * ref[i];
+    }
+
+    err = sqrt(err / norm);
+    printf(" %-26s | %s (%.2e)\n", name, err < 1e-6 ? "ok" : "FAILED", err);
+
+    ffts_free(p);
+    ffts_free(q);
+    test_free(data);
+    test_free(x);
+    test_free(y);
+    test_free(ref);
+    return err >= 1e-6;
+}
+
+static int test_ints(void)
+{
+    int failed = 0;
+
+    printf(" Integer input              | Result\n");
+    printf("----------------------------+-------\n");
+
+    failed += test_int("int16 16, forward", 16, -1, FFTS_INT16, 0);
+    failed += test_int("int16 64, forward", 64, -1, FFTS_INT16, 0);
+    failed += test_int("int16 4096, forward", 4096, -1, FFTS_INT16, 0);
+    failed += test_int("int16 4096, backward", 4096, 1, FFTS_INT16, 0);
+    failed += test_int("int8 64, backward", 64, 1, FFTS_INT8, 0);
+    failed += test_int("int8 4096, forward", 4096, -1, FFTS_INT8, 0);
+    failed += test_int("int16 real 1024", 1024, -1, FFTS_INT16, 1);
+    failed += test_int("int8 real 1024", 1024, -1, FFTS_INT8, 1);
+
+    printf("\n");
+    return failed;
+}
+
+/* transforms random input with a half precision plan, its half arrays
+   one value past an aligned address, and compares it bit for bit against
+   the float plan of the same size between the conversions */
+static int test_half(const char *name, size_t N, int sign, int in_format,
+                     int out_format, int real)
+{
+    const size_t in_n = (real && sign > 0) ? N + 2 : (real ? N : 2 * N);
+    const size_t out_n = (real && sign < 0) ? N + 2 : (real ? N : 2 * N);
+    const size_t in_size = in_format == FFTS_FLOAT ? 4 : 2;
+    const size_t out_size = out_format == FFTS_FLOAT ? 4 : 2;
+    const size_t in_skip = in_format == FFTS_FLOAT ? 0 : 2;
+    const size_t out_skip = out_format == FFTS_FLOAT ? 0 : 2;
+    char *data = test_malloc(in_n * in_size + in_skip);
+    char *y = test_malloc(out_n * out_size + out_skip);
+    char *expected = test_malloc(out_n * out_size);
+    float *x = test_malloc(in_n * sizeof(float));
+    float *ref = test_malloc(out_n * sizeof(float));
+    ffts_plan_t *p, *q;
+    int differ;
+
+    p = real ? ffts_init_1d_real_half(N, sign, in_format, out_format) :
+        ffts_init_1d_half(N, sign, in_format, out_format);
+    q = real ? ffts_init_1d_real(N, sign) : ffts_init_1d(N, sign);
+    if (!p || !q) {
+        printf(" %-26s | plan unsupported\n", name);
+        if (p) {
+            ffts_free(p);
+        }
+        if (q) {
+            ffts_free(q);
+        }
+        test_free(data);
+        test_free(y);
+        test_free(expected);
+        test_free(x);
+        test_free(ref);
+        return 1;
+    }
+
+    random_fill(x, in_n);
+    if (in_format != FFTS_FLOAT) {
+        ffts_float_to_half(x, data + in_skip, in_n, in_format);
+        ffts_half_to_float(data + in_skip, x, in_n, in_format);
+    } else {
+        memcpy(data, x, in_n * sizeof(float));
+    }
+
+    ffts_execute(p, data + in_skip, y + out_skip);
+    ffts_execute(q, x, ref);
+
+    if (out_format != FFTS_FLOAT) {
+        ffts_float_to_half(ref, expected, out_n, out_format);
+    } else {
+        memcpy(expected, ref, out_n * sizeof(float));
+    }
+
+    differ = memcmp(y + out_skip, expected, out_n * out_size) != 0;
+    printf(" %-26s | %s\n", name, differ ? "FAILED" : "ok");
+
+    ffts_free(p);
+    ffts_free(q);
+    test_free(data);
+    test_free(y);
+    test_free(expected);
+    test_free(x);
+    test_free(ref);
+    return differ;
+}
+
+static int test_halves(void)
+{
+    int failed = 0;
+
+    printf(" Half precision             | Result\n");
+    printf("----------------------------+-------\n");
+
+    failed += test_half("fp16 16, forward", 16, -1, FFTS_FP16, FFTS_FP16, 0);
+    failed += test_half("fp16 64, forward", 64, -1, FFTS_FP16, FFTS_FP16, 0);
+    failed += test_half("fp16 4096, backward", 4096, 1,
+        FFTS_FP16, FFTS_FP16, 0);
+    failed += test_half("bf16 32, backward", 32, 1, FFTS_BF16, FFTS_BF16, 0);
+    failed += test_half("bf16 128, forward", 128, -1,
+        FFTS_BF16, FFTS_BF16, 0);
+    failed += test_half("bf16 4096, forward", 4096, -1,
+        FFTS_BF16, FFTS_BF16, 0);
+    failed += test_half("float to bf16 1024", 1024, -1,
+        FFTS_FLOAT, FFTS_BF16, 0);
+    failed += test_half("bf16 to float 1024", 1024, -1,
+        FFTS_BF16, FFTS_FLOAT, 0);
+    failed += test_half("fp16 real 1024, forward", 1024, -1,
+        FFTS_FP16, FFTS_FP16, 1);
+    failed += test_half("bf16 real 1024, backward", 1024, 1,
+        FFTS_BF16, FFTS_BF16, 1);
+
+    printf("\n");
+    return failed;
+}
+
+#define CHANNELIZER_T 2000
+
+/* feeds CHANNELIZER_T samples to a channelizer of K channels in chunks
+   that straddle the blocks, and compares every block against the
+   direct sum of ffts_init_channelizer */
+static int test_channelizer(const char *name, size_t K, size_t M, int flags)
+{
+    static const size_t steps[] = { 5, 23, 1, 37, 16, 9, 70 };
+    const size_t D = (flags & FFTS_CHANNELIZER_OVERSAMPLED) ? K / 2 : K;
+    const size_t blocks = CHANNELIZER_T / D;
+    float *h = test_malloc(M * sizeof(float));
+    float *x = test_malloc(2 * CHANNELIZER_T * sizeof(float));
+    float *y = test_malloc(2 * K * (blocks + 1) * sizeof(float));
+    ffts_plan_t *p;
+    double err = 0.0, norm = 0.0;
+    size_t t = 0, c = 0, count = 0, b, k, m;
+
+    random_fill(h, M);
+    random_fill(x, 2 * CHANNELIZER_T);
+
+    p = ffts_init_channelizer(K, h, M, flags);
+    if (!p) {
+        printf(" %-26s | plan unsupported\n", name);
+        test_free(h);
+        test_free(x);
+        test_free(y);
+        return 1;
+    }
+
+    while (t < CHANNELIZER_T) {
+        size_t step = steps[c++ % (sizeof(steps) / sizeof(steps[0]))];
+
+        if (step > CHANNELIZER_T - t) {
+            step = CHANNELIZER_T - t;
+        }
+
+        count += ffts_channelize(p, x + 2 * t, step, y + 2 * K * count);
+        t += step;
+    }
+
+    if (count != blocks) {
+        printf(" %-26s | FAILED (%lu blocks instead of %lu)\n", name,
+            (unsigned long) count, (unsigned long) blocks);
+        ffts_free(p);
+        test_free(h);
+        test_free(x);
+        test_free(y);
+        return 1;
+    }
+
+    for (b = 0; b < blocks; b++) {
+        /* the last sample of the block */
+        const size_t s = (b + 1) * D - 1;
+        const float *yb = y + 2 * K * b;
+
+        for (k = 0; k < K; k++) {
+            double re = 0.0, im = 0.0;
+
+            /* samples before the first ones are zeros */
+            for (m = 0; m < M && m <= s; m++) {
+                double a = -2.0 * M_PI * (double) ((k * (s - m)) % K) / K;
+                double xr = x[2 * (s - m) + 0];
+                double xi = x[2 * (s - m) + 1];
+
+                re += h[m] * (xr * cos(a) - xi * sin(a));
+                im += h[m] * (xr * sin(a) + xi * cos(a));
+            }
+
+            err += (yb[2 * k] - re) * (yb[2 * k] - re) +
+                (yb[2 * k + 1] - im) * (yb[2 * k + 1] - im);
+            norm += re * re + im * im;
+        }
+    }
+
+    err = sqrt(err / norm);
+    printf(" %-26s | %s (%.2e)\n", name, err < 1e-5 ? "ok" : "FAILED", err);
+
+    ffts_free(p);
+    test_free(h);
+    test_free(x);
+    test_free(y);
+    return err >= 1e-5;
+}
+
+static int test_channelizers(void)
+{
+    int failed = 0;
+
+    printf(" Channelizer                | Result\n");
+    printf("----------------------------+-------\n");
+
+    failed += test_channelizer("K 16, M 64, critical", 16, 64,
+        FFTS_CHANNELIZER_CRITICAL);
+    failed += test_channelizer("K 16, M 50, critical", 16, 50,
+        FFTS_CHANNELIZER_CRITICAL);
+    failed += test_channelizer("K 16, M 64, oversampled", 16, 64,
+        FFTS_CHANNELIZER_OVERSAMPLED);
+    failed += test_channelizer("K 16, M 50, oversampled", 16, 50,
+        FFTS_CHANNELIZER_OVERSAMPLED);
+    failed += test_channelizer("K 8, M 13, oversampled", 8, 13,
+        FFTS_CHANNELIZER_OVERSAMPLED);
+
+    /* as ffts_channelize, a NULL plan is ignored */
+    ffts_channelizer_reset(NULL);
+
+    printf("\n");
+    return failed;
+}
+
+#define SDFT_N 64
+#define SDFT_T 3000
+
+/* feeds SDFT_T samples to a sliding DFT plan in uneven chunks and, after
+   every chunk, compares the bins against the direct DFT of the last
+   SDFT_N samples, the oldest at time zero */
+static int test_sdft(const char *name, const size_t *bins, size_t count,
+                     size_t anchor)
+{
+    static const size_t steps[] = { 1, 7, 40, 3, 64, 13, 100, 29 };
+    const size_t n = bins ? count : SDFT_N;
+    float *x = test_malloc(2 * SDFT_T * sizeof(float));
+    float *y = test_malloc(2 * n * sizeof(float));
+    ffts_plan_t *p;
+    double err = 0.0, norm = 0.0;
+    size_t t = 0, c = 0, i, m;
+
+    random_fill(x, 2 * SDFT_T);
+
+    p = ffts_init_sdft(SDFT_N, 1, bins, count, anchor);
+    if (!p) {
+        printf(" %-26s | plan unsupported\n", name);
+        test_free(x);
+        test_free(y);
+        return 1;
+    }
+
+    while (t < SDFT_T) {
+        size_t step = steps[c++ % (sizeof(steps) / sizeof(steps[0]))];
+
+        if (step > SDFT_T - t) {
+            step = SDFT_T - t;
+        }
+
+        ffts_sdft(p, x + 2 * t, step, y);
+        t += step;
+
+        for (i = 0; i < n; i++) {
+            const size_t k = bins ? bins[i] : i;
+            double re = 0.0, im = 0.0;
+
+            /* samples before the first ones are zeros */
+            for (m = 0; m < SDFT_N; m++) {
+                double a = -2.0 * M_PI * (double) ((k * m) % SDFT_N) / SDFT_N;
+                double xr, xi;
+
+                if (t + m < SDFT_N) {
+                    continue;
+                }
+
+                xr = x[2 * (t + m - SDFT_N) + 0];
+                xi = x[2 * (t + m - SDFT_N) + 1];
+                re += xr * cos(a) - xi * sin(a);
+                im += xr * sin(a) + xi * cos(a);
+            }
+
+            err += (y[2 * i] - re) * (y[2 * i] - re) +
+                (y[2 * i + 1] - im) * (y[2 * i + 1] - im);
+            norm += re * re + im * im;
+        }
+    }
+
+    err = sqrt(err / norm);
+    printf(" %-26s | %s (%.2e)\n", name, err < 1e-5 ? "ok" : "FAILED", err);
+
+    ffts_free(p);
+    test_free(x);
+    test_free(y);
+    return err >= 1e-5;
+}
+
+static int test_sdfts(void)
+{
+    static const size_t bins[] = { 0, 1, 5, 17, 31, 32, 40, 63, 9, 22, 50 };
+    int failed = 0;
+
+    printf(" Sliding DFT, N %d          | Result\n", SDFT_N);
+    printf("----------------------------+-------\n");
+
+    failed += test_sdft("11 bins", bins, 11, 0);
+    failed += test_sdft("all bins", NULL, 0, 0);
+    failed += test_sdft("11 bins, anchor 100", bins, 11, 100);
+    failed += test_sdft("all bins, anchor 100", NULL, 0, 100);
+
+    /* as ffts_sdft, a NULL plan is ignored */
+    ffts_sdft_reset(NULL);
+
+    printf("\n");
+    return failed;
+}
+
 int main(int argc, char *argv[])
 {
+    int failed = 0;
+
     if (argc == 3) {
         ffts_plan_t *p;
         int i;
@@ -186,7 +1034,16 @@ int main(int argc, char *argv[])
         for (n = 1, power2 = 2; n <= 18; n++, power2 <<= 1) {
             test_transform(power2, 1);
         }
+
+        printf("\n");
+        failed += test_shared_plans();
+        failed += test_convs();
+        failed += test_spectra();
+        failed += test_ints();
+        failed += test_halves();
+        failed += test_channelizers();
+        failed += test_sdfts();
     }
 
-    return 0;
+    return failed ? 1 : 0;
 }
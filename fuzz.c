@@ -0,0 +1,500 @@
+#include "libbench2/bench.h"
+#include "libbench2/my-getopt.h"
+
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Property/fuzz harness for the FFTS plans.
+
+   Every fuzz input is decoded into a problem: rank, power-of-two sizes,
+   sign, real/complex, in/out-of-place and the byte offsets of the input
+   and output arrays.  The problem is planned through bench.c, checked
+   with the libbench2 verifier and timed, and problems whose cost per
+   N lg N jumps by more than a factor over comparable problems are
+   reported as performance cliffs.
+
+   Built with -DBENCHFFTS_LIBFUZZER this file provides the libFuzzer
+   entry point, and a failure ends the run as a crash.  Otherwise it is
+   a standalone driver feeding random inputs, which records failures
+   and goes on with the next problem.
+*/
+
+#define FUZZ_MAX_RANK 3
+#define FUZZ_MAX_LOG_SIZE 30
+#define FUZZ_TIME_MIN 1.0e-3
+#define FUZZ_TIME_REPEAT 3
+
+/* ffts needs 128 bit aligned arrays, so offsets move the arrays by
+   multiples of 16 bytes within and across cache lines and pages */
+#define FUZZ_OFFSET_UNIT 16
+#define FUZZ_MAX_OFFSETS 256
+
+typedef struct {
+    char desc[64];
+    int kind;
+    int rank;
+    int in_place;
+    int log_size;
+    size_t ioff;
+    size_t ooff;
+} fuzz_case;
+
+typedef struct {
+    char desc[64];
+    int cls;
+    int log_size;
+    int failed;
+    double cost; /* best ns per N lg N, or < 0 if not timed */
+} fuzz_record;
+
+static int fuzz_max_rank = FUZZ_MAX_RANK;
+static int fuzz_max_log_size = 16;
+static int fuzz_rounds = 4;
+static double fuzz_tol;
+static double fuzz_cliff = 2.0;
+
+static const fuzz_case *fuzz_current;
+static int fuzz_keep_going;
+static jmp_buf fuzz_failure;
+static int fuzz_nchecked;
+static int fuzz_nfailed;
+
+static fuzz_record *fuzz_records;
+static int fuzz_nrecords;
+static int fuzz_maxrecords;
+
+static void
+fuzz_decode(const uint8_t *data, size_t size, fuzz_case *c)
+{
+    size_t pos = 0;
+    int flags, i, n, lg, left;
+    char *s = c->desc;
+
+#define NEXT_BYTE() (pos < size ? data[pos++] : 0)
+
+    flags = NEXT_BYTE();
+    c->kind = (flags & 1) ? PROBLEM_REAL : PROBLEM_COMPLEX;
+    c->in_place = (flags >> 2) & 1;
+    c->rank = 1 + ((flags >> 3) % fuzz_max_rank);
+    c->ioff = FUZZ_OFFSET_UNIT * (NEXT_BYTE() % FUZZ_MAX_OFFSETS);
+    c->ooff = c->in_place ? c->ioff :
+        FUZZ_OFFSET_UNIT * (NEXT_BYTE() % FUZZ_MAX_OFFSETS);
+
+    *s++ = c->in_place ? 'i' : 'o';
+    *s++ = c->kind == PROBLEM_REAL ? 'r' : 'c';
+    *s++ = (flags & 2) ? 'b' : 'f';
+
+    /* complex dimensions are at least 2, the last dimension of a real
+       transform at least 4; the total size is kept under the limit */
+    c->log_size = 0;
+    left = fuzz_max_log_size;
+    for (i = 0; i < c->rank; ++i) {
+        int min_lg = (c->kind == PROBLEM_REAL && i == c->rank - 1) ? 2 : 1;
+        int max_lg = left - (c->rank - 1 - i);
+
+        if (max_lg < min_lg) {
+            max_lg = min_lg;
+        }
+
+        lg = min_lg + NEXT_BYTE() % (max_lg - min_lg + 1);
+        left -= lg;
+        c->log_size += lg;
+
+        n = sprintf(s, "%s%d", i ? "x" : "", 1 << lg);
+        s += n;
+    }
+
+#undef NEXT_BYTE
+}
+
+/* byte sizes of the input and output elements of p */
+static void
+element_sizes(const bench_problem *p, size_t *isz, size_t *osz)
+{
+    *isz = *osz = sizeof(bench_complex);
+
+    if (p->kind == PROBLEM_REAL) {
+        if (p->sign < 0) {
+            *isz = sizeof(bench_real);
+        } else {
+            *osz = sizeof(bench_real);
+        }
+    }
+}
+
+/* Replace the arrays allocated by problem_alloc() with copies placed
+   at the offsets of c.  The original pointers are kept in orig so that
+   problem_destroy() frees what it allocated. */
+static void
+offset_arrays(bench_problem *p, const fuzz_case *c, void **orig, void **buf)
+{
+    size_t isz, osz;
+
+    orig[0] = p->in;
+    orig[1] = p->out;
+    orig[2] = p->inphys;
+    orig[3] = p->outphys;
+
+    element_sizes(p, &isz, &osz);
+
+    buf[0] = bench_malloc(p->iphyssz * isz + c->ioff);
+    p->inphys = p->in = (char*) buf[0] + c->ioff;
+
+    if (p->in_place) {
+        buf[1] = NULL;
+        p->outphys = p->out = p->in;
+    } else {
+        buf[1] = bench_malloc(p->ophyssz * osz + c->ooff);
+        p->outphys = p->out = (char*) buf[1] + c->ooff;
+    }
+}
+
+static void
+restore_arrays(bench_problem *p, void **orig, void **buf)
+{
+    p->in = orig[0];
+    p->out = orig[1];
+    p->inphys = orig[2];
+    p->outphys = orig[3];
+
+    bench_free(buf[0]);
+    if (buf[1]) {
+        bench_free(buf[1]);
+    }
+}
+
+/* best seconds per transform */
+static double
+time_problem(bench_problem *p)
+{
+    double t, best;
+    int iter, r;
+
+    for (iter = 1; ; iter *= 2) {
+        timer_start(LIBBENCH_TIMER);
+        doit(iter, p);
+        t = timer_stop(LIBBENCH_TIMER);
+
+        if (t >= FUZZ_TIME_MIN || iter >= (1 << 20)) {
+            break;
+        }
+    }
+
+    best = t / iter;
+    for (r = 1; r < FUZZ_TIME_REPEAT; ++r) {
+        timer_start(LIBBENCH_TIMER);
+        doit(iter, p);
+        t = timer_stop(LIBBENCH_TIMER) / iter;
+
+        if (t < best) {
+            best = t;
+        }
+    }
+
+    return best;
+}
+
+/* offsets and repeated inputs map to the record of the same problem */
+static fuzz_record*
+lookup_record(const fuzz_case *c)
+{
+    fuzz_record *r;
+    int i;
+
+    for (i = 0; i < fuzz_nrecords; ++i) {
+        if (!strcmp(fuzz_records[i].desc, c->desc)) {
+            return fuzz_records + i;
+        }
+    }
+
+    if (fuzz_nrecords == fuzz_maxrecords) {
+        fuzz_maxrecords = fuzz_maxrecords ? 2 * fuzz_maxrecords : 64;
+        fuzz_records = (fuzz_record*) realloc(fuzz_records,
+            fuzz_maxrecords * sizeof(*fuzz_records));
+        BENCH_ASSERT(fuzz_records);
+    }
+
+    r = fuzz_records + fuzz_nrecords++;
+    strcpy(r->desc, c->desc);
+    r->cls = (c->kind == PROBLEM_REAL) * 2 * FUZZ_MAX_RANK +
+        (c->rank - 1) * 2 + c->in_place;
+    r->log_size = c->log_size;
+    r->failed = 0;
+    r->cost = -1.0;
+    return r;
+}
+
+static void
+record_cost(fuzz_record *r, double t)
+{
+    double cost = 1.0e9 * t / ((double) (1 << r->log_size) * r->log_size);
+
+    if (r->cost < 0.0 || cost < r->cost) {
+        r->cost = cost;
+    }
+}
+
+/* A problem is a cliff when its cost per N lg N exceeds fuzz_cliff times
+   the cost of a problem of the same class with the same size or half
+   its size.  Smaller problems are never cheaper per N lg N for a healthy
+   plan, so per-call overhead does not trigger false reports. */
+static int
+report_cliffs(void)
+{
+    int i, j, ncliffs = 0;
+
+    for (i = 0; i < fuzz_nrecords; ++i) {
+        const fuzz_record *a = fuzz_records + i;
+        const fuzz_record *ref = NULL;
+
+        if (a->cost < 0.0) {
+            continue;
+        }
+
+        for (j = 0; j < fuzz_nrecords; ++j) {
+            const fuzz_record *b = fuzz_records + j;
+
+            if (j == i || b->cls != a->cls || b->cost < 0.0) {
+                continue;
+            }
+
+            if (b->log_size != a->log_size && b->log_size != a->log_size - 1) {
+                continue;
+            }
+
+            if (!ref || b->cost < ref->cost) {
+                ref = b;
+            }
+        }
+
+        if (ref && a->cost > fuzz_cliff * ref->cost) {
+            ovtpvt("fuzz: performance cliff at %s: %.3g ns per N lg N, "
+                   "%.2fx %s\n", a->desc, a->cost, a->cost / ref->cost,
+                   ref->desc);
+            ncliffs++;
+        }
+    }
+
+    return ncliffs;
+}
+
+static void
+report_failure(void)
+{
+    if (fuzz_current) {
+        ovtpvt_err("fuzz: failed on %s (input offset %u, output offset %u)\n",
+                   fuzz_current->desc, (unsigned) fuzz_current->ioff,
+                   (unsigned) fuzz_current->ooff);
+    }
+}
+
+/* Overrides the libbench2 default.  The verifier and BENCH_ASSERT end
+   up here on failure; the standalone driver then resumes fuzz_one(),
+   leaking whatever the verifier had allocated. */
+void
+bench_exit(int status)
+{
+    if (fuzz_keep_going && fuzz_current) {
+        report_failure();
+        fuzz_current = NULL;
+        longjmp(fuzz_failure, 1);
+    }
+
+    exit(status);
+}
+
+static void
+fuzz_init(void)
+{
+    static int initialized = 0;
+
+    if (!initialized) {
+        fuzz_tol = SINGLE_PRECISION ? 1.0e-3 :
+            (QUAD_PRECISION ? 1e-29 : 1.0e-10);
+        timer_init(0.0, 1);
+        atexit(report_failure);
+        initialized = 1;
+    }
+}
+
+static void
+fuzz_one(const uint8_t *data, size_t size)
+{
+    bench_problem *p;
+    fuzz_record *volatile r; /* used after longjmp */
+    fuzz_case c;
+    void *orig[4], *buf[2];
+
+    fuzz_decode(data, size, &c);
+
+    p = problem_parse(c.desc);
+    if (!can_do(p)) {
+        problem_destroy(p);
+        return;
+    }
+
+    /* a failing problem is reported once, whatever its offsets */
+    r = lookup_record(&c);
+    if (r->failed) {
+        problem_destroy(p);
+        return;
+    }
+
+    if (verbose) {
+        ovtpvt("fuzz: %s (input offset %u, output offset %u)\n", c.desc,
+               (unsigned) c.ioff, (unsigned) c.ooff);
+    }
+
+    fuzz_nchecked++;
+    fuzz_current = &c;
+
+    problem_alloc(p);
+    offset_arrays(p, &c, orig, buf);
+    problem_zero(p);
+
+    if (setjmp(fuzz_failure)) {
+        r->failed = 1;
+        fuzz_nfailed++;
+    } else {
+        setup(p);
+        verify_problem(p, fuzz_rounds, fuzz_tol);
+
+        problem_zero(p);
+        record_cost(r, time_problem(p));
+    }
+
+    done(p);
+    restore_arrays(p, orig, buf);
+    problem_destroy(p);
+
+    fuzz_current = NULL;
+}
+
+#ifdef BENCHFFTS_LIBFUZZER
+
+static void
+report_cliffs_at_exit(void)
+{
+    if (!fuzz_current) {
+        report_cliffs();
+    }
+}
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static int initialized = 0;
+
+    if (!initialized) {
+        fuzz_init();
+        atexit(report_cliffs_at_exit);
+        initialized = 1;
+    }
+
+    fuzz_one(data, size);
+    return 0;
+}
+
+#else
+
+/* name the problem that crashed, then crash as usual */
+static void
+crash_handler(int sig)
+{
+    report_failure();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static struct my_option options[] = {
+    {"iterations", REQARG, 'n'},
+    {"random-seed", REQARG, 401},
+    {"max-rank", REQARG, 402},
+    {"max-size", REQARG, 403},
+    {"verify-rounds", REQARG, 404},
+    {"verify-tolerance", REQARG, 405},
+    {"cliff", REQARG, 406},
+    {"verbose", OPTARG, 'v'},
+    {"help", NOARG, 'h'},
+    {0, NOARG, 0}
+};
+
+int
+main(int argc, char *argv[])
+{
+    uint8_t data[3 + FUZZ_MAX_RANK];
+    int iterations = 1000;
+    int seed = 1;
+    int i, j, c, ncliffs;
+
+    fuzz_init();
+    fuzz_keep_going = 1;
+    signal(SIGSEGV, crash_handler);
+    signal(SIGILL, crash_handler);
+    signal(SIGFPE, crash_handler);
+
+    while ((c = my_getopt(argc, argv, options)) != -1) {
+        switch (c) {
+        case 'n':
+            iterations = atoi(my_optarg);
+            break;
+        case 401:
+            seed = atoi(my_optarg);
+            break;
+        case 402:
+            fuzz_max_rank = atoi(my_optarg);
+            if (fuzz_max_rank < 1 || fuzz_max_rank > FUZZ_MAX_RANK) {
+                fuzz_max_rank = FUZZ_MAX_RANK;
+            }
+            break;
+        case 403:
+            for (j = atoi(my_optarg), fuzz_max_log_size = 0; j > 1; j >>= 1) {
+                fuzz_max_log_size++;
+            }
+            if (fuzz_max_log_size < 2) {
+                fuzz_max_log_size = 2;
+            } else if (fuzz_max_log_size > FUZZ_MAX_LOG_SIZE) {
+                fuzz_max_log_size = FUZZ_MAX_LOG_SIZE;
+            }
+            break;
+        case 404:
+            fuzz_rounds = atoi(my_optarg);
+            break;
+        case 405:
+            fuzz_tol = strtod(my_optarg, 0);
+            break;
+        case 406:
+            fuzz_cliff = strtod(my_optarg, 0);
+            break;
+        case 'v':
+            verbose = my_optarg ? atoi(my_optarg) : 1;
+            break;
+        case 'h':
+        default:
+            my_usage(argv[0], options);
+            return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    bench_srand(seed);
+
+    for (i = 0; i < iterations; ++i) {
+        for (j = 0; j < (int) sizeof(data); ++j) {
+            data[j] = (uint8_t) (256.0 * bench_drand());
+        }
+
+        fuzz_one(data, sizeof(data));
+    }
+
+    ncliffs = report_cliffs();
+    ovtpvt("fuzz: %d problems checked, %d failed, %d performance cliffs\n",
+           fuzz_nchecked, fuzz_nfailed, ncliffs);
+
+    return fuzz_nfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
@@ -11,6 +11,19 @@ static void bounds(bench_problem *p, int *ilb, int *iub, int *olb, int *oub)
      tensor_destroy(t);
 }
 
+static void *array_malloc(bench_problem *p, size_t n)
+{
+     return p->file_backed ? bench_file_malloc(n) : bench_malloc(n);
+}
+
+static void array_free(bench_problem *p, void *ptr)
+{
+     if (p->file_backed)
+	  bench_file_free(ptr);
+     else
+	  bench_free(ptr);
+}
+
 /*
  * Allocate I/O arrays for a problem.
  *
@@ -30,7 +43,7 @@ void problem_alloc(bench_problem *p)
 	  bench_complex *in, *out;
 
 	  p->iphyssz = isz;
-	  p->inphys = in = (bench_complex *) bench_malloc(isz * sizeof(bench_complex));
+	  p->inphys = in = (bench_complex *) array_malloc(p, isz * sizeof(bench_complex));
 	  p->in = in - ilb;
 	  
 	  if (p->in_place) {
@@ -39,14 +52,14 @@ void problem_alloc(bench_problem *p)
 	       p->ophyssz = p->iphyssz;
 	  } else {
 	       p->ophyssz = osz;
-	       p->outphys = out = (bench_complex *) bench_malloc(osz * sizeof(bench_complex));
+	       p->outphys = out = (bench_complex *) array_malloc(p, osz * sizeof(bench_complex));
 	       p->out = out - olb;
 	  }
      } else if (p->kind == PROBLEM_R2R) {
 	  bench_real *in, *out;
 
 	  p->iphyssz = isz;
-	  p->inphys = in = (bench_real *) bench_malloc(isz * sizeof(bench_real));
+	  p->inphys = in = (bench_real *) array_malloc(p, isz * sizeof(bench_real));
 	  p->in = in - ilb;
 	  
 	  if (p->in_place) {
@@ -55,7 +68,7 @@ void problem_alloc(bench_problem *p)
 	       p->ophyssz = p->iphyssz;
 	  } else {
 	       p->ophyssz = osz;
-	       p->outphys = out = (bench_real *) bench_malloc(osz * sizeof(bench_real));
+	       p->outphys = out = (bench_real *) array_malloc(p, osz * sizeof(bench_real));
 	       p->out = out - olb;
 	  }
      } else if (p->kind == PROBLEM_REAL && p->sign < 0) { /* R2HC */
@@ -64,7 +77,7 @@ void problem_alloc(bench_problem *p)
 
 	  isz = isz > osz*2 ? isz : osz*2;
 	  p->iphyssz = isz;
-	  p->inphys = in = (bench_real *) bench_malloc(p->iphyssz * sizeof(bench_real));
+	  p->inphys = in = (bench_real *) array_malloc(p, p->iphyssz * sizeof(bench_real));
 	  p->in = in - ilb;
 	  
 	  if (p->in_place) {
@@ -73,7 +86,7 @@ void problem_alloc(bench_problem *p)
 	       p->ophyssz = p->iphyssz / 2;
 	  } else {
 	       p->ophyssz = osz;
-	       p->outphys = out = (bench_complex *) bench_malloc(osz * sizeof(bench_complex));
+	       p->outphys = out = (bench_complex *) array_malloc(p, osz * sizeof(bench_complex));
 	       p->out = out - olb;
 	  }
      } else if (p->kind == PROBLEM_REAL && p->sign > 0) { /* HC2R */
@@ -82,7 +95,7 @@ void problem_alloc(bench_problem *p)
 
 	  osz = osz > isz*2 ? osz : isz*2;
 	  p->ophyssz = osz;
-	  p->outphys = out = (bench_real *) bench_malloc(p->ophyssz * sizeof(bench_real));
+	  p->outphys = out = (bench_real *) array_malloc(p, p->ophyssz * sizeof(bench_real));
 	  p->out = out - olb;
 	  
 	  if (p->in_place) {
@@ -91,7 +104,7 @@ void problem_alloc(bench_problem *p)
 	       p->iphyssz = p->ophyssz / 2;
 	  } else {
 	       p->iphyssz = isz;
-	       p->inphys = in = (bench_complex *) bench_malloc(isz * sizeof(bench_complex));
+	       p->inphys = in = (bench_complex *) array_malloc(p, isz * sizeof(bench_complex));
 	       p->in = in - ilb;
 	  }
      } else {
@@ -102,9 +115,9 @@ void problem_alloc(bench_problem *p)
 void problem_free(bench_problem *p)
 {
      if (p->outphys && p->outphys != p->inphys)
-	  bench_free(p->outphys);
+	  array_free(p, p->outphys);
      if (p->inphys)
-	  bench_free(p->inphys);
+	  array_free(p, p->inphys);
      tensor_destroy(p->sz);
      tensor_destroy(p->vecsz);
 }
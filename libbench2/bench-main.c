@@ -29,21 +29,30 @@ int verbose;
 static const struct my_option options[] =
 {
   {"accuracy", REQARG, 'a'},
+  {"accuracy-reference", REQARG, 414},
   {"accuracy-rounds", REQARG, 405},
   {"impulse-accuracy-rounds", REQARG, 406},
+  {"cache-mode", REQARG, 410},
+  {"cache-size", REQARG, 411},
   {"can-do", REQARG, 'd'},
+  {"compare-baseline", REQARG, 408},
   {"help", NOARG, 'h'},
   {"info", REQARG, 'i'},
   {"info-all", NOARG, 'I'},
+  {"numa", NOARG, 415},
+  {"pin-threads", NOARG, 413},
   {"print-precision", NOARG, 402},
   {"print-time-min", NOARG, 400},
   {"random-seed", REQARG, 404},
+  {"regression-threshold", REQARG, 409},
   {"report-benchmark", NOARG, 320},
   {"report-mflops", NOARG, 300},
   {"report-time", NOARG, 310},
   {"report-verbose", NOARG, 330},
+  {"save-baseline", REQARG, 407},
   {"speed", REQARG, 's'},
   {"setup-speed", REQARG, 'S'},
+  {"threads", REQARG, 412},
   {"time-min", REQARG, 't'},
   {"time-repeat", REQARG, 'r'},
   {"user-option", REQARG, 'o'},
@@ -62,7 +71,8 @@ int bench_main(int argc, char *argv[])
      int rounds = 10;
      int iarounds = 0;
      int arounds = 1; /* this is too low for precise results */
-     int c;
+     int c, status;
+     int measured = 0; /* a problem was already timed */
 
      report = report_verbose; /* default */
      verbose = 0;
@@ -82,10 +92,17 @@ int bench_main(int argc, char *argv[])
 		   repeat = atoi(my_optarg);
 		   break;
 	      case 's':
+		   measured = 1;
 		   timer_init(tmin, repeat);
-		   speed(my_optarg, 0);
+		   if (bench_numa)
+			speed_numa(my_optarg);
+		   else if (bench_nthreads > 1)
+			speed_threads(my_optarg, bench_nthreads);
+		   else
+			speed(my_optarg, 0);
 		   break;
 	      case 'S':
+		   measured = 1;
 		   timer_init(tmin, repeat);
 		   speed(my_optarg, 1);
 		   break;
@@ -104,7 +121,9 @@ int bench_main(int argc, char *argv[])
 		   }
 		   break;
 	      case 'y':
-		   verify(my_optarg, rounds, tol);
+		   /* seeded per job even on one thread, so that the
+		      errors do not depend on --threads */
+		   verify_threads(my_optarg, rounds, tol, bench_nthreads);
 		   break;
 	      case 'a':
 		   accuracy(my_optarg, arounds, iarounds);
@@ -172,7 +191,61 @@ int bench_main(int argc, char *argv[])
 	      case 406: /* --impulse-accuracy-rounds */
 		   iarounds = atoi(my_optarg);
 		   break;
-		   
+
+	      case 407: /* --save-baseline */
+	      case 408: /* --compare-baseline */
+		   /* only problems timed after the option are recorded */
+		   if (measured) {
+			ovtpvt_err("bench: --%s-baseline must come before "
+				   "the problems to time\n",
+				   c == 407 ? "save" : "compare");
+			cleanup();
+			return 1;
+		   }
+		   if (c == 407)
+			save_baseline_file = my_optarg;
+		   else
+			compare_baseline_file = my_optarg;
+		   break;
+
+	      case 409: /* --regression-threshold, in percent */
+		   regression_threshold = strtod(my_optarg, 0) / 100.0;
+		   break;
+
+	      case 410: /* --cache-mode */
+		   cache_mode = parse_cache_mode(my_optarg);
+		   break;
+
+	      case 411: /* --cache-size, in bytes with optional k/M suffix */
+	      {
+		   char *end;
+		   double sz = strtod(my_optarg, &end);
+		   if (*end == 'k' || *end == 'K')
+			sz *= 1024.0;
+		   else if (*end == 'm' || *end == 'M')
+			sz *= 1024.0 * 1024.0;
+		   cache_size = (size_t) sz;
+		   break;
+	      }
+
+	      case 412: /* --threads */
+		   bench_nthreads = atoi(my_optarg);
+		   if (bench_nthreads < 1)
+			bench_nthreads = 1;
+		   break;
+
+	      case 413: /* --pin-threads */
+		   bench_pin_threads = 1;
+		   break;
+
+	      case 414: /* --accuracy-reference */
+		   accuracy_reference = parse_accuracy_reference(my_optarg);
+		   break;
+
+	      case 415: /* --numa */
+		   bench_numa = 1;
+		   break;
+
 	      case '?':
 		   /* my_getopt() already printed an error message. */
 		   cleanup();
@@ -187,9 +260,16 @@ int bench_main(int argc, char *argv[])
         benchmarked */
      while (my_optind < argc) {
 	  timer_init(tmin, repeat);
-	  speed(argv[my_optind++], 0);
+	  if (bench_numa)
+	       speed_numa(argv[my_optind++]);
+	  else if (bench_nthreads > 1)
+	       speed_threads(argv[my_optind++], bench_nthreads);
+	  else
+	       speed(argv[my_optind++], 0);
      }
 
+     status = compare_done();
+     cache_flush_done();
      cleanup();
-     return 0;
+     return status;
 }
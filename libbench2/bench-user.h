@@ -117,6 +117,7 @@ typedef struct {
      int in_place;
      int destroy_input;
      int split;
+     int file_backed; /* arrays in a temporary file mapped in memory */
      void *in, *out;
      void *inphys, *outphys;
      int iphyssz, ophyssz;
@@ -129,6 +130,19 @@ typedef struct {
 
      /* another internal hack to avoid passing around too many parameters */
      double setup_time;
+
+     /* optional breakdown of setup_time, filled in by setup() */
+#define BENCH_MAX_SETUP_STAGES 8
+     int nsetup_stages;
+     const char *setup_stage_name[BENCH_MAX_SETUP_STAGES];
+     double setup_stage_time[BENCH_MAX_SETUP_STAGES];
+
+     /* bytes held by the plan, 0 if unknown; filled in by setup() */
+     double plan_memory;
+
+     /* input samples taken by every call of a streaming plan, 0 for
+	whole transforms; filled in by setup() */
+     double stream_samples;
 } bench_problem;
 
 extern int verbose;
@@ -137,6 +151,9 @@ extern int no_speed_allocation;
 
 extern int always_pad_real;
 
+/* NUMA node on which setup() should place the plan, -1 for any */
+extern int bench_plan_node;
+
 #define LIBBENCH_TIMER 0
 #define USER_TIMER 1
 #define BENCH_NTIMERS 2
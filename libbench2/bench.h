@@ -26,6 +26,7 @@ extern double time_min;
 extern int time_repeat;
 
 extern void timer_init(double tmin, int repeat);
+extern double bench_time(void);
 
 /* report functions */
 extern void (*report)(const bench_problem *p, double *t, int st);
@@ -43,12 +44,55 @@ extern int aligned_main(int argc, char *argv[]);
 extern int bench_main(int argc, char *argv[]);
 
 extern void speed(const char *param, int setup_only);
+
+/* cache state in which speed() measures a problem */
+enum { CACHE_WARM, CACHE_ROTATE, CACHE_FLUSH, CACHE_ALL };
+extern int cache_mode;
+extern int speed_cache_mode;
+extern int speed_setup_only;
+extern size_t cache_size;
+extern const char *cache_mode_name(int mode);
+extern int parse_cache_mode(const char *s);
+extern size_t last_level_cache_size(void);
+
+/* threads */
+typedef void (*bench_thread_fn)(int tid, void *arg);
+struct bench_barrier;
+extern int bench_nthreads;
+extern int bench_pin_threads;
+extern int bench_threads_supported(void);
+extern void bench_run_threads(int n, bench_thread_fn f, void *arg);
+extern void bench_pin_thread(int tid);
+extern int bench_pin_cpu(int cpu);
+extern void bench_lock(void);
+extern void bench_unlock(void);
+extern struct bench_barrier *bench_barrier_create(int n);
+extern void bench_barrier_wait(struct bench_barrier *b);
+extern void bench_barrier_destroy(struct bench_barrier *b);
+extern void speed_threads(const char *param, int nthreads);
+extern void verify_threads(const char *param, int rounds, double tol,
+			   int nthreads);
+extern int bench_numa;
+extern void speed_numa(const char *param);
+
+struct cache_pool;
+extern struct cache_pool *cache_pool_create(bench_problem *p);
+extern void cache_pool_next(struct cache_pool *pool, bench_problem *p);
+extern void cache_pool_restore(struct cache_pool *pool, bench_problem *p);
+extern void cache_pool_destroy(struct cache_pool *pool);
+extern void cache_flush(const bench_problem *p);
+extern void cache_flush_done(void);
+
+/* arrays of file-backed ('m') problems */
+extern void *bench_file_malloc(size_t n);
+extern void bench_file_free(void *ptr);
 extern void accuracy(const char *param, int rounds, int impulse_rounds);
 
 extern double mflops(const bench_problem *p, double t);
 
 extern double bench_drand(void);
 extern void bench_srand(int seed);
+extern int bench_random_seed;
 
 extern bench_problem *problem_parse(const char *desc);
 
@@ -59,5 +103,19 @@ extern void fftaccuracy(int n, bench_complex *a, bench_complex *ffta,
 			int sign, double err[6]);
 extern void fftaccuracy_done(void);
 
+/* arithmetic of the exact FFT against which accuracy() measures errors */
+enum { ACCURACY_MP, ACCURACY_DD };
+extern int accuracy_reference;
+extern int parse_accuracy_reference(const char *s);
+extern void fftaccuracy_dd(int n, bench_complex *a, bench_complex *ffta,
+			   int sign, double err[6]);
+extern void fftaccuracy_dd_done(void);
+
+extern const char *save_baseline_file;
+extern const char *compare_baseline_file;
+extern double regression_threshold;
+extern void compare_record(const bench_problem *p, const double *t, int st);
+extern int compare_done(void);
+
 extern void caset(bench_complex *A, int n, bench_complex x);
 extern void aset(bench_real *A, int n, bench_real x);
@@ -0,0 +1,236 @@
+/* cache-resident and cold-cache timing support for speed() */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_CLFLUSH 1
+#endif
+
+#define CACHE_LINE 64
+
+int cache_mode = CACHE_WARM;
+size_t cache_size = 0; /* 0 means guess */
+
+static const char *const cache_mode_names[] = {
+     "warm", "rotate", "flush", "all"
+};
+
+const char *cache_mode_name(int mode)
+{
+     BENCH_ASSERT(mode >= 0 && mode <= CACHE_ALL);
+     return cache_mode_names[mode];
+}
+
+int parse_cache_mode(const char *s)
+{
+     int mode;
+
+     for (mode = 0; mode <= CACHE_ALL; ++mode)
+	  if (!strcmp(s, cache_mode_names[mode]))
+	       return mode;
+
+     ovtpvt_err("bench: unknown cache mode %s\n", s);
+     bench_exit(EXIT_FAILURE);
+     return CACHE_WARM;
+}
+
+/* size of the last-level cache, or a generous guess */
+size_t last_level_cache_size(void)
+{
+     if (cache_size)
+	  return cache_size;
+
+#if defined(HAVE_UNISTD_H) && defined(_SC_LEVEL3_CACHE_SIZE)
+     {
+	  long sz = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	  if (sz <= 0)
+	       sz = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	  if (sz > 0)
+	       return (size_t) sz;
+     }
+#endif
+
+     return 32 * 1024 * 1024;
+}
+
+static void phys_sizes(const bench_problem *p, size_t *isz, size_t *osz)
+{
+     size_t ie, oe;
+
+     switch (p->kind) {
+	 case PROBLEM_COMPLEX:
+	      ie = oe = sizeof(bench_complex);
+	      break;
+	 case PROBLEM_R2R:
+	      ie = oe = sizeof(bench_real);
+	      break;
+	 case PROBLEM_REAL:
+	 default:
+	      if (p->sign < 0) {
+		   ie = sizeof(bench_real);
+		   oe = sizeof(bench_complex);
+	      } else {
+		   ie = sizeof(bench_complex);
+		   oe = sizeof(bench_real);
+	      }
+	      break;
+     }
+
+     *isz = p->iphyssz * ie;
+     *osz = p->in_place ? 0 : p->ophyssz * oe;
+}
+
+/*
+ * A pool of distinct input/output buffers whose total size exceeds
+ * the last-level cache, so that every iteration of doit() in rotate
+ * mode starts with data that has been evicted by its predecessors.
+ */
+struct cache_pool {
+     int n, cur;
+     char *mem;
+     size_t isz, stride;   /* bytes of one input array, of one set */
+     int in_place;
+     ptrdiff_t ioff, ooff; /* offset of p->in/p->out within the phys arrays */
+     void *in0, *out0;     /* original buffers of the problem */
+};
+
+/* keep every array of the pool aligned like bench_malloc() does */
+#define POOL_ALIGN 128
+#define POOL_ROUND(x) (((x) + POOL_ALIGN - 1) & ~((size_t) POOL_ALIGN - 1))
+
+struct cache_pool *cache_pool_create(bench_problem *p)
+{
+     struct cache_pool *pool;
+     size_t isz, osz, llc = last_level_cache_size();
+
+     phys_sizes(p, &isz, &osz);
+
+     pool = (struct cache_pool *) bench_malloc(sizeof(struct cache_pool));
+     pool->isz = POOL_ROUND(isz);
+     pool->stride = pool->isz + POOL_ROUND(osz);
+     pool->n = (int) ((2 * llc) / pool->stride + 1);
+     if (pool->n < 2)
+	  pool->n = 2;
+     pool->cur = 0;
+     pool->in_place = !osz;
+     pool->ioff = (char *) p->in - (char *) p->inphys;
+     pool->ooff = (char *) p->out - (char *) p->outphys;
+     pool->in0 = p->in;
+     pool->out0 = p->out;
+
+     pool->mem = (char *) bench_malloc(pool->n * pool->stride);
+     memset(pool->mem, 0, pool->n * pool->stride);
+
+     if (verbose > 1)
+	  ovtpvt("cache: rotating through %d buffer sets of %lu bytes\n",
+		 pool->n, (unsigned long) (isz + osz));
+
+     return pool;
+}
+
+/* point the problem at the next buffer set of the pool */
+void cache_pool_next(struct cache_pool *pool, bench_problem *p)
+{
+     char *in = pool->mem + pool->cur * pool->stride;
+     char *out = pool->in_place ? in : in + pool->isz;
+
+     p->in = in + pool->ioff;
+     p->out = out + pool->ooff;
+     if (++pool->cur == pool->n)
+	  pool->cur = 0;
+}
+
+void cache_pool_restore(struct cache_pool *pool, bench_problem *p)
+{
+     p->in = pool->in0;
+     p->out = pool->out0;
+}
+
+void cache_pool_destroy(struct cache_pool *pool)
+{
+     if (!pool)
+	  return;
+
+     bench_free(pool->mem);
+     bench_free(pool);
+}
+
+/*
+ * Evict the problem arrays from all cache levels.  Where the hardware
+ * offers a cache-line flush we use it; otherwise we stream through a
+ * buffer twice the size of the last-level cache.
+ */
+#if defined(HAVE_CLFLUSH) || (defined(__GNUC__) && defined(__aarch64__))
+static void flush_range(const void *ptr, size_t sz)
+{
+     const char *p = (const char *) ptr;
+     const char *end = p + sz;
+
+     for (p -= (size_t) p % CACHE_LINE; p < end; p += CACHE_LINE) {
+#ifdef HAVE_CLFLUSH
+	  _mm_clflush(p);
+#else
+	  __asm__ __volatile__("dc civac, %0" : : "r" (p) : "memory");
+#endif
+     }
+}
+
+void cache_flush(const bench_problem *p)
+{
+     size_t isz, osz;
+
+     phys_sizes(p, &isz, &osz);
+     flush_range(p->inphys, isz);
+     if (osz)
+	  flush_range(p->outphys, osz);
+
+#ifdef HAVE_CLFLUSH
+     _mm_mfence();
+#else
+     __asm__ __volatile__("dsb sy" : : : "memory");
+#endif
+}
+
+void cache_flush_done(void)
+{
+}
+#else
+static char *evict_buf = 0;
+static size_t evict_sz = 0;
+volatile unsigned char cache_flush_sink;
+
+void cache_flush(const bench_problem *p)
+{
+     unsigned char x = 0;
+     size_t i;
+
+     UNUSED(p);
+
+     if (!evict_buf) {
+	  evict_sz = 2 * last_level_cache_size();
+	  evict_buf = (char *) bench_malloc(evict_sz);
+	  memset(evict_buf, 0, evict_sz);
+     }
+
+     for (i = 0; i < evict_sz; i += CACHE_LINE) {
+	  x ^= (unsigned char) evict_buf[i];
+	  evict_buf[i] = (char) x;
+     }
+     cache_flush_sink = x;
+}
+
+void cache_flush_done(void)
+{
+     bench_free0(evict_buf);
+     evict_buf = 0;
+}
+#endif
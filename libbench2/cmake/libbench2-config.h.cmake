@@ -18,6 +18,9 @@
 /* Define to compile in single precision. */
 #cmakedefine BENCHFFT_SINGLE 1
 
+/* Define to 1 if you have the `clock_gettime' function. */
+#cmakedefine HAVE_CLOCK_GETTIME 1
+
 /* Define to 1 if you have the `cosl' function. */
 #cmakedefine HAVE_COSL 1
 
@@ -60,6 +63,15 @@
 /* Define to 1 if you have the declaration of `posix_memalign'. */
 #cmakedefine HAVE_POSIX_MEMALIGN 1
 
+/* Define to 1 if you have POSIX threads. */
+#cmakedefine HAVE_PTHREAD 1
+
+/* Define to 1 if you have the `pthread_setaffinity_np' function. */
+#cmakedefine HAVE_PTHREAD_SETAFFINITY_NP 1
+
+/* Define to 1 if you have the `sched_getaffinity' function. */
+#cmakedefine HAVE_SCHED_GETAFFINITY 1
+
 /* Define to 1 if you have the `snprintf' function. */
 #cmakedefine HAVE_SNPRINTF 1
 
@@ -75,6 +87,9 @@
 /* Define to 1 if you have the <string.h> header file. */
 #cmakedefine HAVE_STRING_H 1
 
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#cmakedefine HAVE_SYS_MMAN_H 1
+
 /* Define to 1 if you have the <sys/time.h> header file. */
 #cmakedefine HAVE_SYS_TIME_H 1
 
@@ -0,0 +1,402 @@
+/* save raw timing samples and compare them against a stored baseline */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+const char *save_baseline_file = 0;
+const char *compare_baseline_file = 0;
+double regression_threshold = 0.05; /* tolerated slowdown, as a fraction */
+
+/* two-sided significance level for the Mann-Whitney U test */
+#define REGRESSION_ALPHA 0.05
+
+struct result {
+     char *pstring;
+     double *t;
+     int st;
+};
+
+struct result_set {
+     struct result *r;
+     int n, nalloc;
+};
+
+static struct result_set current = { 0, 0, 0 };
+
+static void add_result(struct result_set *s, const char *pstring,
+		       const double *t, int st)
+{
+     struct result *r;
+
+     if (s->n == s->nalloc) {
+	  struct result *nr;
+	  int nalloc = s->nalloc ? 2 * s->nalloc : 16;
+
+	  nr = (struct result *) bench_malloc(nalloc * sizeof(struct result));
+	  if (s->n)
+	       memcpy(nr, s->r, s->n * sizeof(struct result));
+	  bench_free0(s->r);
+	  s->r = nr;
+	  s->nalloc = nalloc;
+     }
+
+     r = s->r + s->n++;
+     r->pstring = (char *) bench_malloc(strlen(pstring) + 1);
+     strcpy(r->pstring, pstring);
+     r->st = st;
+     r->t = (double *) bench_malloc((st > 0 ? st : 1) * sizeof(double));
+     if (st > 0)
+	  memcpy(r->t, t, st * sizeof(double));
+}
+
+static void destroy_results(struct result_set *s)
+{
+     int i;
+
+     for (i = 0; i < s->n; ++i) {
+	  bench_free(s->r[i].pstring);
+	  bench_free(s->r[i].t);
+     }
+     bench_free0(s->r);
+     s->r = 0;
+     s->n = s->nalloc = 0;
+}
+
+static const struct result *find_result(const struct result_set *s,
+					const char *pstring)
+{
+     int i;
+
+     for (i = 0; i < s->n; ++i)
+	  if (!strcmp(s->r[i].pstring, pstring))
+	       return s->r + i;
+     return 0;
+}
+
+/* called by speed() with the per-iteration times of one problem */
+void compare_record(const bench_problem *p, const double *t, int st)
+{
+     char name[1024];
+
+     if (!save_baseline_file && !compare_baseline_file)
+	  return;
+
+     /* setup and cold-cache measurements are kept apart from the
+	warm ones */
+     if (speed_setup_only) {
+	  sprintf(name, "%.1000s:setup", p->pstring);
+	  add_result(&current, name, t, st);
+     } else if (speed_cache_mode != CACHE_WARM) {
+	  sprintf(name, "%.1000s:%s", p->pstring,
+		  cache_mode_name(speed_cache_mode));
+	  add_result(&current, name, t, st);
+     } else {
+	  add_result(&current, p->pstring, t, st);
+     }
+}
+
+/**************************************************************
+ * JSON output
+ **************************************************************/
+static void write_string(FILE *f, const char *s)
+{
+     putc('"', f);
+     for (; *s; ++s) {
+	  if (*s == '"' || *s == '\\')
+	       putc('\\', f);
+	  putc(*s, f);
+     }
+     putc('"', f);
+}
+
+static int save_results(const char *fname, const struct result_set *s)
+{
+     FILE *f;
+     int i, k;
+
+     f = fopen(fname, "w");
+     if (!f) {
+	  ovtpvt_err("bench: cannot write baseline %s\n", fname);
+	  return 0;
+     }
+
+     fprintf(f, "{\n  \"precision\": \"%s\",\n  \"results\": [",
+	     SINGLE_PRECISION ? "single" :
+	     (QUAD_PRECISION ? "quad" :
+	      (LDOUBLE_PRECISION ? "long-double" : "double")));
+
+     for (i = 0; i < s->n; ++i) {
+	  const struct result *r = s->r + i;
+
+	  fprintf(f, "%s\n    {\"problem\": ", i ? "," : "");
+	  write_string(f, r->pstring);
+	  fprintf(f, ", \"samples\": [");
+	  for (k = 0; k < r->st; ++k)
+	       fprintf(f, "%s%.17g", k ? ", " : "", r->t[k]);
+	  fprintf(f, "]}");
+     }
+
+     fprintf(f, "\n  ]\n}\n");
+     fclose(f);
+     return 1;
+}
+
+/**************************************************************
+ * JSON input.  This is not a general JSON parser; it only looks
+ * for the "problem" and "samples" members written by save_results().
+ **************************************************************/
+static char *read_file(const char *fname)
+{
+     FILE *f;
+     char *buf;
+     long len;
+
+     f = fopen(fname, "rb");
+     if (!f)
+	  return 0;
+
+     fseek(f, 0, SEEK_END);
+     len = ftell(f);
+     fseek(f, 0, SEEK_SET);
+
+     buf = (char *) bench_malloc(len + 1);
+     len = (long) fread(buf, 1, len, f);
+     buf[len] = 0;
+     fclose(f);
+     return buf;
+}
+
+static const char *skip_ws(const char *s)
+{
+     while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r')
+	  ++s;
+     return s;
+}
+
+/* parse `"key": ' starting at the key; return pointer to the value */
+static const char *find_member(const char *s, const char *key)
+{
+     size_t len = strlen(key);
+
+     while ((s = strchr(s, '"'))) {
+	  if (!strncmp(s + 1, key, len) && s[len + 1] == '"') {
+	       s = skip_ws(s + len + 2);
+	       if (*s == ':')
+		    return skip_ws(s + 1);
+	  }
+	  ++s;
+     }
+     return 0;
+}
+
+static const char *parse_string(const char *s, char *buf, int buflen)
+{
+     int i = 0;
+
+     if (*s++ != '"')
+	  return 0;
+     while (*s && *s != '"') {
+	  if (*s == '\\' && s[1])
+	       ++s;
+	  if (i < buflen - 1)
+	       buf[i++] = *s;
+	  ++s;
+     }
+     buf[i] = 0;
+     return *s ? s + 1 : 0;
+}
+
+static int load_results(const char *fname, struct result_set *s)
+{
+     char *buf;
+     const char *q;
+     char pstring[1024];
+     double *t = 0;
+     int tn = 0, st;
+
+     buf = read_file(fname);
+     if (!buf) {
+	  ovtpvt_err("bench: cannot read baseline %s\n", fname);
+	  return 0;
+     }
+
+     for (q = buf; (q = find_member(q, "problem")); ) {
+	  if (!(q = parse_string(q, pstring, sizeof(pstring))))
+	       break;
+	  if (!(q = find_member(q, "samples")) || *q != '[')
+	       break;
+
+	  st = 0;
+	  for (q = skip_ws(q + 1); *q && *q != ']'; q = skip_ws(q)) {
+	       char *end;
+	       double x = strtod(q, &end);
+
+	       if (end == q)
+		    break;
+	       if (st == tn) {
+		    double *nt;
+		    tn = tn ? 2 * tn : 64;
+		    nt = (double *) bench_malloc(tn * sizeof(double));
+		    if (st)
+			 memcpy(nt, t, st * sizeof(double));
+		    bench_free0(t);
+		    t = nt;
+	       }
+	       t[st++] = x;
+	       q = skip_ws(end);
+	       if (*q == ',')
+		    ++q;
+	  }
+
+	  if (st > 0)
+	       add_result(s, pstring, t, st);
+     }
+
+     bench_free0(t);
+     bench_free(buf);
+     return 1;
+}
+
+/**************************************************************
+ * statistics
+ **************************************************************/
+static int cmp_double(const void *a, const void *b)
+{
+     double x = *(const double *) a, y = *(const double *) b;
+     return (x > y) - (x < y);
+}
+
+static double median(const double *t, int st)
+{
+     double *u, m;
+
+     u = (double *) bench_malloc(st * sizeof(double));
+     memcpy(u, t, st * sizeof(double));
+     qsort(u, st, sizeof(double), cmp_double);
+     m = (st & 1) ? u[st / 2] : 0.5 * (u[st / 2 - 1] + u[st / 2]);
+     bench_free(u);
+     return m;
+}
+
+struct sample {
+     double t;
+     int which;
+};
+
+static int cmp_sample(const void *a, const void *b)
+{
+     return cmp_double(&((const struct sample *) a)->t,
+		       &((const struct sample *) b)->t);
+}
+
+/* Two-sided p-value of the Mann-Whitney U test, using the normal
+   approximation with tie correction. */
+static double mann_whitney(const double *a, int na, const double *b, int nb)
+{
+     struct sample *s;
+     int n = na + nb, i, j;
+     double ra = 0.0, ties = 0.0, u, mu, sigma, z;
+
+     s = (struct sample *) bench_malloc(n * sizeof(struct sample));
+     for (i = 0; i < na; ++i) {
+	  s[i].t = a[i];
+	  s[i].which = 0;
+     }
+     for (i = 0; i < nb; ++i) {
+	  s[na + i].t = b[i];
+	  s[na + i].which = 1;
+     }
+     qsort(s, n, sizeof(struct sample), cmp_sample);
+
+     for (i = 0; i < n; i = j) {
+	  double rank, cnt;
+
+	  for (j = i + 1; j < n && s[j].t == s[i].t; ++j)
+	       ;
+	  cnt = j - i;
+	  rank = 0.5 * (i + 1 + j); /* average of ranks i+1 .. j */
+	  ties += cnt * cnt * cnt - cnt;
+	  for (; i < j; ++i)
+	       if (s[i].which == 0)
+		    ra += rank;
+     }
+     bench_free(s);
+
+     u = ra - 0.5 * na * (na + 1.0);
+     mu = 0.5 * na * nb;
+     sigma = sqrt(na * (double) nb / 12.0 *
+		  ((n + 1.0) - ties / (n * (n - 1.0))));
+     if (sigma <= 0.0)
+	  return 1.0;
+
+     z = (fabs(u - mu) - 0.5) / sigma; /* continuity correction */
+     if (z < 0.0)
+	  z = 0.0;
+     return erfc(z / sqrt(2.0));
+}
+
+static int compare_results(const struct result_set *base,
+			   const struct result_set *cur)
+{
+     int i, nregress = 0;
+
+     for (i = 0; i < cur->n; ++i) {
+	  const struct result *c = cur->r + i;
+	  const struct result *b = find_result(base, c->pstring);
+	  double mb, mc, pval, speedup;
+	  int regress;
+
+	  if (!b) {
+	       ovtpvt("Compare: %s, no baseline\n", c->pstring);
+	       continue;
+	  }
+
+	  mb = median(b->t, b->st);
+	  mc = median(c->t, c->st);
+	  if (mb <= 0.0 || mc <= 0.0)
+	       continue;
+
+	  speedup = mb / mc;
+	  pval = mann_whitney(b->t, b->st, c->t, c->st);
+	  regress = (mc > mb * (1.0 + regression_threshold)) &&
+	       pval < REGRESSION_ALPHA;
+	  nregress += regress;
+
+	  ovtpvt("Compare: %s, baseline: %.5g, current: %.5g, "
+		 "speedup: %.3f, p: %.3g%s\n",
+		 c->pstring, mb, mc, speedup, pval,
+		 regress ? ", REGRESSION" : "");
+     }
+
+     if (nregress)
+	  ovtpvt_err("bench: %d problem(s) slower than baseline by more "
+		     "than %g%%\n", nregress, 100.0 * regression_threshold);
+
+     return nregress;
+}
+
+/* called once at exit; returns the program exit status */
+int compare_done(void)
+{
+     int status = 0;
+
+     if (save_baseline_file)
+	  if (!save_results(save_baseline_file, &current))
+	       status = EXIT_FAILURE;
+
+     if (compare_baseline_file) {
+	  struct result_set base = { 0, 0, 0 };
+
+	  if (!load_results(compare_baseline_file, &base))
+	       status = EXIT_FAILURE;
+	  else if (compare_results(&base, &current))
+	       status = 2;
+	  destroy_results(&base);
+     }
+
+     destroy_results(&current);
+     return status;
+}
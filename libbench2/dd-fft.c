@@ -0,0 +1,481 @@
+/* double-double reference FFT for accuracy(), much faster than mp.c */
+
+#include "bench.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+int accuracy_reference = ACCURACY_MP;
+
+int parse_accuracy_reference(const char *s)
+{
+     if (!strcmp(s, "mp"))
+	  return ACCURACY_MP;
+     if (!strcmp(s, "dd")) {
+	  /* 106 bits are not enough to check 113-bit quad precision */
+	  if (QUAD_PRECISION) {
+	       ovtpvt_err("bench: the dd accuracy reference is not precise "
+			  "enough for quad precision\n");
+	       bench_exit(EXIT_FAILURE);
+	  }
+	  return ACCURACY_DD;
+     }
+
+     ovtpvt_err("bench: unknown accuracy reference %s\n", s);
+     bench_exit(EXIT_FAILURE);
+     return ACCURACY_MP;
+}
+
+/* An unevaluated sum hi + lo with |lo| <= ulp(hi)/2, giving about 106
+   bits of mantissa.  The algorithms are the usual ones of Dekker and
+   Knuth; they need IEEE double arithmetic without extended precision
+   or contraction of a*b+c, so do not compile this file with -ffast-math. */
+typedef struct {
+     double hi, lo;
+} dd;
+
+static dd fromd(double x)
+{
+     dd r;
+     r.hi = x;
+     r.lo = 0.0;
+     return r;
+}
+
+static dd quick_two_sum(double a, double b)
+{
+     dd r;
+     r.hi = a + b;
+     r.lo = b - (r.hi - a);
+     return r;
+}
+
+static dd two_sum(double a, double b)
+{
+     dd r;
+     double bb;
+     r.hi = a + b;
+     bb = r.hi - a;
+     r.lo = (a - (r.hi - bb)) + (b - bb);
+     return r;
+}
+
+static void split(double a, double *hi, double *lo)
+{
+     double t = 134217729.0 * a; /* 2^27 + 1 */
+     *hi = t - (t - a);
+     *lo = a - *hi;
+}
+
+static dd two_prod(double a, double b)
+{
+     dd r;
+     double ah, al, bh, bl;
+     r.hi = a * b;
+     split(a, &ah, &al);
+     split(b, &bh, &bl);
+     r.lo = ((ah * bh - r.hi) + ah * bl + al * bh) + al * bl;
+     return r;
+}
+
+static dd add(dd a, dd b)
+{
+     dd s, t;
+     s = two_sum(a.hi, b.hi);
+     t = two_sum(a.lo, b.lo);
+     s.lo += t.hi;
+     s = quick_two_sum(s.hi, s.lo);
+     s.lo += t.lo;
+     return quick_two_sum(s.hi, s.lo);
+}
+
+static dd neg(dd a)
+{
+     a.hi = -a.hi;
+     a.lo = -a.lo;
+     return a;
+}
+
+static dd sub(dd a, dd b)
+{
+     return add(a, neg(b));
+}
+
+static dd mul(dd a, dd b)
+{
+     dd p = two_prod(a.hi, b.hi);
+     p.lo += a.hi * b.lo + a.lo * b.hi;
+     return quick_two_sum(p.hi, p.lo);
+}
+
+static dd mul_d(dd a, double b)
+{
+     dd p = two_prod(a.hi, b);
+     p.lo += a.lo * b;
+     return quick_two_sum(p.hi, p.lo);
+}
+
+static dd div_d(dd a, double b)
+{
+     double q1, q2;
+     dd r;
+
+     q1 = a.hi / b;
+     r = sub(a, two_prod(q1, b));
+     q2 = r.hi / b;
+     r = sub(r, two_prod(q2, b));
+     return add(quick_two_sum(q1, q2), fromd(r.hi / b));
+}
+
+static dd fromreal(bench_real x)
+{
+     dd r;
+     r.hi = (double) x;
+     r.lo = (double) (x - (bench_real) r.hi);
+     return r;
+}
+
+/**************************************************************
+ * trigonometry
+ **************************************************************/
+static const dd pi_4 = { 7.853981633974482790e-01, 3.061616997868383018e-17 };
+
+/* sin(x) and cos(x) for 0 <= x <= pi/4, by Taylor series */
+static void sincos_dd(dd x, dd *s, dd *c)
+{
+     dd x2 = mul(x, x), term, sum;
+     int k;
+
+     sum = term = x;
+     for (k = 2; fabs(term.hi) > 1.0e-34; k += 2) {
+	  term = neg(div_d(mul(term, x2), (double) k * (k + 1)));
+	  sum = add(sum, term);
+     }
+     *s = sum;
+
+     sum = term = fromd(1.0);
+     for (k = 1; fabs(term.hi) > 1.0e-34; k += 2) {
+	  term = neg(div_d(mul(term, x2), (double) k * (k + 1)));
+	  sum = add(sum, term);
+     }
+     *c = sum;
+}
+
+/* cos and sin of 2*pi*m/n, reduced to the first octant exactly */
+static void cexp_dd(int m, int n, dd *c, dd *s)
+{
+     double r8;
+     int octant;
+     dd x, sx, cx;
+
+     m %= n;
+     if (m < 0)
+	  m += n;
+
+     /* 2*pi*m/n = octant*pi/4 + pi/4 * r8/n, 0 <= r8 < n */
+     octant = (int) ((8.0 * m) / n);
+     r8 = 8.0 * m - (double) octant * n;
+     if (octant & 1)
+	  r8 = n - r8; /* measure from the end of the octant */
+     x = div_d(mul_d(pi_4, r8), (double) n);
+     sincos_dd(x, &sx, &cx);
+
+     switch (octant) {
+	 case 0: *c = cx; *s = sx; break;
+	 case 1: *c = sx; *s = cx; break;
+	 case 2: *c = neg(sx); *s = cx; break;
+	 case 3: *c = neg(cx); *s = sx; break;
+	 case 4: *c = neg(cx); *s = neg(sx); break;
+	 case 5: *c = neg(sx); *s = neg(cx); break;
+	 case 6: *c = sx; *s = neg(cx); break;
+	 default: *c = cx; *s = neg(sx); break;
+     }
+}
+
+/**************************************************************
+ * FFT, with the same structure as the one in mp.c
+ **************************************************************/
+static void cmul(dd r0, dd i0, dd r1, dd i1, dd *r2, dd *i2)
+{
+     *r2 = sub(mul(r0, r1), mul(i0, i1));
+     *i2 = add(mul(r0, i1), mul(i0, r1));
+}
+
+static void cmulj(dd r0, dd i0, dd r1, dd i1, dd *r2, dd *i2)
+{
+     *r2 = add(mul(r0, r1), mul(i0, i1));
+     *i2 = sub(mul(r0, i1), mul(i0, r1));
+}
+
+/* Twiddles of every pass of fft0, stored contiguously so that a pass
+   reads them in order: for the pass of butterflies of span i,
+   w[2*(i-1+j)] + i*w[2*(i-1+j)+1] = exp(pi*i*j/i), 0 <= j < i */
+static dd *cached_w = 0;
+static int cached_w_n = -1;
+
+static const dd *twiddles(int n)
+{
+     int i, j;
+
+     if (cached_w_n != n) {
+	  dd *last;
+
+	  if (cached_w) bench_free(cached_w);
+	  cached_w = (dd *) bench_malloc((n > 1 ? 2 * n : 2) * sizeof(dd));
+	  cached_w_n = n;
+
+	  /* the last pass needs exp(2*pi*i*j/n), 0 <= j < n/2, of which
+	     only the first octant is summed; the other passes take every
+	     (n/2)/i-th of them */
+	  last = cached_w + 2 * (n / 2 - 1);
+	  if (n % 8) {
+	       for (j = 0; j < n / 2; ++j)
+		    cexp_dd(j, n, last + 2 * j, last + 2 * j + 1);
+	  } else {
+	       for (j = 0; j <= n / 8; ++j) {
+		    dd c, s;
+		    cexp_dd(j, n, &c, &s);
+		    last[2 * j] = c;
+		    last[2 * j + 1] = s;
+		    last[2 * (n / 4 - j)] = s;
+		    last[2 * (n / 4 - j) + 1] = c;
+		    last[2 * (n / 4 + j)] = neg(s);
+		    last[2 * (n / 4 + j) + 1] = c;
+		    if (j > 0) {
+			 last[2 * (n / 2 - j)] = neg(c);
+			 last[2 * (n / 2 - j) + 1] = s;
+		    }
+	       }
+	  }
+	  for (i = 1; i < n / 2; i = 2 * i) {
+	       for (j = 0; j < i; ++j) {
+		    cached_w[2 * (i - 1 + j)] = last[2 * j * (n / (2 * i))];
+		    cached_w[2 * (i - 1 + j) + 1] =
+			 last[2 * j * (n / (2 * i)) + 1];
+	       }
+	  }
+     }
+     return cached_w;
+}
+
+static void bitrev(int n, dd *a)
+{
+     int i, j, m;
+     for (i = j = 0; i < n - 1; ++i) {
+	  if (i < j) {
+	       dd t;
+	       t = a[2*i]; a[2*i] = a[2*j]; a[2*j] = t;
+	       t = a[2*i+1]; a[2*i+1] = a[2*j+1]; a[2*j+1] = t;
+	  }
+
+	  /* bit reversed counter */
+	  m = n; do { m >>= 1; j ^= m; } while (!(j & m));
+     }
+}
+
+static void fft0(int n, dd *a, int sign)
+{
+     const dd *w = twiddles(n);
+     int i, j, k;
+
+     bitrev(n, a);
+
+     /* blocks outside, butterflies inside, so that a pass sweeps a
+	and its twiddles once instead of once per twiddle */
+     for (i = 1; i < n; i = 2 * i) {
+	  const dd *wi = w + 2 * (i - 1);
+	  for (k = 0; k < n; k += 2 * i) {
+	       for (j = 0; j < i; ++j) {
+		    dd *a0 = a + 2 * (k + j);
+		    dd *a1 = a0 + 2 * i;
+		    dd xr, xi;
+		    if (j == 0) {
+			 xr = a1[0];  xi = a1[1]; /* w = 1 */
+		    } else if (sign < 0)
+			 cmulj(wi[2 * j], wi[2 * j + 1], a1[0], a1[1],
+			       &xr, &xi);
+		    else
+			 cmul(a1[0], a1[1], wi[2 * j], wi[2 * j + 1],
+			      &xr, &xi);
+		    a1[0] = sub(a0[0], xr);  a1[1] = sub(a0[1], xi);
+		    a0[0] = add(a0[0], xr);  a0[1] = add(a0[1], xi);
+	       }
+	  }
+     }
+}
+
+/* a[2*k]+i*a[2*k+1] = exp(2*pi*i*k^2/(2*n)) */
+static void bluestein_sequence(int n, dd *a)
+{
+     int k, ksq, n2 = 2 * n;
+
+     ksq = 1; /* (-1)^2 */
+     for (k = 0; k < n; ++k) {
+	  /* careful with overflow */
+	  ksq = ksq + 2*k - 1; while (ksq > n2) ksq -= n2;
+	  cexp_dd(ksq, n2, a + 2*k, a + 2*k + 1);
+     }
+}
+
+static int pow2_atleast(int x)
+{
+     int h;
+     for (h = 1; h < x; h = 2 * h)
+	  ;
+     return h;
+}
+
+static dd *cached_bluestein_w = 0;
+static dd *cached_bluestein_y = 0;
+static int cached_bluestein_n = -1;
+
+static void bluestein(int n, dd *a)
+{
+     int nb = pow2_atleast(2 * n);
+     dd *b = (dd *) bench_malloc(2 * nb * sizeof(dd));
+     dd *w = cached_bluestein_w;
+     dd *y = cached_bluestein_y;
+     double nbinv = 1.0 / nb; /* exact because nb = 2^k */
+     int i;
+
+     if (cached_bluestein_n != n) {
+	  if (w) bench_free(w);
+	  if (y) bench_free(y);
+	  w = (dd *) bench_malloc(2 * n * sizeof(dd));
+	  y = (dd *) bench_malloc(2 * nb * sizeof(dd));
+	  cached_bluestein_n = n;
+	  cached_bluestein_w = w;
+	  cached_bluestein_y = y;
+
+	  bluestein_sequence(n, w);
+	  for (i = 0; i < 2*nb; ++i)  y[i] = fromd(0.0);
+
+	  for (i = 0; i < n; ++i) {
+	       y[2*i] = w[2*i];
+	       y[2*i+1] = w[2*i+1];
+	  }
+	  for (i = 1; i < n; ++i) {
+	       y[2*(nb-i)] = w[2*i];
+	       y[2*(nb-i)+1] = w[2*i+1];
+	  }
+
+	  fft0(nb, y, -1);
+     }
+
+     for (i = 0; i < 2*nb; ++i)  b[i] = fromd(0.0);
+
+     for (i = 0; i < n; ++i)
+	  cmulj(w[2*i], w[2*i+1], a[2*i], a[2*i+1], b + 2*i, b + 2*i+1);
+
+     /* scaled convolution b * y */
+     fft0(nb, b, -1);
+
+     for (i = 0; i < nb; ++i)
+	  cmul(b[2*i], b[2*i+1], y[2*i], y[2*i+1], b + 2*i, b + 2*i+1);
+     fft0(nb, b, 1);
+
+     for (i = 0; i < n; ++i) {
+	  cmulj(w[2*i], w[2*i+1], b[2*i], b[2*i+1], a + 2*i, a + 2*i+1);
+	  a[2*i] = mul_d(a[2*i], nbinv);
+	  a[2*i+1] = mul_d(a[2*i+1], nbinv);
+     }
+
+     bench_free(b);
+}
+
+static void swapri(int n, dd *a)
+{
+     int i;
+     for (i = 0; i < n; ++i) {
+	  dd t = a[2 * i];
+	  a[2 * i] = a[2 * i + 1];
+	  a[2 * i + 1] = t;
+     }
+}
+
+static void fft1(int n, dd *a, int sign)
+{
+     if (power_of_two(n)) {
+	  fft0(n, a, sign);
+     } else {
+	  if (sign == 1) swapri(n, a);
+	  bluestein(n, a);
+	  if (sign == 1) swapri(n, a);
+     }
+}
+
+static void fromrealv(int n, bench_complex *a, dd *b)
+{
+     int i;
+
+     for (i = 0; i < n; ++i) {
+	  b[2 * i] = fromreal(c_re(a[i]));
+	  b[2 * i + 1] = fromreal(c_im(a[i]));
+     }
+}
+
+static void compare(int n, dd *a, dd *b, double *err)
+{
+     int i;
+     double e1, e2, einf;
+     double n1, n2, ninf;
+
+     e1 = e2 = einf = 0.0;
+     n1 = n2 = ninf = 0.0;
+
+#    define DO(x1, x2, xinf, var) { 			\
+     double d = var;					\
+     if (d < 0) d = -d;					\
+     x1 += d; x2 += d * d; if (d > xinf) xinf = d;	\
+}
+
+     for (i = 0; i < 2 * n; ++i) {
+	  dd diff = sub(a[i], b[i]);
+	  DO(n1, n2, ninf, a[i].hi);
+	  DO(e1, e2, einf, diff.hi);
+     }
+
+#    undef DO
+     err[0] = e1 / n1;
+     err[1] = sqrt(e2 / n2);
+     err[2] = einf / ninf;
+}
+
+void fftaccuracy_dd(int n, bench_complex *a, bench_complex *ffta,
+		    int sign, double err[6])
+{
+     dd *b = (dd *) bench_malloc(2 * n * sizeof(dd));
+     dd *fftb = (dd *) bench_malloc(2 * n * sizeof(dd));
+     int i;
+
+     /* forward error */
+     fromrealv(n, a, b); fromrealv(n, ffta, fftb);
+     fft1(n, b, sign);
+     compare(n, b, fftb, err);
+
+     /* backward error */
+     fromrealv(n, a, b); fromrealv(n, ffta, fftb);
+     if (power_of_two(n)) {
+	  double ninv = 1.0 / n; /* exact */
+	  for (i = 0; i < 2 * n; ++i) fftb[i] = mul_d(fftb[i], ninv);
+     } else {
+	  for (i = 0; i < 2 * n; ++i) fftb[i] = div_d(fftb[i], (double) n);
+     }
+     fft1(n, fftb, -sign);
+     compare(n, b, fftb, err + 3);
+
+     bench_free(fftb);
+     bench_free(b);
+}
+
+void fftaccuracy_dd_done(void)
+{
+     if (cached_w) bench_free(cached_w);
+     if (cached_bluestein_w) bench_free(cached_bluestein_w);
+     if (cached_bluestein_y) bench_free(cached_bluestein_y);
+     cached_w = 0;
+     cached_w_n = -1;
+     cached_bluestein_w = 0;
+     cached_bluestein_y = 0;
+     cached_bluestein_n = -1;
+}
@@ -0,0 +1,84 @@
+/* problem arrays in temporary files mapped in memory */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H)
+#include <sys/mman.h>
+#include <unistd.h>
+#define HAVE_FILE_MAPPING 1
+#endif
+
+#ifdef HAVE_FILE_MAPPING
+/* the length of the mapping is kept in a page in front of the array */
+static size_t page_size(void)
+{
+     long sz = sysconf(_SC_PAGESIZE);
+     return sz > 0 ? (size_t) sz : 4096;
+}
+
+void *bench_file_malloc(size_t n)
+{
+     const char *dir = getenv("TMPDIR");
+     size_t page = page_size(), length;
+     char *path, *addr;
+     int fd;
+
+     if (!dir || !*dir)
+	  dir = "/tmp";
+
+     path = (char *) bench_malloc(strlen(dir) + sizeof("/bench-XXXXXX"));
+     strcpy(path, dir);
+     strcat(path, "/bench-XXXXXX");
+
+     fd = mkstemp(path);
+     if (fd < 0) {
+	  ovtpvt_err("cannot create a file in %s\n", dir);
+	  BENCH_ASSERT(0);
+     }
+
+     /* the file disappears with its last mapping */
+     unlink(path);
+     bench_free(path);
+
+     length = page + (n + page - 1) / page * page;
+     if (ftruncate(fd, (off_t) length)) {
+	  ovtpvt_err("cannot extend a file in %s to %lu bytes\n", dir,
+		     (unsigned long) length);
+	  BENCH_ASSERT(0);
+     }
+
+     addr = (char *) mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+			  fd, 0);
+     close(fd);
+     BENCH_ASSERT(addr != (char *) MAP_FAILED);
+
+     *(size_t *) addr = length;
+     return addr + page;
+}
+
+void bench_file_free(void *ptr)
+{
+     char *addr = (char *) ptr - page_size();
+     munmap(addr, *(size_t *) addr);
+}
+#else
+void *bench_file_malloc(size_t n)
+{
+     static int warned = 0;
+
+     if (!warned) {
+	  ovtpvt_err("file-backed arrays are not supported here; "
+		     "using memory\n");
+	  warned = 1;
+     }
+     return bench_malloc(n);
+}
+
+void bench_file_free(void *ptr)
+{
+     bench_free(ptr);
+}
+#endif
@@ -609,11 +609,17 @@ static void compare(int n, N *a, N *b, double *err)
 void fftaccuracy(int n, bench_complex *a, bench_complex *ffta,
 		 int sign, double err[6])
 {
-     N *b = (N *)bench_malloc(2 * n * sizeof(N));
-     N *fftb = (N *)bench_malloc(2 * n * sizeof(N));
+     N *b, *fftb;
      N mn, ninv;
      int i;
 
+     if (accuracy_reference == ACCURACY_DD) {
+	  fftaccuracy_dd(n, a, ffta, sign, err);
+	  return;
+     }
+
+     b = (N *)bench_malloc(2 * n * sizeof(N));
+     fftb = (N *)bench_malloc(2 * n * sizeof(N));
      fromreal(n, mn); inv(mn, ninv);
 
      /* forward error */
@@ -638,4 +644,5 @@ void fftaccuracy_done(void)
      cached_bluestein_w = 0;
      cached_bluestein_y = 0;
      cached_bluestein_n = -1;
+     fftaccuracy_dd_done();
 }
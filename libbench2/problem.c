@@ -245,10 +245,15 @@ bench_problem *problem_parse(const char *s)
      p->in_place = 0;
      p->destroy_input = 0;
      p->split = 0;
+     p->file_backed = 0;
      p->userinfo = 0;
      p->scrambled_in = p->scrambled_out = 0;
      p->sz = p->vecsz = 0;
      p->ini = p->outi = 0;
+     p->setup_time = 0.0;
+     p->nsetup_stages = 0;
+     p->plan_memory = 0.0;
+     p->stream_samples = 0.0;
      p->pstring = (char *) bench_malloc(sizeof(char) * (strlen(s) + 1));
      strcpy(p->pstring, s);
 
@@ -258,6 +263,7 @@ bench_problem *problem_parse(const char *s)
 	 case 'o': p->in_place = 0; ++s; goto L1;
 	 case 'd': p->destroy_input = 1; ++s; goto L1;
 	 case '/': p->split = 1; ++s; goto L1;
+	 case 'm': p->file_backed = 1; ++s; goto L1;
 	 case 'f': 
 	 case '-': p->sign = -1; ++s; goto L1;
 	 case 'b': 
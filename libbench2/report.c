@@ -87,7 +87,8 @@ void report_benchmark(const bench_problem *p, double *t, int st)
 {
      struct stats s;
      mkstat(t, st, &s);
-     ovtpvt("%.5g %.8g %g\n", mflops(p, s.min), s.min, p->setup_time);
+     ovtpvt("%.5g %.8g %g %.0f\n", mflops(p, s.min), s.min, p->setup_time,
+	    p->plan_memory);
 }
 
 static void sprintf_time(double x, char *buf, int buflen)
@@ -108,14 +109,65 @@ static void sprintf_time(double x, char *buf, int buflen)
 #undef MY_SPRINTF
 }
 
+/* ", memory: <size>" if the plan reported its footprint, else "" */
+static void sprintf_memory(double x, char *buf)
+{
+     if (x <= 0.0)
+	  buf[0] = 0;
+     else if (x < 1024.0)
+	  sprintf(buf, ", memory: %.0f B", x);
+     else if (x < 1024.0 * 1024.0)
+	  sprintf(buf, ", memory: %.2f kB", x / 1024.0);
+     else
+	  sprintf(buf, ", memory: %.2f MB", x / (1024.0 * 1024.0));
+}
+
+/* ", samples/s: <rate>" of streaming plans, else "" */
+static void sprintf_stream(const bench_problem *p, double t, char *buf)
+{
+     if (p->stream_samples <= 0.0 || t <= 0.0)
+	  buf[0] = 0;
+     else
+	  sprintf(buf, ", samples/s: %.4g", p->stream_samples / t);
+}
+
+static void report_setup_stages(const bench_problem *p)
+{
+     char buf[64];
+     int i;
+
+     ovtpvt("Setup stages:");
+     for (i = 0; i < p->nsetup_stages; ++i) {
+	  sprintf_time(p->setup_stage_time[i], buf, 64);
+	  ovtpvt("%s %s %s", i ? "," : "", p->setup_stage_name[i], buf);
+     }
+     ovtpvt("\n");
+}
+
 void report_verbose(const bench_problem *p, double *t, int st)
 {
      struct stats s;
      char bmin[64], bmax[64], bavg[64], bmedian[64], btmin[64];
-     char bsetup[64];
+     char bsetup[64], bmem[64], bstream[64];
      int copyp = tensor_sz(p->sz) == 1;
 
      mkstat(t, st, &s);
+     sprintf_memory(p->plan_memory, bmem);
+     sprintf_stream(p, s.min, bstream);
+
+     if (speed_setup_only) {
+	  sprintf_time(p->setup_time, bsetup, 64);
+	  sprintf_time(s.max, bmax, 64);
+	  sprintf_time(s.avg, bavg, 64);
+	  sprintf_time(s.median, bmedian, 64);
+	  ovtpvt("Problem: %s, setup: %s%s\n", p->pstring, bsetup, bmem);
+	  if (p->nsetup_stages)
+	       report_setup_stages(p);
+	  if (verbose)
+	       ovtpvt("Setup: %d plans, min %s, max %s, avg %s, median %s\n",
+		      st, bsetup, bmax, bavg, bmedian);
+	  return;
+     }
 
      sprintf_time(s.min, bmin, 64);
      sprintf_time(s.max, bmax, 64);
@@ -124,14 +176,23 @@ void report_verbose(const bench_problem *p, double *t, int st)
      sprintf_time(time_min, btmin, 64);
      sprintf_time(p->setup_time, bsetup, 64);
 
-     ovtpvt("Problem: %s, setup: %s, time: %s, %s: %.5g\n",
-	    p->pstring, bsetup, bmin, 
-	    copyp ? "fp-move/us" : "``mflops''",
-	    mflops(p, s.min));
+     if (speed_cache_mode != CACHE_WARM)
+	  ovtpvt("Problem: %s, cache: %s, setup: %s, time: %s, %s: %.5g%s%s\n",
+		 p->pstring, cache_mode_name(speed_cache_mode), bsetup, bmin,
+		 copyp ? "fp-move/us" : "``mflops''",
+		 mflops(p, s.min), bmem, bstream);
+     else
+	  ovtpvt("Problem: %s, setup: %s, time: %s, %s: %.5g%s%s\n",
+		 p->pstring, bsetup, bmin, 
+		 copyp ? "fp-move/us" : "``mflops''",
+		 mflops(p, s.min), bmem, bstream);
 
      if (verbose) {
 	  ovtpvt("Took %d measurements for at least %s each.\n", st, btmin);
 	  ovtpvt("Time: min %s, max %s, avg %s, median %s\n",
 		 bmin, bmax, bavg, bmedian);
      }
+
+     if (verbose > 1 && p->nsetup_stages)
+	  report_setup_stages(p);
 }
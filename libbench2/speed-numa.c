@@ -0,0 +1,171 @@
+/* speed of plans placed on one NUMA node and executed on another */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int bench_numa = 0;
+int bench_plan_node = -1;
+
+#define MAX_NUMA_NODES 64
+
+enum { NUMA_ALLOC, NUMA_PLAN, NUMA_TIME, NUMA_DONE };
+
+struct numa_step {
+     bench_problem *p;
+     int step;
+     int cpu;       /* cpu the step runs on */
+     int node;      /* node of the plan, for NUMA_PLAN */
+     int iter;
+     double t;      /* fastest of time_repeat runs of iter transforms */
+};
+
+/* First cpu of every NUMA node that has some, from sysfs.  Returns
+   the number of nodes found, 0 if the system does not tell. */
+static int numa_nodes(int *node, int *cpu)
+{
+     int n = 0;
+#ifdef __linux__
+     int i;
+
+     for (i = 0; i < MAX_NUMA_NODES; ++i) {
+	  char path[64];
+	  FILE *f;
+	  int c;
+
+	  sprintf(path, "/sys/devices/system/node/node%d/cpulist", i);
+	  f = fopen(path, "r");
+	  if (!f)
+	       continue;
+	  /* memory-only nodes have an empty list */
+	  if (fscanf(f, "%d", &c) == 1) {
+	       node[n] = i;
+	       cpu[n] = c;
+	       ++n;
+	  }
+	  fclose(f);
+     }
+#else
+     UNUSED(node);
+     UNUSED(cpu);
+#endif
+     return n;
+}
+
+static void numa_thread(int tid, void *arg)
+{
+     struct numa_step *s = (struct numa_step *) arg;
+     bench_problem *p = s->p;
+     double t0, y;
+     int k;
+
+     UNUSED(tid);
+     if (!bench_pin_cpu(s->cpu))
+	  ovtpvt_err("bench: cannot run on cpu %d\n", s->cpu);
+
+     switch (s->step) {
+	 case NUMA_ALLOC:
+	      /* first touched here, so local to the executing node */
+	      problem_alloc(p);
+	      problem_zero(p);
+	      break;
+
+	 case NUMA_PLAN:
+	      bench_plan_node = s->node;
+	      setup(p);
+	      bench_plan_node = -1;
+	      break;
+
+	 case NUMA_TIME:
+	      for (s->iter = 1; s->iter < (1<<30); s->iter *= 2) {
+		   t0 = bench_time();
+		   doit(s->iter, p);
+		   y = bench_cost_postprocess(bench_time() - t0);
+		   if (y >= time_min)
+			break;
+	      }
+	      s->t = y;
+	      for (k = 1; k < time_repeat; ++k) {
+		   t0 = bench_time();
+		   doit(s->iter, p);
+		   y = bench_cost_postprocess(bench_time() - t0);
+		   if (y < s->t)
+			s->t = y;
+	      }
+	      break;
+
+	 case NUMA_DONE:
+	      done(p);
+	      break;
+     }
+}
+
+static void numa_run(struct numa_step *s, int step, int cpu)
+{
+     s->step = step;
+     s->cpu = cpu;
+     bench_run_threads(1, numa_thread, s);
+}
+
+void speed_numa(const char *param)
+{
+     int node[MAX_NUMA_NODES], cpu[MAX_NUMA_NODES];
+     int nnodes, e, q, nlocal = 0, nremote = 0;
+     double local = 0.0, remote = 0.0;
+     struct numa_step s;
+
+     nnodes = numa_nodes(node, cpu);
+     if (nnodes == 0 || !bench_threads_supported()) {
+	  ovtpvt_err("bench: NUMA nodes are unknown, running --speed\n");
+	  speed(param, 0);
+	  return;
+     }
+     if (nnodes == 1)
+	  ovtpvt_err("bench: only one NUMA node, "
+		     "remote placement cannot be measured\n");
+
+     /* the arrays stay on the executing node, only the plan moves */
+     for (e = 0; e < nnodes; ++e) {
+	  s.p = problem_parse(param);
+	  BENCH_ASSERT(can_do(s.p));
+	  numa_run(&s, NUMA_ALLOC, cpu[e]);
+
+	  for (q = 0; q < nnodes; ++q) {
+	       double t;
+
+	       s.node = node[q];
+	       numa_run(&s, NUMA_PLAN, cpu[q]);
+	       numa_run(&s, NUMA_TIME, cpu[e]);
+	       numa_run(&s, NUMA_DONE, cpu[e]);
+
+	       t = s.t / s.iter;
+	       if (q == e) {
+		    local += t;
+		    ++nlocal;
+	       } else {
+		    remote += t;
+		    ++nremote;
+	       }
+
+	       if (report == report_benchmark)
+		    ovtpvt("%d %d %.5g %.5g\n", node[q], node[e], t,
+			   mflops(s.p, t));
+	       else
+		    ovtpvt("Problem: %s, plan on node %d, run on node %d "
+			   "(%s), time: %.5g us, ``mflops'': %.5g\n",
+			   s.p->pstring, node[q], node[e],
+			   q == e ? "local" : "remote", t * 1e6,
+			   mflops(s.p, t));
+	  }
+
+	  problem_destroy(s.p);
+     }
+
+     if (nremote > 0 && report != report_benchmark) {
+	  local /= nlocal;
+	  remote /= nremote;
+	  ovtpvt("Average time: local %.5g us, remote %.5g us, "
+		 "remote/local %.3f\n", local * 1e6, remote * 1e6,
+		 remote / local);
+     }
+}
@@ -0,0 +1,146 @@
+/* aggregate throughput of independent plans running on several threads */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int bench_nthreads = 1;
+
+struct throughput {
+     const char *param;
+     int nthreads;
+     int iter;
+     double *t;              /* t[tid * time_repeat + k] */
+     double *setup_time;
+     bench_problem *p0;      /* problem of thread 0, for reporting */
+     struct bench_barrier *barrier;
+};
+
+/* number of iterations that take at least time_min on one thread */
+static int calibrate_iter(bench_problem *p)
+{
+     int iter;
+     double t0, y;
+
+     for (iter = 1; iter < (1<<30); iter *= 2) {
+	  t0 = bench_time();
+	  doit(iter, p);
+	  y = bench_cost_postprocess(bench_time() - t0);
+	  if (y >= time_min)
+	       break;
+     }
+     return iter;
+}
+
+static void throughput_thread(int tid, void *arg)
+{
+     struct throughput *s = (struct throughput *) arg;
+     bench_problem *p;
+     double t0;
+     int k;
+
+     if (bench_pin_threads)
+	  bench_pin_thread(tid);
+
+     /* the arrays are allocated and first touched by the (pinned)
+	thread that uses them, so they are local to its NUMA node */
+     p = problem_parse(s->param);
+     BENCH_ASSERT(can_do(p));
+     problem_alloc(p);
+     problem_zero(p);
+
+     /* planners are not required to be thread-safe */
+     bench_lock();
+     t0 = bench_time();
+     setup(p);
+     s->setup_time[tid] = bench_cost_postprocess(bench_time() - t0);
+     bench_unlock();
+     problem_zero(p);
+
+     bench_barrier_wait(s->barrier);
+     if (tid == 0) {
+	  s->iter = calibrate_iter(p);
+	  s->p0 = p;
+     }
+     bench_barrier_wait(s->barrier);
+
+     for (k = 0; k < time_repeat; ++k) {
+	  bench_barrier_wait(s->barrier);
+	  t0 = bench_time();
+	  doit(s->iter, p);
+	  s->t[tid * time_repeat + k] =
+	       bench_cost_postprocess(bench_time() - t0);
+     }
+
+     /* thread 0 still needs its problem for the report */
+     bench_barrier_wait(s->barrier);
+     bench_lock();
+     done(p);
+     bench_unlock();
+     if (tid != 0)
+	  problem_destroy(p);
+}
+
+void speed_threads(const char *param, int nthreads)
+{
+     struct throughput s;
+     double agg = 0.0, tmin, tmax, rmin = 1.0e300, rmax = 0.0, ravg = 0.0;
+     int tid, k;
+
+     if (!bench_threads_supported() && nthreads > 1) {
+	  ovtpvt_err("bench: threads are not supported in this build\n");
+	  nthreads = 1;
+     }
+
+     s.param = param;
+     s.nthreads = nthreads;
+     s.iter = 0;
+     s.p0 = 0;
+     s.t = (double *) bench_malloc(nthreads * time_repeat * sizeof(double));
+     s.setup_time = (double *) bench_malloc(nthreads * sizeof(double));
+     s.barrier = bench_barrier_create(nthreads);
+
+     bench_run_threads(nthreads, throughput_thread, &s);
+
+     /* aggregate rate of each repetition is bounded by its slowest thread */
+     for (k = 0; k < time_repeat; ++k) {
+	  tmax = 0.0;
+	  for (tid = 0; tid < nthreads; ++tid)
+	       if (s.t[tid * time_repeat + k] > tmax)
+		    tmax = s.t[tid * time_repeat + k];
+	  if (tmax > 0.0 && nthreads * (double) s.iter / tmax > agg)
+	       agg = nthreads * (double) s.iter / tmax;
+     }
+
+     for (tid = 0; tid < nthreads; ++tid) {
+	  double r;
+
+	  tmin = 1.0e300;
+	  for (k = 0; k < time_repeat; ++k)
+	       if (s.t[tid * time_repeat + k] < tmin)
+		    tmin = s.t[tid * time_repeat + k];
+	  r = s.iter / tmin;
+	  if (r < rmin) rmin = r;
+	  if (r > rmax) rmax = r;
+	  ravg += r;
+
+	  if (verbose)
+	       ovtpvt("Thread %d: %.5g transforms/s, setup: %g s\n",
+		      tid, r, s.setup_time[tid]);
+     }
+     ravg /= nthreads;
+
+     if (report == report_benchmark)
+	  ovtpvt("%.5g %.5g %.5g %.5g %.5g\n", agg, mflops(s.p0, 1.0 / agg),
+		 rmin, ravg, rmax);
+     else
+	  ovtpvt("Problem: %s, threads: %d, aggregate: %.5g transforms/s, "
+		 "``mflops'': %.5g, per thread: min %.5g, avg %.5g, max %.5g\n",
+		 s.p0->pstring, nthreads, agg, mflops(s.p0, 1.0 / agg),
+		 rmin, ravg, rmax);
+
+     problem_destroy(s.p0);
+     bench_barrier_destroy(s.barrier);
+     bench_free(s.setup_time);
+     bench_free(s.t);
+}
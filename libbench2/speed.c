@@ -22,13 +22,105 @@
 #include "bench.h"
 
 int no_speed_allocation = 0; /* 1 to not allocate array data in speed() */
+int speed_cache_mode = CACHE_WARM; /* cache mode of the current measurement */
+int speed_setup_only = 0; /* 1 while reporting a setup-only measurement */
+
+static double time_iter(int iter, bench_problem *p, int mode,
+			struct cache_pool *pool)
+{
+     double y = 0.0;
+     int i;
+
+     switch (mode) {
+	 case CACHE_ROTATE:
+	      timer_start(LIBBENCH_TIMER);
+	      for (i = 0; i < iter; ++i) {
+		   cache_pool_next(pool, p);
+		   doit(1, p);
+	      }
+	      y = timer_stop(LIBBENCH_TIMER);
+	      cache_pool_restore(pool, p);
+	      break;
+
+	 case CACHE_FLUSH:
+	      /* only the transforms are timed, not the flushes */
+	      for (i = 0; i < iter; ++i) {
+		   cache_flush(p);
+		   timer_start(LIBBENCH_TIMER);
+		   doit(1, p);
+		   y += timer_stop(LIBBENCH_TIMER);
+	      }
+	      break;
+
+	 default:
+	      timer_start(LIBBENCH_TIMER);
+	      doit(iter, p);
+	      y = timer_stop(LIBBENCH_TIMER);
+	      break;
+     }
+
+     return bench_cost_postprocess(y);
+}
+
+static int measure(bench_problem *p, double *t, int mode,
+		   struct cache_pool *pool)
+{
+     int iter, k;
+     double tmin, y;
+
+ start_over:
+     for (iter = 1; iter < (1<<30); iter *= 2) {
+	  tmin = 1.0e20;
+	  for (k = 0; k < time_repeat; ++k) {
+	       y = time_iter(iter, p, mode, pool);
+	       if (y < 0) /* yes, it happens */
+		    goto start_over;
+	       t[k] = y;
+	       if (y < tmin)
+		    tmin = y;
+	  }
+	  
+	  if (tmin >= time_min)
+	       return iter;
+     }
+
+     goto start_over; /* this also happens */
+}
+
+/* Create and destroy the plan time_repeat times, storing the time of
+   each creation in t[].  The stage breakdown left in p is the one of
+   the fastest creation, so that it adds up to p->setup_time. */
+static void measure_setup(bench_problem *p, double *t)
+{
+     double stage[BENCH_MAX_SETUP_STAGES];
+     int i, k, nstages = 0;
+
+     for (k = 0; k < time_repeat; ++k) {
+	  if (k)
+	       done(p);
+	  p->nsetup_stages = 0;
+	  timer_start(LIBBENCH_TIMER);
+	  setup(p);
+	  t[k] = bench_cost_postprocess(timer_stop(LIBBENCH_TIMER));
+	  if (k == 0 || t[k] < p->setup_time) {
+	       p->setup_time = t[k];
+	       nstages = p->nsetup_stages;
+	       for (i = 0; i < nstages; ++i)
+		    stage[i] = p->setup_stage_time[i];
+	  }
+     }
+
+     p->nsetup_stages = nstages;
+     for (i = 0; i < nstages; ++i)
+	  p->setup_stage_time[i] = stage[i];
+}
 
 void speed(const char *param, int setup_only)
 {
      double *t;
-     int iter = 0, k;
+     int iter, k, mode, first, last;
      bench_problem *p;
-     double tmin, y;
+     struct cache_pool *pool = 0;
 
      t = (double *) bench_malloc(time_repeat * sizeof(double));
 
@@ -42,6 +134,17 @@ void speed(const char *param, int setup_only)
 	  problem_zero(p);
      }
 
+     if (setup_only) {
+	  measure_setup(p, t);
+	  done(p);
+	  speed_cache_mode = CACHE_WARM;
+	  speed_setup_only = 1;
+	  compare_record(p, t, time_repeat);
+	  report(p, t, time_repeat);
+	  speed_setup_only = 0;
+	  goto out;
+     }
+
      timer_start(LIBBENCH_TIMER);
      setup(p);
      p->setup_time = bench_cost_postprocess(timer_stop(LIBBENCH_TIMER));
@@ -51,42 +154,33 @@ void speed(const char *param, int setup_only)
 	diverge. */
      if (!no_speed_allocation) 
 	  problem_zero(p);
-     
-     if (setup_only)
-	  goto done;
 
- start_over:
-     for (iter = 1; iter < (1<<30); iter *= 2) {
-	  tmin = 1.0e20;
-	  for (k = 0; k < time_repeat; ++k) {
-	       timer_start(LIBBENCH_TIMER);
-	       doit(iter, p);
-	       y = bench_cost_postprocess(timer_stop(LIBBENCH_TIMER));
-	       if (y < 0) /* yes, it happens */
-		    goto start_over;
-	       t[k] = y;
-	       if (y < tmin)
-		    tmin = y;
-	  }
-	  
-	  if (tmin >= time_min)
-	       goto done;
+     /* the cold-cache modes need the problem arrays */
+     first = last = no_speed_allocation ? CACHE_WARM : cache_mode;
+     if (cache_mode == CACHE_ALL) {
+	  first = CACHE_WARM;
+	  last = CACHE_FLUSH;
      }
 
-     goto start_over; /* this also happens */
+     if (!no_speed_allocation && (first <= CACHE_ROTATE && last >= CACHE_ROTATE))
+	  pool = cache_pool_create(p);
 
- done:
-     done(p);
+     for (mode = first; mode <= last; ++mode) {
+	  iter = measure(p, t, mode, pool);
 
-     if (iter) 
 	  for (k = 0; k < time_repeat; ++k) 
 	       t[k] /= iter;
-     else
-	  for (k = 0; k < time_repeat; ++k) 
-	       t[k] = 0;
 
-     report(p, t, time_repeat);
+	  speed_cache_mode = mode;
+	  compare_record(p, t, time_repeat);
+	  report(p, t, time_repeat);
+     }
+     speed_cache_mode = CACHE_WARM;
+
+     done(p);
+     cache_pool_destroy(pool);
 
+ out:
      if (!no_speed_allocation)
 	  problem_destroy(p);
      bench_free(t);
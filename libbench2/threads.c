@@ -0,0 +1,329 @@
+/* minimal portable threads, mutex and barrier for the benchmark */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for pthread_setaffinity_np */
+#endif
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32) && !defined(HAVE_PTHREAD)
+#include <windows.h>
+#define USE_WIN32_THREADS 1
+#elif defined(HAVE_PTHREAD)
+#include <pthread.h>
+#ifdef HAVE_SCHED_GETAFFINITY
+#include <sched.h>
+#endif
+#endif
+
+int bench_pin_threads = 0;
+
+struct thread_arg {
+     int tid;
+     bench_thread_fn f;
+     void *arg;
+};
+
+#if defined(USE_WIN32_THREADS)
+static SRWLOCK lock = SRWLOCK_INIT;
+
+void bench_lock(void)
+{
+     AcquireSRWLockExclusive(&lock);
+}
+
+void bench_unlock(void)
+{
+     ReleaseSRWLockExclusive(&lock);
+}
+
+struct bench_barrier {
+     SRWLOCK m;
+     CONDITION_VARIABLE c;
+     int n, count, phase;
+};
+
+struct bench_barrier *bench_barrier_create(int n)
+{
+     struct bench_barrier *b;
+
+     b = (struct bench_barrier *) bench_malloc(sizeof(struct bench_barrier));
+     InitializeSRWLock(&b->m);
+     InitializeConditionVariable(&b->c);
+     b->n = n;
+     b->count = 0;
+     b->phase = 0;
+     return b;
+}
+
+void bench_barrier_wait(struct bench_barrier *b)
+{
+     int phase;
+
+     AcquireSRWLockExclusive(&b->m);
+     phase = b->phase;
+     if (++b->count == b->n) {
+	  b->count = 0;
+	  ++b->phase;
+	  WakeAllConditionVariable(&b->c);
+     } else {
+	  while (phase == b->phase)
+	       SleepConditionVariableSRW(&b->c, &b->m, INFINITE, 0);
+     }
+     ReleaseSRWLockExclusive(&b->m);
+}
+
+void bench_barrier_destroy(struct bench_barrier *b)
+{
+     bench_free(b);
+}
+
+static DWORD WINAPI thread_main(LPVOID p)
+{
+     struct thread_arg *a = (struct thread_arg *) p;
+     a->f(a->tid, a->arg);
+     return 0;
+}
+
+int bench_threads_supported(void)
+{
+     return 1;
+}
+
+void bench_pin_thread(int tid)
+{
+     DWORD_PTR mask, sysmask;
+     int cpu = 0, i;
+
+     if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &sysmask)
+	 || !mask)
+	  return;
+
+     /* pick the tid-th cpu of the process, wrapping around */
+     for (i = 0; ; i = (i + 1) % (int) (8 * sizeof(mask))) {
+	  if (mask & ((DWORD_PTR) 1 << i)) {
+	       if (cpu++ == tid) {
+		    SetThreadAffinityMask(GetCurrentThread(),
+					  (DWORD_PTR) 1 << i);
+		    return;
+	       }
+	  }
+     }
+}
+
+int bench_pin_cpu(int cpu)
+{
+     if (cpu < 0 || cpu >= (int) (8 * sizeof(DWORD_PTR)))
+	  return 0;
+     return SetThreadAffinityMask(GetCurrentThread(),
+				  (DWORD_PTR) 1 << cpu) != 0;
+}
+
+void bench_run_threads(int n, bench_thread_fn f, void *arg)
+{
+     HANDLE *h;
+     struct thread_arg *a;
+     int i;
+
+     h = (HANDLE *) bench_malloc(n * sizeof(HANDLE));
+     a = (struct thread_arg *) bench_malloc(n * sizeof(struct thread_arg));
+
+     for (i = 0; i < n; ++i) {
+	  a[i].tid = i;
+	  a[i].f = f;
+	  a[i].arg = arg;
+	  h[i] = CreateThread(0, 0, thread_main, a + i, 0, 0);
+	  BENCH_ASSERT(h[i]);
+     }
+     for (i = 0; i < n; ++i) {
+	  WaitForSingleObject(h[i], INFINITE);
+	  CloseHandle(h[i]);
+     }
+
+     bench_free(a);
+     bench_free(h);
+}
+
+#elif defined(HAVE_PTHREAD)
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void bench_lock(void)
+{
+     pthread_mutex_lock(&lock);
+}
+
+void bench_unlock(void)
+{
+     pthread_mutex_unlock(&lock);
+}
+
+/* pthread_barrier_t is optional in POSIX (and absent on macOS) */
+struct bench_barrier {
+     pthread_mutex_t m;
+     pthread_cond_t c;
+     int n, count, phase;
+};
+
+struct bench_barrier *bench_barrier_create(int n)
+{
+     struct bench_barrier *b;
+
+     b = (struct bench_barrier *) bench_malloc(sizeof(struct bench_barrier));
+     pthread_mutex_init(&b->m, 0);
+     pthread_cond_init(&b->c, 0);
+     b->n = n;
+     b->count = 0;
+     b->phase = 0;
+     return b;
+}
+
+void bench_barrier_wait(struct bench_barrier *b)
+{
+     int phase;
+
+     pthread_mutex_lock(&b->m);
+     phase = b->phase;
+     if (++b->count == b->n) {
+	  b->count = 0;
+	  ++b->phase;
+	  pthread_cond_broadcast(&b->c);
+     } else {
+	  while (phase == b->phase)
+	       pthread_cond_wait(&b->c, &b->m);
+     }
+     pthread_mutex_unlock(&b->m);
+}
+
+void bench_barrier_destroy(struct bench_barrier *b)
+{
+     pthread_cond_destroy(&b->c);
+     pthread_mutex_destroy(&b->m);
+     bench_free(b);
+}
+
+static void *thread_main(void *p)
+{
+     struct thread_arg *a = (struct thread_arg *) p;
+     a->f(a->tid, a->arg);
+     return 0;
+}
+
+int bench_threads_supported(void)
+{
+     return 1;
+}
+
+void bench_pin_thread(int tid)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(HAVE_SCHED_GETAFFINITY)
+     cpu_set_t allowed, set;
+     int cpu, i, ncpu;
+
+     if (sched_getaffinity(0, sizeof(allowed), &allowed))
+	  return;
+     ncpu = CPU_COUNT(&allowed);
+     if (ncpu <= 0)
+	  return;
+
+     /* pick the tid-th cpu of the process, wrapping around */
+     tid %= ncpu;
+     for (cpu = i = 0; cpu < CPU_SETSIZE; ++cpu) {
+	  if (CPU_ISSET(cpu, &allowed) && i++ == tid) {
+	       CPU_ZERO(&set);
+	       CPU_SET(cpu, &set);
+	       pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	       return;
+	  }
+     }
+#else
+     UNUSED(tid);
+#endif
+}
+
+int bench_pin_cpu(int cpu)
+{
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(HAVE_SCHED_GETAFFINITY)
+     cpu_set_t set;
+
+     if (cpu < 0 || cpu >= CPU_SETSIZE)
+	  return 0;
+     CPU_ZERO(&set);
+     CPU_SET(cpu, &set);
+     return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+     UNUSED(cpu);
+     return 0;
+#endif
+}
+
+void bench_run_threads(int n, bench_thread_fn f, void *arg)
+{
+     pthread_t *h;
+     struct thread_arg *a;
+     int i;
+
+     h = (pthread_t *) bench_malloc(n * sizeof(pthread_t));
+     a = (struct thread_arg *) bench_malloc(n * sizeof(struct thread_arg));
+
+     for (i = 0; i < n; ++i) {
+	  a[i].tid = i;
+	  a[i].f = f;
+	  a[i].arg = arg;
+	  BENCH_ASSERT(!pthread_create(h + i, 0, thread_main, a + i));
+     }
+     for (i = 0; i < n; ++i)
+	  pthread_join(h[i], 0);
+
+     bench_free(a);
+     bench_free(h);
+}
+
+#else /* no threads: run everything in the calling thread */
+void bench_lock(void)
+{
+}
+
+void bench_unlock(void)
+{
+}
+
+struct bench_barrier *bench_barrier_create(int n)
+{
+     UNUSED(n);
+     return 0;
+}
+
+void bench_barrier_wait(struct bench_barrier *b)
+{
+     UNUSED(b);
+}
+
+void bench_barrier_destroy(struct bench_barrier *b)
+{
+     UNUSED(b);
+}
+
+int bench_threads_supported(void)
+{
+     return 0;
+}
+
+void bench_pin_thread(int tid)
+{
+     UNUSED(tid);
+}
+
+int bench_pin_cpu(int cpu)
+{
+     UNUSED(cpu);
+     return 0;
+}
+
+void bench_run_threads(int n, bench_thread_fn f, void *arg)
+{
+     BENCH_ASSERT(n == 1);
+     f(0, arg);
+}
+#endif
@@ -66,6 +66,28 @@ static double elapsed(mytime t1, mytime t0)
 #endif
 
 
+#if defined(HAVE_CLOCK_GETTIME) && !defined(HAVE_TIMER)
+#include <time.h>
+#ifdef CLOCK_MONOTONIC
+typedef struct timespec mytime;
+
+static mytime get_time(void)
+{
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return ts;
+}
+
+static double elapsed(mytime t1, mytime t0)
+{
+     return ((double) t1.tv_sec - (double) t0.tv_sec) +
+	  ((double) t1.tv_nsec - (double) t0.tv_nsec) * 1.0E-9;
+}
+
+#define HAVE_TIMER
+#endif
+#endif
+
 #if defined(HAVE_GETTIMEOFDAY) && !defined(HAVE_TIMER)
 typedef struct timeval mytime;
 
@@ -132,3 +154,11 @@ double timer_stop(int n)
      return elapsed(t1, t0[n]);
 }
 
+/* seconds since an arbitrary origin; unlike timer_start()/timer_stop()
+   this is safe to call from several threads */
+double bench_time(void)
+{
+     static mytime origin; /* all zeros */
+     return elapsed(get_time(), origin);
+}
+
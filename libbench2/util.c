@@ -42,6 +42,8 @@ void bench_assertion_failed(const char *s, int line, const char *file)
      bench_exit(EXIT_FAILURE);
 }
 
+int bench_random_seed = 0; /* last seed passed to bench_srand() */
+
 #ifdef HAVE_DRAND48
 #  if defined(HAVE_DECL_DRAND48) && !HAVE_DECL_DRAND48
 extern double drand48(void);
@@ -55,6 +57,7 @@ extern void srand48(long);
 #  endif
 void bench_srand(int seed)
 {
+     bench_random_seed = seed;
      srand48(seed);
 }
 #else
@@ -65,6 +68,7 @@ double bench_drand(void)
 }
 void bench_srand(int seed)
 {
+     bench_random_seed = seed;
      srand(seed);
 }
 #endif
@@ -100,7 +100,8 @@ static void dft_apply(dofft_closure *k_, bench_complex *in, bench_complex *out)
      tensor_destroy(pckdsz_swap);
 }
 
-void verify_dft(bench_problem *p, int rounds, double tol, errors *e)
+void verify_dft_tests(bench_problem *p, int tests, int rounds, double tol,
+		      errors *e)
 {
      C *inA, *inB, *inC, *outA, *outB, *outC, *tmp;
      int n, vecn, N;
@@ -127,20 +128,25 @@ void verify_dft(bench_problem *p, int rounds, double tol, errors *e)
      outC = (C *) bench_malloc(N * sizeof(C));
      tmp = (C *) bench_malloc(N * sizeof(C));
 
-     e->i = impulse(&k.k, n, vecn, inA, inB, inC, outA, outB, outC, 
-		    tmp, rounds, tol);
-     e->l = linear(&k.k, 0, N, inA, inB, inC, outA, outB, outC,
-		   tmp, rounds, tol);
-
-     e->s = 0.0;
-     e->s = dmax(e->s, tf_shift(&k.k, 0, p->sz, n, vecn, p->sign,
-				inA, inB, outA, outB, 
-				tmp, rounds, tol, TIME_SHIFT));
-     e->s = dmax(e->s, tf_shift(&k.k, 0, p->sz, n, vecn, p->sign,
-				inA, inB, outA, outB, 
-				tmp, rounds, tol, FREQ_SHIFT));
-
-     if (!p->in_place && !p->destroy_input)
+     e->i = e->l = e->s = 0.0;
+
+     if (tests & VERIFY_IMPULSE)
+	  e->i = impulse(&k.k, n, vecn, inA, inB, inC, outA, outB, outC, 
+			 tmp, rounds, tol);
+     if (tests & VERIFY_LINEAR)
+	  e->l = linear(&k.k, 0, N, inA, inB, inC, outA, outB, outC,
+			tmp, rounds, tol);
+
+     if (tests & VERIFY_TIME_SHIFT)
+	  e->s = dmax(e->s, tf_shift(&k.k, 0, p->sz, n, vecn, p->sign,
+				     inA, inB, outA, outB, 
+				     tmp, rounds, tol, TIME_SHIFT));
+     if (tests & VERIFY_FREQ_SHIFT)
+	  e->s = dmax(e->s, tf_shift(&k.k, 0, p->sz, n, vecn, p->sign,
+				     inA, inB, outA, outB, 
+				     tmp, rounds, tol, FREQ_SHIFT));
+
+     if ((tests & VERIFY_PRESERVES_INPUT) && !p->in_place && !p->destroy_input)
 	  preserves_input(&k.k, 0, N, inA, inB, outB, rounds);
 
      bench_free(tmp);
@@ -152,6 +158,10 @@ void verify_dft(bench_problem *p, int rounds, double tol, errors *e)
      bench_free(inA);
 }
 
+void verify_dft(bench_problem *p, int rounds, double tol, errors *e)
+{
+     verify_dft_tests(p, VERIFY_ALL, rounds, tol, e);
+}
 
 void accuracy_dft(bench_problem *p, int rounds, int impulse_rounds,
 		  double t[6])
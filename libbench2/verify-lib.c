@@ -61,18 +61,40 @@ static double aerror(C *a, C *b, int n)
 #  if defined(HAVE_DECL_DRAND48) && !HAVE_DECL_DRAND48
 extern double drand48(void);
 #  endif
-double mydrand(void)
+static double sys_drand(void)
 {
      return drand48() - 0.5;
 }
 #else
-double mydrand(void)
+static double sys_drand(void)
 {
      double d = rand();
      return (d / (double) RAND_MAX) - 0.5;
 }
 #endif
 
+/* Threads of the parallel verifier each use their own generator, the
+   drand48 recurrence on a thread-local state, so that the inputs of a
+   test depend only on its seed and not on the scheduling. */
+static VERIFY_THREAD_LOCAL int rng_active = 0;
+static VERIFY_THREAD_LOCAL unsigned long long rng_state;
+
+void verify_srand(int seed)
+{
+     rng_state = ((unsigned long long) (unsigned) seed << 16) | 0x330E;
+     rng_active = 1;
+}
+
+double mydrand(void)
+{
+     if (rng_active) {
+	  rng_state = (rng_state * 0x5DEECE66DULL + 0xB) &
+	       ((1ULL << 48) - 1);
+	  return rng_state / 281474976710656.0 /* 2^48 */ - 0.5;
+     }
+     return sys_drand();
+}
+
 void arand(C *a, int n)
 {
      int i;
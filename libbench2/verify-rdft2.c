@@ -224,7 +224,8 @@ static void rdft2_apply(dofft_closure *k_,
      tensor_destroy(pckdsz2_swap);
 }
 
-void verify_rdft2(bench_problem *p, int rounds, double tol, errors *e)
+void verify_rdft2_tests(bench_problem *p, int tests, int rounds, double tol,
+			errors *e)
 {
      C *inA, *inB, *inC, *outA, *outB, *outC, *tmp;
      int n, vecn, N;
@@ -254,22 +255,26 @@ void verify_rdft2(bench_problem *p, int rounds, double tol, errors *e)
      outC = (C *) bench_malloc(N * sizeof(C));
      tmp = (C *) bench_malloc(N * sizeof(C));
 
-     e->i = impulse(&k.k, n, vecn, inA, inB, inC, outA, outB, outC, 
-		    tmp, rounds, tol);
-     e->l = linear(&k.k, 1, N, inA, inB, inC, outA, outB, outC,
-		   tmp, rounds, tol);
+     e->i = e->l = e->s = 0.0;
+
+     if (tests & VERIFY_IMPULSE)
+	  e->i = impulse(&k.k, n, vecn, inA, inB, inC, outA, outB, outC, 
+			 tmp, rounds, tol);
+     if (tests & VERIFY_LINEAR)
+	  e->l = linear(&k.k, 1, N, inA, inB, inC, outA, outB, outC,
+			tmp, rounds, tol);
 
-     e->s = 0.0;
-     if (p->sign < 0)
+     /* only one of the shift tests applies to real transforms */
+     if (p->sign < 0 && (tests & VERIFY_TIME_SHIFT))
 	  e->s = dmax(e->s, tf_shift(&k.k, 1, p->sz, n, vecn, p->sign,
 				     inA, inB, outA, outB, 
 				     tmp, rounds, tol, TIME_SHIFT));
-     else
+     else if (p->sign > 0 && (tests & VERIFY_FREQ_SHIFT))
 	  e->s = dmax(e->s, tf_shift(&k.k, 1, p->sz, n, vecn, p->sign,
 				     inA, inB, outA, outB, 
 				     tmp, rounds, tol, FREQ_SHIFT));
      
-     if (!p->in_place && !p->destroy_input)
+     if ((tests & VERIFY_PRESERVES_INPUT) && !p->in_place && !p->destroy_input)
 	  preserves_input(&k.k, p->sign < 0 ? mkreal : mkhermitian1,
 			  N, inA, inB, outB, rounds);
 
@@ -281,6 +286,10 @@ void verify_rdft2(bench_problem *p, int rounds, double tol, errors *e)
      bench_free(inB);
      bench_free(inA);
 }
+void verify_rdft2(bench_problem *p, int rounds, double tol, errors *e)
+{
+     verify_rdft2_tests(p, VERIFY_ALL, rounds, tol, e);
+}
 
 void accuracy_rdft2(bench_problem *p, int rounds, int impulse_rounds,
 		    double t[6])
@@ -0,0 +1,138 @@
+/* verification rounds and tests spread over several threads */
+
+#include "verify.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int test_kinds[] = {
+     VERIFY_IMPULSE, VERIFY_LINEAR, VERIFY_TIME_SHIFT, VERIFY_FREQ_SHIFT,
+     VERIFY_PRESERVES_INPUT
+};
+#define NTEST_KINDS ((int) (sizeof(test_kinds) / sizeof(test_kinds[0])))
+
+struct verify_job {
+     int tests;
+     int rounds;
+     int seed;
+     errors e;
+};
+
+struct verification {
+     const char *param;
+     double tol;
+     struct verify_job *jobs;
+     int njobs;
+     int next; /* next job to hand out, protected by bench_lock() */
+};
+
+static void verify_thread(int tid, void *arg)
+{
+     struct verification *s = (struct verification *) arg;
+     bench_problem *p;
+     int j;
+
+     /* tid is -1 when the calling thread runs the jobs itself */
+     if (bench_pin_threads && tid >= 0)
+	  bench_pin_thread(tid);
+
+     /* every thread has its own arrays and plan */
+     p = problem_parse(s->param);
+     problem_alloc(p);
+     problem_zero(p);
+
+     bench_lock();
+     setup(p);
+     bench_unlock();
+
+     for (;;) {
+	  struct verify_job *job;
+
+	  bench_lock();
+	  j = s->next++;
+	  bench_unlock();
+	  if (j >= s->njobs)
+	       break;
+
+	  job = s->jobs + j;
+	  verify_srand(job->seed);
+	  if (p->kind == PROBLEM_COMPLEX)
+	       verify_dft_tests(p, job->tests, job->rounds, s->tol, &job->e);
+	  else
+	       verify_rdft2_tests(p, job->tests, job->rounds, s->tol, &job->e);
+     }
+
+     bench_lock();
+     done(p);
+     bench_unlock();
+     problem_destroy(p);
+}
+
+void verify_threads(const char *param, int rounds, double tol, int nthreads)
+{
+     struct verification s;
+     bench_problem *p;
+     errors e;
+     int kind, kind_ok, r, j;
+
+     p = problem_parse(param);
+     if (!can_do(p)) {
+	  ovtpvt_err("No can_do for %s\n", p->pstring);
+	  BENCH_ASSERT(0);
+     }
+     kind_ok = p->kind == PROBLEM_COMPLEX || p->kind == PROBLEM_REAL;
+     problem_destroy(p);
+
+     if (!kind_ok) {
+	  verify(param, rounds, tol);
+	  return;
+     }
+
+#ifndef HAVE_VERIFY_THREAD_LOCAL
+     nthreads = 1; /* mydrand() cannot be made thread-safe */
+#endif
+     if (!bench_threads_supported())
+	  nthreads = 1;
+
+     if (rounds == 0)
+	  rounds = 20;  /* default value, as in verify_dft() */
+
+     /* Each test kind is split into one job per round, whatever the
+	number of threads.  The seed of a job depends only on its index,
+	so the inputs, and the errors, are the same however many threads
+	run the jobs and whichever thread runs each one. */
+     s.param = param;
+     s.tol = tol;
+     s.next = 0;
+     s.njobs = 0;
+     s.jobs = (struct verify_job *)
+	  bench_malloc(NTEST_KINDS * rounds * sizeof(struct verify_job));
+
+     for (kind = 0; kind < NTEST_KINDS; ++kind) {
+	  for (r = 0; r < rounds; ++r) {
+	       struct verify_job *job = s.jobs + s.njobs;
+
+	       job->rounds = 1;
+	       job->tests = test_kinds[kind];
+	       job->seed = bench_random_seed + s.njobs;
+	       ++s.njobs;
+	  }
+     }
+
+     /* one thread runs the same jobs in the calling thread */
+     if (nthreads > 1)
+	  bench_run_threads(nthreads, verify_thread, &s);
+     else
+	  verify_thread(-1, &s);
+
+     e.l = e.i = e.s = 0.0;
+     for (j = 0; j < s.njobs; ++j) {
+	  e.l = dmax(e.l, s.jobs[j].e.l);
+	  e.i = dmax(e.i, s.jobs[j].e.i);
+	  e.s = dmax(e.s, s.jobs[j].e.s);
+     }
+
+     if (verbose)
+	  ovtpvt("%s %g %g %g\n", param, e.l, e.i, e.s);
+
+     bench_free(s.jobs);
+}
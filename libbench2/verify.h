@@ -69,6 +69,33 @@ typedef struct dotens2_closure_s {
 void bench_dotens2(const bench_tensor *sz0, 
 		   const bench_tensor *sz1, dotens2_closure *k);
 
+/* the tests of verify_dft() and verify_rdft2(), as a mask */
+enum {
+     VERIFY_IMPULSE = 1,
+     VERIFY_LINEAR = 2,
+     VERIFY_TIME_SHIFT = 4,
+     VERIFY_FREQ_SHIFT = 8,
+     VERIFY_PRESERVES_INPUT = 16,
+     VERIFY_ALL = 31
+};
+
+void verify_dft_tests(bench_problem *p, int tests, int rounds, double tol,
+		      errors *e);
+void verify_rdft2_tests(bench_problem *p, int tests, int rounds, double tol,
+			errors *e);
+
+/* make mydrand() of the calling thread use its own generator */
+#if defined(_MSC_VER)
+#  define VERIFY_THREAD_LOCAL __declspec(thread)
+#  define HAVE_VERIFY_THREAD_LOCAL 1
+#elif defined(__GNUC__)
+#  define VERIFY_THREAD_LOCAL __thread
+#  define HAVE_VERIFY_THREAD_LOCAL 1
+#else
+#  define VERIFY_THREAD_LOCAL
+#endif
+void verify_srand(int seed);
+
 void accuracy_test(dofft_closure *k, aconstrain constrain,
 		   int sign, int n, C *a, C *b, int rounds, int impulse_rounds,
 		   double t[6]);
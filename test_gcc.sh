@@ -3,3 +3,11 @@
 ./bench_ffts -y ocb2 -y ocb4 -y ocb8 -y ocb16 -y ocb32 -y ocb64 -y ocb128 -y ocb256 -y ocb512 -y ocb1024 -y ocb2048 -y ocb4096 -y ocb8192 -y ocb16384 -y ocb32768 -y ocb65536 -y ocb131072 -y ocb262144 -s ocb2 -s ocb4 -s ocb8 -s ocb16 -s ocb32 -s ocb64 -s ocb128 -s ocb256 -s ocb512 -s ocb1024 -s ocb2048 -s ocb4096 -s ocb8192 -s ocb16384 -s ocb32768 -s ocb65536 -s ocb131072 -s ocb262144
 ./bench_ffts -y orf4 -y orf8 -y orf16 -y orf32 -y orf64 -y orf128 -y orf256 -y orf512 -y orf1024 -y orf2048 -y orf4096 -y orf8192 -y orf16384 -y orf32768 -y orf65536 -y orf131072 -y orf262144 -s orf4 -s orf8 -s orf16 -s orf32 -s orf64 -s orf128 -s orf256 -s orf512 -s orf1024 -s orf2048 -s orf4096 -s orf8192 -s orf16384 -s orf32768 -s orf65536 -s orf131072 -s orf262144
 ./bench_ffts -y orb4 -y orb8 -y orb16 -y orb32 -y orb64 -y orb128 -y orb256 -y orb512 -y orb1024 -y orb2048 -y orb4096 -y orb8192 -y orb16384 -y orb32768 -y orb65536 -y orb131072 -y orb262144 -s orb4 -s orb8 -s orb16 -s orb32 -s orb64 -s orb128 -s orb256 -s orb512 -s orb1024 -s orb2048 -s orb4096 -s orb8192 -s orb16384 -s orb32768 -s orb65536 -s orb131072 -s orb262144
+for p in ocf1024 ocb4096 orf4096 orb1024; do
+  one=$(./bench_ffts --threads=1 -v -y $p)
+  four=$(./bench_ffts --threads=4 -v -y $p)
+  if [ "$one" != "$four" ]; then
+    echo "-y $p: --threads=1 gives $one, --threads=4 gives $four"
+    exit 1
+  fi
+done